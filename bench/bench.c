@@ -0,0 +1,472 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <time.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+#include "../include/nyblog.h"
+#include "../include/nybbin.h"
+#include "../include/session.h"
+#include "../include/diff.h"
+#include "../include/search.h"
+#include "../include/bam.h"
+#include "../include/query.h"
+#include "../include/heatmap.h"
+#include "synth.h"
+
+//	Microbenchmarks of the core's hot paths, run on synthetic disks
+//
+//	Every benchmark prints one JSON object per line to stdout:
+//		{"bench": ..., "variant": ..., "label": ..., "seed": ..., "ops": ...,
+//		 "ns_per_op": ..., "mb_per_s": ..., "disks_per_s": ...}
+//	MB/s counts the bytes of disk or log the operations cover (1 MB = 10^6 B),
+//	and disks/s how many whole disks' worth of operations run every second.
+//	The same seed always gives the same disks, so results can be compared
+//	across commits; `label` is there to tell them apart.
+
+#define BENCH_DEFAULT_SEED 0x1541
+#define BENCH_DEFAULT_MIN_MS 250		// Each benchmark runs at least this long
+#define BENCH_PATH_SIZE 4096
+#define BENCH_MAX_LOG_BLOCKS (NYBLOG_SECTOR_COUNT * 2)
+
+//	A synthetic disk, in every form the benchmarks need it
+typedef struct {
+	const char *variant;
+	uint32_t flags;
+	char disk_filename[BENCH_PATH_SIZE];
+	char recon_filename[BENCH_PATH_SIZE];
+	char log_filename[BENCH_PATH_SIZE];
+	char bin_filename[BENCH_PATH_SIZE];
+	uint8_t *image;				// The imported image, in memory
+	FILE *f_disk;
+	FILE *f_meta;
+	NYB_BinLog bin;				// The log converted to a binary log
+	long log_size;
+	DSK_Directory dir;
+} __bench_disk;
+
+//	What a single run of a benchmark got through
+typedef struct {
+	uint64_t ops;
+	uint64_t bytes;
+	double disks;
+} __bench_work;
+
+typedef void (*__bench_fn)(__bench_disk *disk, __bench_work *work);
+
+typedef struct {
+	const char *name;
+	__bench_fn fn;
+	bool needs_damage;		// Also run on the damaged disk
+} __bench;
+
+// Results go here so the compiler can't leave out the work
+static volatile uint64_t __sink;
+
+static NYB_DataBlock __log_blocks[BENCH_MAX_LOG_BLOCKS];
+static ANA_DiskInfo __analysis;
+static SES_Session __session;		// Reused for every load, like a batch worker would
+static bool __is_session_ready = false;
+static const uint8_t *__reference_image;	// The clean disk, that every disk is compared with
+
+
+void __bench_checksum(__bench_disk *disk, __bench_work *work) {
+	uint64_t sum = 0;
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) sum += DSK_Checksum(disk->image + (size_t) i * BLOCK_SIZE);
+	__sink += sum;
+
+	work->ops += NYBLOG_SECTOR_COUNT;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_position_to_index(__bench_disk *disk, __bench_work *work) {
+	uint64_t sum = 0;
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int secs = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<secs; s++) sum += DSK_PositionToIndex((DSK_Position){ t, s });
+	}
+	__sink += sum;
+
+	work->ops += NYBLOG_SECTOR_COUNT;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_parse_directory(__bench_disk *disk, __bench_work *work) {
+	DSK_Directory dir;
+	DSK_File_ParseDirectory(disk->f_disk, &dir, false);
+	__sink += dir.num_entries;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_parse_log(__bench_disk *disk, __bench_work *work) {
+	int count = NYB_ParseLog(disk->log_filename, __log_blocks, BENCH_MAX_LOG_BLOCKS, NULL);
+	if (count > 0) __sink += count;
+
+	work->ops += (count > 0) ? count : 0;
+	work->bytes += disk->log_size;
+	work->disks += 1.0;
+}
+
+void __bench_meta_read_block(__bench_disk *disk, __bench_work *work) {
+	NYB_DataBlock block;
+	uint64_t sum = 0;
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int secs = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<secs; s++) {
+			block.track_num = t;
+			block.sector_index = s;
+			if (NYB_Meta_ReadBlock(disk->f_meta, &block) == 0) sum += block.checksum;
+		}
+	}
+	__sink += sum;
+
+	work->ops += NYBLOG_SECTOR_COUNT;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_bin_read_attempt(__bench_disk *disk, __bench_work *work) {
+	NYB_DataBlock block;
+	uint64_t sum = 0;
+	int ops = 0;
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int secs = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<secs; s++) {
+			DSK_Position pos = { t, s };
+			int count = NYB_Bin_GetAttemptCount(&disk->bin, pos);
+			for (int a=0; a<count; a++) {
+				if (NYB_Bin_ReadAttempt(&disk->bin, pos, a, &block) == 0) sum += block.checksum + block.block_status;
+			}
+			ops += count;
+		}
+	}
+	__sink += sum;
+
+	work->ops += ops;
+	work->bytes += (uint64_t) ops * BLOCK_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_analyse_disk(__bench_disk *disk, __bench_work *work) {
+	ANA_AnalyseDisk(disk->f_disk, disk->f_meta, disk->dir, &__analysis);
+	__sink += __analysis.sectors[0].status;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+//	Analyses the disk first if the last analysis was of another one; that's left to the warm-up run
+void __bench_ensure_analysis(__bench_disk *disk) {
+	static __bench_disk *analysed = NULL;
+	if (analysed == disk) return;
+
+	ANA_AnalyseDisk(disk->f_disk, disk->f_meta, disk->dir, &__analysis);
+	analysed = disk;
+}
+
+void __bench_gather_stats(__bench_disk *disk, __bench_work *work) {
+	__bench_ensure_analysis(disk);
+	ANA_GatherStats(&__analysis);
+	__sink += __analysis.count_healthy;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_query_evaluate(__bench_disk *disk, __bench_work *work) {
+	static QRY_Query query;
+	if (query.num_ops == 0) QRY_Parse("!free && !checksum_match || status:missing && !track:18", &query, NULL);
+	__bench_ensure_analysis(disk);
+
+	ANA_Bitset matches;
+	QRY_Evaluate(&query, &__analysis, &matches);
+	__sink += matches.words[0];
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_session_load(__bench_disk *disk, __bench_work *work) {
+	SES_Options options = {
+		.disk_filename = disk->disk_filename,
+		.recon_filename = (disk->f_meta != NULL) ? disk->recon_filename : NULL,
+		.use_cache = false,
+	};
+	if (!__is_session_ready) __is_session_ready = (SES_Init(&__session, options) == 0);
+	else SES_Reset(&__session, options);
+	if (!__is_session_ready) return;
+
+	if (SES_Load(&__session) == 0) __sink += __session.analysis->count_in_use;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_diff_images(__bench_disk *disk, __bench_work *work) {
+	static DIF_Diff diff;
+	DIF_DiffImages(__reference_image, disk->image, &diff);
+	__sink += diff.num_changed;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE * 2;
+	work->disks += 1.0;
+}
+
+void __bench_search_image(__bench_disk *disk, __bench_work *work) {
+	static SCH_Result result;
+	static SCH_Pattern pattern;
+	if (pattern.len == 0) SCH_ParsePattern("ready.", false, &pattern);
+
+	SCH_SearchImage(disk->image, &disk->dir, &pattern, &result);
+	__sink += result.num_hits;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_verify_bam(__bench_disk *disk, __bench_work *work) {
+	BAM_Report report;
+	BAM_Verify(disk->image, &report);
+	__sink += report.num_allocated_unused;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+void __bench_add_recon(__bench_disk *disk, __bench_work *work) {
+	static NYB_Recon recon;
+	static HMP_Heatmap heatmap;
+	static __bench_disk *loaded = NULL;
+	if (loaded != disk) {
+		if (disk->f_meta == NULL || NYB_Recon_Load(&recon, disk->f_meta, disk->image) != 0) NYB_Recon_Init(&recon);
+		loaded = disk;
+	}
+
+	HMP_AddRecon(&heatmap, &recon, disk->image);
+	__sink += heatmap.total.failures;
+
+	work->ops += 1;
+	work->bytes += NYBLOG_IMAGE_SIZE;
+	work->disks += 1.0;
+}
+
+static const __bench __benches[] = {
+	{ "DSK_Checksum", __bench_checksum, false },
+	{ "DSK_PositionToIndex", __bench_position_to_index, false },
+	{ "DSK_File_ParseDirectory", __bench_parse_directory, true },
+	{ "NYB_ParseLog", __bench_parse_log, true },
+	{ "NYB_Meta_ReadBlock", __bench_meta_read_block, true },
+	{ "NYB_Bin_ReadAttempt", __bench_bin_read_attempt, true },
+	{ "ANA_AnalyseDisk", __bench_analyse_disk, true },
+	{ "ANA_GatherStats", __bench_gather_stats, true },
+	{ "QRY_Evaluate", __bench_query_evaluate, true },
+	{ "SES_Load", __bench_session_load, true },
+	{ "DIF_DiffImages", __bench_diff_images, true },
+	{ "SCH_SearchImage", __bench_search_image, true },
+	{ "BAM_Verify", __bench_verify_bam, true },
+	{ "HMP_AddRecon", __bench_add_recon, true },
+};
+
+double __now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void __print_json_string(const char *str) {
+	putchar('"');
+	for (; *str != '\0'; str++) {
+		if (*str == '"' || *str == '\\') putchar('\\');
+		if ((unsigned char) *str < 0x20) continue;
+		putchar(*str);
+	}
+	putchar('"');
+}
+
+//	Writes the disk's image, log, binary log & recon file to `directory` and opens them
+int __create_disk(__bench_disk *disk, const char *directory, const char *variant, uint32_t flags, uint64_t seed) {
+	memset(disk, 0, sizeof(__bench_disk));
+	disk->variant = variant;
+	disk->flags = flags;
+	snprintf(disk->disk_filename, BENCH_PATH_SIZE, "%s/%s.d64", directory, variant);
+	snprintf(disk->recon_filename, BENCH_PATH_SIZE, "%s/%s.r64", directory, variant);
+	snprintf(disk->log_filename, BENCH_PATH_SIZE, "%s/%s.txt", directory, variant);
+	snprintf(disk->bin_filename, BENCH_PATH_SIZE, "%s/%s.nbx", directory, variant);
+
+	// Only the transfer is damaged; both variants start from the same disk
+	uint8_t *image = malloc(NYBLOG_IMAGE_SIZE);
+	if (image == NULL) return 1;
+	SYN_GenerateImage(seed, image);
+	int err = SYN_WriteLog(image, seed, flags, disk->log_filename);
+	free(image);
+	if (err != 0) return 2;
+	if (SYN_ImportLog(disk->log_filename, disk->disk_filename, disk->recon_filename) != 0) return 2;
+
+	disk->image = malloc(NYBLOG_IMAGE_SIZE);
+	disk->f_disk = fopen(disk->disk_filename, "rb");
+	disk->f_meta = fopen(disk->recon_filename, "rb");
+	if (disk->image == NULL || disk->f_disk == NULL || disk->f_meta == NULL) return 3;
+	if (fread(disk->image, BLOCK_SIZE, NYBLOG_SECTOR_COUNT, disk->f_disk) != NYBLOG_SECTOR_COUNT) return 3;
+
+	struct stat st;
+	if (stat(disk->log_filename, &st) != 0) return 3;
+	disk->log_size = st.st_size;
+	if (NYB_Bin_Convert(disk->log_filename, disk->bin_filename) < 0) return 3;
+	if (NYB_Bin_Open(&disk->bin, disk->bin_filename) != 0) return 3;
+
+	// The directory is only parsed by its own benchmark; the analysis needs it as well
+	if (DSK_File_ParseDirectory(disk->f_disk, &disk->dir, false) != 0) return 3;
+
+	return 0;
+}
+
+void __close_disk(__bench_disk *disk, bool keep_files) {
+	if (disk->f_disk != NULL) fclose(disk->f_disk);
+	if (disk->f_meta != NULL) fclose(disk->f_meta);
+	NYB_Bin_Close(&disk->bin);
+	free(disk->image);
+	if (keep_files) return;
+
+	remove(disk->disk_filename);
+	remove(disk->recon_filename);
+	remove(disk->log_filename);
+	remove(disk->bin_filename);
+}
+
+void __run_bench(const __bench *bench, __bench_disk *disk, const char *label, uint64_t seed, double min_ns) {
+
+	// One untimed run to warm up the caches
+	__bench_work work = { 0 };
+	bench->fn(disk, &work);
+
+	memset(&work, 0, sizeof(work));
+	double start = __now_ns();
+	double elapsed = 0.0;
+	while (elapsed < min_ns) {
+		bench->fn(disk, &work);
+		elapsed = __now_ns() - start;
+	}
+
+	double seconds = elapsed / 1e9;
+	printf("{\"bench\": ");
+	__print_json_string(bench->name);
+	printf(", \"variant\": ");
+	__print_json_string(disk->variant);
+	printf(", \"label\": ");
+	__print_json_string(label);
+	printf(", \"seed\": %llu, \"ops\": %llu, \"ns_per_op\": %.3f, \"mb_per_s\": %.3f, \"disks_per_s\": %.3f}\n",
+		(unsigned long long) seed, (unsigned long long) work.ops,
+		(work.ops > 0) ? elapsed / work.ops : 0.0,
+		work.bytes / 1e6 / seconds,
+		work.disks / seconds
+	);
+	fflush(stdout);
+}
+
+void __usage() {
+	printf("Usage: disekt-bench [OPTIONS] [benchmarks]\n\n");
+	printf("Args:\n");
+	printf("  benchmarks\t\tOnly run the benchmarks whose names contain one of these\n\n");
+	printf("Options:\n");
+	printf("  -h, --help\t\tPrint this usage text and exit\n");
+	printf("  --label <text>\tLabel to tell the results apart, e.g. the commit\n");
+	printf("  --seed <n>\t\tSeed of the synthetic disks (default %i)\n", BENCH_DEFAULT_SEED);
+	printf("  --min-ms <ms>\t\tRun each benchmark at least this long (default %i)\n", BENCH_DEFAULT_MIN_MS);
+	printf("  --generate <directory>\n");
+	printf("\t\t\tWrite the synthetic disks (.d64, .r64 & text-log) to the\n");
+	printf("\t\t\tdirectory instead of benchmarking them\n");
+	exit(EXIT_FAILURE);
+}
+
+int main(int argc, char *argv[]) {
+	const char *label = "";
+	const char *generate_directory = NULL;
+	uint64_t seed = BENCH_DEFAULT_SEED;
+	double min_ms = BENCH_DEFAULT_MIN_MS;
+	char **filters = calloc(argc, sizeof(char *));
+	int num_filters = 0;
+
+	for (int i=1; i<argc; i++) {
+		char *arg = argv[i];
+		bool has_value = (i < argc - 1);
+		if (strcmp(arg, "-h") == 0 || strcmp(arg, "--help") == 0) __usage();
+		else if (strcmp(arg, "--label") == 0 && has_value) label = argv[++i];
+		else if (strcmp(arg, "--seed") == 0 && has_value) seed = strtoull(argv[++i], NULL, 0);
+		else if (strcmp(arg, "--min-ms") == 0 && has_value) min_ms = atof(argv[++i]);
+		else if (strcmp(arg, "--generate") == 0 && has_value) generate_directory = argv[++i];
+		else if (arg[0] == '-') {
+			printf("Error: Unknown option '%s'\n\n", arg);
+			__usage();
+		}
+		else filters[num_filters++] = arg;
+	}
+
+	// The disks are written to a directory of their own & removed afterwards
+	char directory[BENCH_PATH_SIZE];
+	if (generate_directory != NULL) {
+		snprintf(directory, sizeof(directory), "%s", generate_directory);
+		if (mkdir(directory, 0777) != 0 && errno != EEXIST) {
+			printf("Error: Failed to create directory '%s'\n", directory);
+			return EXIT_FAILURE;
+		}
+	} else {
+		const char *tmp = getenv("TMPDIR");
+		snprintf(directory, sizeof(directory), "%s/disekt-bench-XXXXXX", (tmp != NULL) ? tmp : "/tmp");
+		if (mkdtemp(directory) == NULL) {
+			printf("Error: Failed to create temporary directory '%s'\n", directory);
+			return EXIT_FAILURE;
+		}
+	}
+
+	__bench_disk disks[2];
+	int err = __create_disk(&disks[0], directory, "clean", 0, seed);
+	if (err == 0) err = __create_disk(&disks[1], directory, "damaged", SYN_FLAG_DAMAGED, seed);
+	if (err != 0) {
+		printf("Error: Failed to create the synthetic disks in '%s'; Error-code: %i\n", directory, err);
+		return EXIT_FAILURE;
+	}
+
+	__reference_image = disks[0].image;
+
+	if (generate_directory != NULL) {
+		for (int d=0; d<2; d++) {
+			printf("Wrote '%s', '%s' & '%s'\n", disks[d].disk_filename, disks[d].recon_filename, disks[d].log_filename);
+			__close_disk(&disks[d], true);
+		}
+		return EXIT_SUCCESS;
+	}
+
+	int num_benches = sizeof(__benches) / sizeof(__benches[0]);
+	for (int b=0; b<num_benches; b++) {
+		const __bench *bench = &__benches[b];
+		bool selected = (num_filters == 0);
+		for (int f=0; f<num_filters && !selected; f++) selected = (strstr(bench->name, filters[f]) != NULL);
+		if (!selected) continue;
+
+		__run_bench(bench, &disks[0], label, seed, min_ms * 1e6);
+		if (bench->needs_damage) __run_bench(bench, &disks[1], label, seed, min_ms * 1e6);
+	}
+
+	if (__is_session_ready) SES_Close(&__session);
+	for (int d=0; d<2; d++) __close_disk(&disks[d], false);
+	rmdir(directory);
+	free(filters);
+	return EXIT_SUCCESS;
+}
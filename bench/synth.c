@@ -0,0 +1,252 @@
+#include "synth.h"
+
+//	Blocks of the import, on their way to the image & recon file
+typedef struct {
+	NYB_DiskImage image;
+	NYB_Recon recon;
+} __import_target;
+
+
+void SYN_Random_Init(SYN_Random *rng, uint64_t seed) {
+	if (rng == NULL) return;
+	rng->state = seed;
+}
+
+uint32_t SYN_Random_Next(SYN_Random *rng) {
+	// splitmix64; any seed, zero included, gives a full-period sequence
+	uint64_t z = (rng->state += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	return (uint32_t)((z ^ (z >> 31)) >> 32);
+}
+
+int SYN_Random_Range(SYN_Random *rng, int min, int max) {
+	if (max <= min) return min;
+	return min + (int)(SYN_Random_Next(rng) % (uint32_t)(max - min + 1));
+}
+
+uint8_t *__block(uint8_t *image, DSK_Position pos) {
+	return image + (size_t) DSK_PositionToIndex(pos) * BLOCK_SIZE;
+}
+
+//	Finds the next free block for a file, the way the drive does; on the same
+//	track if there's room, otherwise on the next one away from the directory
+bool __allocate(bool used[NYBLOG_SECTOR_COUNT], DSK_Position *pos) {
+	static const int track_order[MAX_TRACKS - 1] = {
+		17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1,
+		19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35,
+	};
+
+	int t = 0;
+	while (t < MAX_TRACKS - 1 && track_order[t] != pos->track) t++;
+
+	int sector = pos->sector + SYN_INTERLEAVE;
+	for (; t < MAX_TRACKS - 1; t++) {
+		int track = track_order[t];
+		int secs = DSK_Track_GetSectorCount(track);
+		for (int i=0; i<secs; i++) {
+			DSK_Position next = { track, (sector + i) % secs };
+			int index = DSK_PositionToIndex(next);
+			if (used[index]) continue;
+
+			used[index] = true;
+			*pos = next;
+			return true;
+		}
+		sector = 0;
+	}
+
+	return false;
+}
+
+int SYN_GenerateImage(uint64_t seed, uint8_t *image) {
+	if (image == NULL) return 1;
+
+	SYN_Random rng;
+	SYN_Random_Init(&rng, seed);
+	memset(image, 0, NYBLOG_IMAGE_SIZE);
+
+	bool used[NYBLOG_SECTOR_COUNT];
+	memset(used, 0, sizeof(used));
+	used[DSK_PositionToIndex(DSK_POSITION_BAM)] = true;
+
+	// Files are added until about three quarters of the disk is full
+	int budget = SYN_Random_Range(&rng, 400, 520);
+	int num_files = 0;
+	DSK_Position file_pos = { 17, 0 };
+	uint8_t entries[MAX_DIR_ENTRIES][30];
+	while (budget > 0 && num_files < MAX_DIR_ENTRIES - 8) {
+		int num_blocks = SYN_Random_Range(&rng, 1, (SYN_Random_Range(&rng, 0, 7) == 0) ? 120 : 24);
+		if (num_blocks > budget) num_blocks = budget;
+		budget -= num_blocks;
+
+		// Mostly closed PRG files, some SEQ & the odd USR one
+		uint8_t *entry = entries[num_files];
+		int type_roll = SYN_Random_Range(&rng, 0, 9);
+		memset(entry, 0x00, 30);
+		entry[0] = (type_roll < 7) ? 0x82 : (type_roll < 9) ? 0x81 : 0x83;
+		memset(entry + 3, 0xA0, 16);
+		char name[17];
+		snprintf(name, sizeof(name), "SYNTH %03i", num_files);
+		memcpy(entry + 3, name, strlen(name));
+
+		// Every block links to the next; the last one has the index of its last byte instead
+		uint8_t *prev = NULL;
+		int b = 0;
+		for (; b<num_blocks; b++) {
+			if (!__allocate(used, &file_pos)) break;
+			uint8_t *block = __block(image, file_pos);
+			for (int i=2; i<BLOCK_SIZE; i++) block[i] = SYN_Random_Next(&rng);
+
+			if (prev == NULL) {
+				entry[1] = file_pos.track;
+				entry[2] = file_pos.sector;
+			} else {
+				prev[0] = file_pos.track;
+				prev[1] = file_pos.sector;
+			}
+			prev = block;
+		}
+		if (prev == NULL) break;
+		prev[0] = 0x00;
+		prev[1] = SYN_Random_Range(&rng, 2, 255);
+		entry[28] = b & 0xFF;
+		entry[29] = b >> 8;
+		num_files++;
+	}
+
+	// Directory blocks on track 18, 3 sectors apart; 8 entries each
+	int num_dir_blocks = (num_files + 7) / 8;
+	if (num_dir_blocks < 1) num_dir_blocks = 1;
+	for (int d=0; d<num_dir_blocks; d++) {
+		DSK_Position pos = { 18, 1 + d * 3 };
+		uint8_t *block = __block(image, pos);
+		used[DSK_PositionToIndex(pos)] = true;
+		block[0] = (d < num_dir_blocks - 1) ? 18 : 0x00;
+		block[1] = (d < num_dir_blocks - 1) ? 1 + (d + 1) * 3 : 0xFF;
+
+		for (int e=0; e<8 && d * 8 + e < num_files; e++) {
+			memcpy(block + e * 32 + 2, entries[d * 8 + e], 30);
+		}
+	}
+
+	// The BAM; a free count & a bitmap of free sectors for every track
+	uint8_t *bam = __block(image, DSK_POSITION_BAM);
+	bam[0] = 18;
+	bam[1] = 1;
+	bam[2] = 'A';
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		uint32_t free_map = 0;
+		int num_free = 0;
+		for (int s=0; s<DSK_Track_GetSectorCount(t); s++) {
+			if (used[DSK_PositionToIndex((DSK_Position){ t, s })]) continue;
+			free_map |= 1u << s;
+			num_free++;
+		}
+
+		uint8_t *entry = bam + 4 * t;
+		entry[0] = num_free;
+		entry[1] = free_map & 0xFF;
+		entry[2] = (free_map >> 8) & 0xFF;
+		entry[3] = (free_map >> 16) & 0xFF;
+	}
+	memset(bam + 0x90, 0xA0, 0x1B);
+	char name[17];
+	snprintf(name, sizeof(name), "SYNTH %08X", (uint32_t) seed);
+	memcpy(bam + 0x90, name, strlen(name));
+	bam[0xA2] = 'S';
+	bam[0xA3] = 'Y';
+	bam[0xA5] = '2';
+	bam[0xA6] = 'A';
+
+	return 0;
+}
+
+void __write_block(FILE *f_log, DSK_Position pos, const uint8_t *data, uint16_t checksum, int err, int num_rows) {
+	fprintf(f_log, ">>> BLOCK-START: T=%i; S=%i <<<\n", pos.track, pos.sector);
+	fprintf(f_log, "         00 01 02 03 04 05 06 07 08 09 0A 0B 0C 0D 0E 0F\n");
+	for (int y=0; y<num_rows; y++) {
+		fprintf(f_log, "  [0x%02X]", y * 16);
+		for (int x=0; x<16; x++) fprintf(f_log, " %02X", data[y * 16 + x]);
+		fprintf(f_log, "\n");
+	}
+	if (num_rows < BLOCK_SIZE / 16) return;
+	fprintf(f_log, ">>> BLOCK-END; C=0x%04X; E=%i <<<\n", checksum, err);
+}
+
+int SYN_WriteLog(const uint8_t *image, uint64_t seed, uint32_t flags, const char *filename) {
+	if (image == NULL || filename == NULL) return 1;
+
+	FILE *f_log = fopen(filename, "w");
+	if (f_log == NULL) return 2;
+
+	// The damage doesn't depend on the image, only on the seed
+	SYN_Random rng;
+	SYN_Random_Init(&rng, seed ^ 0xD15E47ull);
+	bool is_damaged = (flags & SYN_FLAG_DAMAGED);
+
+	fprintf(f_log, ">>> INFO; M=Starting transfer <<<\n");
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		for (int s=0; s<DSK_Track_GetSectorCount(t); s++) {
+			DSK_Position pos = { t, s };
+			const uint8_t *data = image + (size_t) DSK_PositionToIndex(pos) * BLOCK_SIZE;
+			uint16_t checksum = DSK_Checksum((void *) data);
+
+			// The very last block is cut off by the end of the log
+			if (is_damaged && t == MAX_TRACKS && s == DSK_Track_GetSectorCount(t) - 1) {
+				__write_block(f_log, pos, data, checksum, 0, 8);
+				continue;
+			}
+
+			int roll = is_damaged ? SYN_Random_Range(&rng, 0, 99) : 99;
+			if (roll < 2) continue;
+
+			if (roll < 8) {
+				uint8_t bad[BLOCK_SIZE];
+				memcpy(bad, data, BLOCK_SIZE);
+				bad[SYN_Random_Range(&rng, 0, BLOCK_SIZE - 1)] ^= 1 << SYN_Random_Range(&rng, 0, 7);
+				__write_block(f_log, pos, bad, checksum, (roll < 5) ? SYN_DISK_ERROR : 0, BLOCK_SIZE / 16);
+
+				// About half of the bad blocks were sent again & made it the second time
+				if (SYN_Random_Range(&rng, 0, 1) == 0) continue;
+			}
+
+			__write_block(f_log, pos, data, checksum, 0, BLOCK_SIZE / 16);
+			if (roll == 8) fprintf(f_log, ">>> WARNING; E=1 <<<\n");
+		}
+	}
+
+	if (fclose(f_log) != 0) return 2;
+	return 0;
+}
+
+int __synth_import_block(NYB_DataBlock *block, void *user_data) {
+	__import_target *target = user_data;
+
+	NYB_Image_WriteBlock(&target->image, block, false);
+	NYB_Recon_AddBlock(&target->recon, block);
+	return 0;
+}
+
+int SYN_ImportLog(const char *log_filename, const char *disk_filename, const char *recon_filename) {
+	if (log_filename == NULL || disk_filename == NULL || recon_filename == NULL) return 1;
+
+	// Always start from a blank image, the same as a first import
+	remove(disk_filename);
+	__import_target *target = malloc(sizeof(__import_target));
+	if (target == NULL) return 3;
+	if (NYB_Image_Open(&target->image, disk_filename) != 0) {
+		free(target);
+		return 3;
+	}
+	NYB_Recon_Init(&target->recon);
+
+	int err = 0;
+	if (NYB_ParseLogParallel(log_filename, 0, __synth_import_block, NULL, target) < 0) err = 2;
+	if (err == 0 && NYB_Image_Flush(&target->image) != 0) err = 3;
+	if (err == 0 && NYB_Recon_Save(&target->recon, recon_filename, target->image.data) != 0) err = 3;
+
+	NYB_Image_Close(&target->image);
+	free(target);
+	return err;
+}
@@ -0,0 +1,77 @@
+#ifndef SYNTH_H
+#define SYNTH_H
+
+//	Deterministic synthetic disks for the benchmarks: disk images full of
+//	files, the transfer logs the arduino would send for them and the images &
+//	recon files importing those logs gives, with or without transfer damage
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define SYN_FLAG_DAMAGED 0x01		// Drop, corrupt & retry blocks in the log, and cut it short
+
+#define SYN_INTERLEAVE 10			// Sectors between the blocks of a file, like the 1541 writes them
+#define SYN_DISK_ERROR 23			// Disk error of damaged blocks; a checksum error reading the sector
+
+
+//
+//	Type Definitions
+//
+
+//	State of the generator's random numbers; the same seed always gives the same disk
+typedef struct {
+	uint64_t state;
+} SYN_Random;
+
+
+//
+//	Function Declarations
+//
+
+//	Seeds a random number generator
+//
+void SYN_Random_Init(SYN_Random *rng, uint64_t seed);
+
+//	Gets the next random number
+//
+uint32_t SYN_Random_Next(SYN_Random *rng);
+
+//	Gets a random number from `min` to `max`, both included
+//
+int SYN_Random_Range(SYN_Random *rng, int min, int max);
+
+//	Fills a disk image with a BAM, a directory and files of random data
+//
+//	The image holds NYBLOG_SECTOR_COUNT blocks. Files are laid out with
+//	SYN_INTERLEAVE between their blocks, starting next to the directory track.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int SYN_GenerateImage(uint64_t seed, uint8_t *image);
+
+//	Writes the text-log of transferring a disk image
+//
+//	Every block is sent once, in order. With SYN_FLAG_DAMAGED some blocks are
+//	left out, sent with disk errors or bad data (and sometimes sent again),
+//	warnings are mixed in, and the log ends part of the way through a block.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to write the log
+int SYN_WriteLog(const uint8_t *image, uint64_t seed, uint32_t flags, const char *filename);
+
+//	Imports a log into a new disk image and recon file, like disekt -l does
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the log
+//		3 = Failed to write the image or recon file
+int SYN_ImportLog(const char *log_filename, const char *disk_filename, const char *recon_filename);
+
+
+#endif
@@ -8,14 +8,13 @@
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
-#include <raylib.h>
 #include <sys/types.h>
 #include "../include/debug.h"
-#include "../include/arc.h"
 #include "../include/disk.h"
 #include "../include/nyblog.h"
 
 #define MAX_ANALYSIS_ENTRIES 683	// Total number of sectors on a disk
+#define ANA_BITSET_WORDS ((MAX_ANALYSIS_ENTRIES + 31) / 32)
 
 //	
 //	Type Definitions
@@ -67,10 +66,65 @@ typedef struct {
 	int dir_page;					// 
 } ANA_SectorInfo;
 
+//	The steps of an analysis, in the order they have to run in
+typedef enum {
+	ANAPASS_BAM,			// Sector types & free flags from the BAM
+	ANAPASS_DATA,			// Sector data, transfer info & basic status
+	ANAPASS_DIRECTORY,		// Directory blocks on track 18
+	ANAPASS_CHAINS,			// Blocks of every file in the directory
+	ANAPASS_BLANKS,			// Free sectors matching the disk's blank pattern
+	ANAPASS_ORPHANS,		// Links between sectors no file claims
+	ANAPASS_CHECKSUMS,		// Sectors whose transferred checksum confirms them
+	NUM_ANAPASSES,
+} ANA_Pass;
+
+//	A bit per sector index
+typedef struct {
+	uint32_t words[ANA_BITSET_WORDS];
+} ANA_Bitset;
+
+//	What ANA_GatherStats keeps a bitset of sectors for
+typedef enum {
+	ANAATTR_FREE,
+	ANAATTR_HAS_DATA,
+	ANAATTR_BLANK,
+	ANAATTR_TRANSFER_INFO,
+	ANAATTR_DIRECTORY_INFO,
+	ANAATTR_CHECKSUM_MATCH,
+	ANAATTR_TRANSFER_ERROR,		// The nybbler or the drive reported an error for it
+
+	// A bit per sector with the status; in the order of ANA_Status
+	ANAATTR_STATUS_INVALID,
+	ANAATTR_STATUS_EMPTY,
+	ANAATTR_STATUS_UNEXPECTED,
+	ANAATTR_STATUS_MISSING,
+	ANAATTR_STATUS_PRESENT,
+	ANAATTR_STATUS_CORRUPTED,
+	ANAATTR_STATUS_CONFIRMED,
+	ANAATTR_STATUS_BAD,
+	ANAATTR_STATUS_GOOD,
+	ANAATTR_STATUS_UNKNOWN,
+
+	// A bit per sector of the type; in the order of DSK_SectorType
+	ANAATTR_TYPE_DEL,
+	ANAATTR_TYPE_SEQ,
+	ANAATTR_TYPE_PRG,
+	ANAATTR_TYPE_USR,
+	ANAATTR_TYPE_REL,
+	ANAATTR_TYPE_EMPTY,
+	ANAATTR_TYPE_BAM,
+	ANAATTR_TYPE_DIR,
+	ANAATTR_TYPE_UNKNOWN,
+	ANAATTR_TYPE_INVALID,
+	NUM_ANAATTRS,
+} ANA_Attribute;
+
 //	Contains the results of analysing the disk;
 typedef struct {
 	DSK_Directory dir;
 	ANA_SectorInfo sectors[MAX_ANALYSIS_ENTRIES];
+	ANA_Bitset attributes[NUM_ANAATTRS];	// Sectors with each attribute
+	ANA_Bitset files[MAX_DIR_ENTRIES];		// Blocks of each directory entry
 	int count_in_use;
 	int count_healthy;
 	int count_bad;
@@ -87,10 +141,55 @@ typedef struct {
 //	Tries to find as much information about every sector as it can
 int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo *analysis);
 
+//	Runs a single step of the analysis
+//
+//	Passes have to run in order, starting with ANAPASS_BAM; each one refines
+//	the results of the ones before. ANA_AnalyseDisk runs all of them.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Invalid pass
+int ANA_AnalysePass(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo *analysis, ANA_Pass pass);
+
+//	Gets a constant char pointer to a description of an analysis pass
+//
+const char *ANA_GetPassName(ANA_Pass pass);
+
 //	Go through all sectors and count statistics for each sector status
 //
+//	Fills in the bitsets of every attribute & file first; the counts are
+//	then only a few word operations over them.
 int ANA_GatherStats(ANA_DiskInfo *analysis);
 
+//	Gets the attribute of sectors with a status
+//
+//	Returns ANAATTR_STATUS_UNKNOWN for statuses that don't exist
+ANA_Attribute ANA_GetStatusAttribute(ANA_Status status);
+
+//	Gets the attribute of sectors of a type
+//
+//	Returns ANAATTR_TYPE_INVALID for types that don't exist
+ANA_Attribute ANA_GetTypeAttribute(DSK_SectorType type);
+
+//	Gets a constant char pointer to the name of an attribute, as queries use it
+//
+//	Returns NULL for invalid attributes
+const char *ANA_GetAttributeName(ANA_Attribute attribute);
+
+//	Returns true if the sector at `index` is in the bitset
+//
+bool ANA_Bitset_Test(const ANA_Bitset *set, int index);
+
+//	Counts the sectors in a bitset
+//
+int ANA_Bitset_Count(const ANA_Bitset *set);
+
+//	Finds the first sector in a bitset after `index`, wrapping around to the
+//	start of the disk; -1 starts at the first one
+//
+//	Returns -1 if the bitset is empty
+int ANA_Bitset_Next(const ANA_Bitset *set, int index);
+
 //	Get the full analysis entry for a given sector
 //
 //	Returns 0 on success
@@ -101,30 +200,13 @@ int ANA_GetInfo(ANA_DiskInfo analysis, DSK_Position pos, ANA_SectorInfo *entry);
 //	*Deprecated*
 const char *ANA_GetStatusName(ANA_Status status);
 
-//	Get a colour for a sector based on its state
-//
-//	*Deprecated*
-Color ANA_GetStatusColour(ANA_Status status);
-
-//	Get a colour for a sector based on which file it belongs to
-//
-Color ANA_GetFileColour(DSK_Directory dir, ANA_SectorInfo entry, bool is_hovered, bool is_selected);
-
 //	Get a constant char pointer to the name of a nyb-log parse error
 //
 const char *ANA_GetParseErrorName(int err_code);
 
-//	Get a colour for a nyb-log parsing error code
-//
-Color ANA_GetParseErrorColour(int err_code);
-
 //	Get a constant char pointer to the name of a DOS disk error
 //
 const char *ANA_GetDiskErrorName(uint8_t err_code);
 
-//	Get a colour for a DOS disk error code
-//
-Color ANA_GetDiskErrorColour(uint8_t  err_code);
-
 
 #endif
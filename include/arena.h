@@ -0,0 +1,61 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+//	A fixed block of memory that's handed out front to back and given back
+//	all at once; for everything that lives exactly as long as a single disk
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#define ARN_ALIGNMENT 16		// Every allocation starts at a multiple of this
+
+//	Space an allocation of `size` takes up in an arena, alignment included
+#define ARN_SIZE(size) ((((size_t)(size)) + ARN_ALIGNMENT - 1) / ARN_ALIGNMENT * ARN_ALIGNMENT)
+
+
+//
+//	Type Definitions
+//
+
+typedef struct {
+	uint8_t *base;
+	size_t size;
+	size_t used;
+	size_t peak;		// Most that's ever been used at once
+} ARN_Arena;
+
+
+//
+//	Function Declarations
+//
+
+//	Allocates the memory of an arena
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to allocate the memory
+int ARN_Init(ARN_Arena *arena, size_t size);
+
+//	Takes the next `size` bytes of an arena; they aren't cleared
+//
+//	Returns NULL if there isn't enough room left
+void *ARN_Alloc(ARN_Arena *arena, size_t size);
+
+//	Takes the next `size` bytes of an arena & clears them
+//
+//	Returns NULL if there isn't enough room left
+void *ARN_Calloc(ARN_Arena *arena, size_t size);
+
+//	Gives back everything that's been taken from an arena
+//
+void ARN_Reset(ARN_Arena *arena);
+
+//	Frees the memory of an arena
+//
+void ARN_Free(ARN_Arena *arena);
+
+
+#endif
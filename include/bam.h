@@ -0,0 +1,101 @@
+#ifndef BAM_H
+#define BAM_H
+
+//	Checking a disk's Block-Availability Map against what its directory &
+//	files actually use, and rebuilding it from their chains
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define BAM_ENTRIES_OFFSET 0x04		// Track entries follow the directory link & DOS version
+#define BAM_ENTRY_SIZE 4			// Free count, then a bit per sector (set = free)
+
+
+//
+//	Type Definitions
+//
+
+//	Every bitset has a word per track, with bit `s` for sector `s`
+typedef struct {
+	uint32_t used[MAX_TRACKS];				// Used by the BAM, the directory or a file's chain
+	uint32_t stored_free[MAX_TRACKS];		// What the BAM says is free
+	uint8_t stored_counts[MAX_TRACKS];		// Free sectors per track, as the BAM counts them
+	uint32_t allocated_unused[MAX_TRACKS];	// Marked as used, but nothing's in them
+	uint32_t used_free[MAX_TRACKS];			// Marked as free, so a drive would overwrite them
+	uint32_t cross_linked[MAX_TRACKS];		// In the chain of more than one file
+	int num_allocated_unused;
+	int num_used_free;
+	int num_cross_linked;
+	int num_bad_counts;			// Tracks whose free count doesn't match their bits
+	int num_broken_chains;		// Files whose chain ends in an invalid link or a loop
+	bool is_header_valid;		// Whether the directory link & DOS version look right
+} BAM_Report;
+
+//	Totals of checking several images
+typedef struct {
+	int images_consistent;
+	int images_failed;		// Images that couldn't be read
+	int sectors_allocated_unused;
+	int sectors_used_free;
+} BAM_Stats;
+
+
+//
+//	Function Declarations
+//
+
+//	Works out which sectors of an in-memory disk image of NYBLOG_SECTOR_COUNT
+//	blocks are in use & compares that to its BAM
+//
+//	The directory is read from the image itself, so scratched entries between
+//	files are skipped rather than ending it. Files that weren't closed still
+//	count as using their blocks; rebuilding the BAM won't free them.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int BAM_Verify(const uint8_t *image, BAM_Report *report);
+
+//	Returns true if the BAM matches what's in use, sector by sector & in its counts
+//
+bool BAM_IsConsistent(const BAM_Report *report);
+
+//	Packs the sectors that aren't used into the layout of DSK_Directory.bam
+//
+void BAM_Pack(const uint32_t used[MAX_TRACKS], uint32_t bam[MAX_TRACKS]);
+
+//	Writes the BAM of `report` (every unused sector free) into an in-memory image
+//
+//	Only the track entries are written; the directory link, DOS version and
+//	disk name are left alone. If a chain is broken, the sectors the old BAM
+//	allocates stay allocated, as the rest of that file could be in any of them.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = A chain is broken & the old BAM is invalid; nothing was written
+int BAM_Rebuild(uint8_t *image, const BAM_Report *report);
+
+//	Writes the sectors whose BAM entry is wrong to `f_report`, prefixed with
+//	`filename` if it isn't NULL
+//
+void BAM_WriteReport(FILE *f_report, const char *filename, const BAM_Report *report);
+
+//	Checks several disk images, writing a report of each to `f_report`
+//
+//	With `output_filename`, the first image is written there with its BAM
+//	rebuilt; any error bytes at its end are kept.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Some images couldn't be read; see stats
+//		3 = Failed to write the corrected image
+//		4 = The BAM couldn't be rebuilt safely (see BAM_Rebuild); nothing was written
+int BAM_CheckImages(char **filenames, int num_images, const char *output_filename, FILE *f_report, BAM_Stats *stats);
+
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef CACHE_H
+#define CACHE_H
+
+//	Helper functions for storing finished disk analyses,
+//	so unchanged disks don't have to be re-analysed on every launch
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+
+#define CACHE_MAGIC (uint32_t)(*(uint32_t *)"DKAC")
+#define CACHE_VERSION 2				// Bump whenever the analysis results change meaning
+#define CACHE_EXTENSION ".dkc"
+#define CACHE_DIR_NAME "disekt"		// Sub-directory used inside $XDG_CACHE_HOME
+#define CACHE_PATH_SIZE 4096
+
+
+//
+//	Type Definitions
+//
+
+//	Identifies the inputs an analysis was created from
+typedef struct {
+	uint64_t disk_hash;		// Hash of the full disk image contents
+	uint64_t recon_hash;	// Hash of the recon file contents (0 if none was used)
+	uint32_t flags;			// Any options that change the analysis result
+} ANA_CacheKey;
+
+#define CACHE_FLAG_IGNORE_BAM 0x01
+
+
+//
+//	Function Declarations
+//
+
+//	Hashes the entire contents of a file
+//
+//	The file pointer is rewound before and after hashing
+//	Returns 0 if f is NULL
+uint64_t ANA_Cache_HashFile(FILE *f);
+
+//	Hashes a buffer the same way ANA_Cache_HashFile hashes a file of its contents
+//
+//	Returns 0 if buf is NULL
+uint64_t ANA_Cache_HashBytes(const uint8_t *buf, size_t len);
+
+//	Builds the cache key for a disk image and its (optional) recon file
+//
+//	Returns 0 on success
+//		1 = f_disk or key was NULL
+int ANA_Cache_GetKey(FILE *f_disk, FILE *f_meta, uint32_t flags, ANA_CacheKey *key);
+
+//	Gets the path the cache entry for a disk should be stored at
+//
+//	If $XDG_CACHE_HOME is set the entry is named after the key and stored in
+//	"$XDG_CACHE_HOME/disekt/", otherwise it's stored next to the disk image.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The path didn't fit into the buffer
+int ANA_Cache_GetPath(const char *disk_filename, ANA_CacheKey key, char *buf, size_t bufsz);
+
+//	Loads a cached analysis if one exists for the given key
+//
+//	Returns 0 on a cache hit
+//		1 = Received NULL argument pointer
+//		2 = No cache file exists
+//		3 = The cache file is from an incompatible version
+//		4 = The cache file belongs to different inputs
+//		5 = The cache file is truncated
+int ANA_Cache_Load(const char *path, ANA_CacheKey key, ANA_DiskInfo *analysis);
+
+//	Writes a finished analysis to the cache
+//
+//	The entry is written to a temporary file first and then renamed,
+//	so an interrupted write never leaves a broken cache entry behind
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to write the cache file
+int ANA_Cache_Save(const char *path, ANA_CacheKey key, ANA_DiskInfo *analysis);
+
+
+#endif
@@ -0,0 +1,148 @@
+#ifndef CLI_H
+#define CLI_H
+
+//	The command line shared by the viewer and the headless tool: argument
+//	parsing, the batch modes and loading & analysing a disk
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+#include "../include/nyblog.h"
+#include "../include/cache.h"
+#include "../include/merge.h"
+#include "../include/plan.h"
+#include "../include/nybbin.h"
+#include "../include/ingest.h"
+#include "../include/hexdump.h"
+#include "../include/extract.h"
+#include "../include/diff.h"
+#include "../include/search.h"
+#include "../include/index.h"
+#include "../include/bam.h"
+#include "../include/query.h"
+#include "../include/heatmap.h"
+#include "../include/session.h"
+#include "../include/trace.h"
+
+#define CLI_VERSION "1.3.0"
+
+extern bool g_verbose_log;
+extern bool g_ignore_error_invalid_bam;
+extern bool g_ignore_error_image_write;
+extern bool g_use_analysis_cache;
+
+
+//
+//	Type Definitions
+//
+
+typedef enum {
+	RUNMODE_VIEW,		// Open the disk in the interactive viewer
+	RUNMODE_MERGE,		// Merge several recon files into one image
+	RUNMODE_PACK,		// Convert a text-log into an indexed binary log
+	RUNMODE_INGEST,		// Read a log stream straight into a disk image
+	RUNMODE_EXTRACT,	// Extract the files of several disk images
+	RUNMODE_DIFF,		// Compare pairs of disk images
+	RUNMODE_SEARCH,		// Look for a pattern in several disk images
+	RUNMODE_INDEX,		// Update or query the file index of an archive directory
+	RUNMODE_CHECK_BAM,	// Compare the BAM of several disk images to their file chains
+	RUNMODE_HEATMAP,	// Count where the transfers of many recon files fail
+} CLI_RunMode;
+
+//	All the paths & modes given on the command line
+typedef struct {
+	CLI_RunMode mode;
+	char *disk_filename;
+	char *log_filename;
+	char *hexdump_filename;
+	char *recon_filename;
+	char *export_directory;
+	uint32_t export_flags;		// EXT_FLAG_*
+	char *output_filename;
+	char *plan_filename;
+	char *ingest_source;
+	char *trace_filename;
+	char *search_pattern;
+	bool search_is_hex;
+	char *index_directory;
+	char *index_query;
+	char *sector_query;			// Expression of the sectors to list or highlight
+	char **input_filenames;		// Positional arguments of batch modes
+	int num_inputs;
+} CLI_Arguments;
+
+
+//
+//	Function Declarations
+//
+
+//	Reads the command line into `args`
+//
+//	Exits after printing the usage text if the arguments are invalid
+void CLI_ParseArgs(int argc, char *argv[], CLI_Arguments *args);
+
+//	Starts recording trace spans if --trace was given; they're written at exit
+//
+//	Exits if the trace file can't be created
+void CLI_StartTrace(CLI_Arguments args);
+
+//	Runs the batch mode given on the command line
+//
+//	Returns the exit status of the batch mode or -1 if the disk is to be viewed
+int CLI_RunBatchMode(CLI_Arguments args);
+
+//	Gets the options of loading the disk given on the command line
+//
+//	Exits after printing the usage text if no disk, or both a log and a hex
+//	dump, are given
+int CLI_GetSessionOptions(CLI_Arguments args, SES_Options *options);
+
+//	Prints what went wrong while loading the disk, given SES_Load's return code
+//
+//	Returns EXIT_SUCCESS if nothing went wrong or EXIT_FAILURE if the analysis
+//	failed; exits after printing the usage text if the disk can't be read
+int CLI_ReportLoadError(CLI_Arguments args, int err, int err_detail);
+
+//	Imports the log or hex dump given (if any), then reads the disk's
+//	directory and analyses it, or loads a cached analysis
+//
+//	The results are in session->dir & session->analysis; the session only has
+//	to be closed if the disk was loaded.
+//
+//	Returns EXIT_SUCCESS or EXIT_FAILURE if the analysis failed; exits after
+//	printing the usage text if the disk can't be read
+int CLI_LoadDisk(CLI_Arguments args, SES_Session *session);
+
+//	Writes a plan of which sectors to transfer again to `args.plan_filename`
+//
+//	Returns EXIT_SUCCESS or EXIT_FAILURE
+int CLI_WritePlan(CLI_Arguments args, ANA_DiskInfo *analysis);
+
+//	Lists the sectors matching `args.sector_query`
+//
+//	Returns EXIT_SUCCESS or EXIT_FAILURE
+int CLI_WriteQuery(CLI_Arguments args, ANA_DiskInfo *analysis);
+
+//	Counts the transfers of the recon files of `args.input_filenames` into
+//	`heatmap`, & writes it to `args.output_filename` as CSV if it's set
+//
+//	Returns EXIT_SUCCESS or EXIT_FAILURE; exits after printing the usage text
+//	if there are no recon files
+int CLI_BuildHeatmap(CLI_Arguments args, HMP_Heatmap *heatmap);
+
+//	Prints the version number and exits
+//
+void CLI_Version();
+
+//	Prints the usage text and exits
+//
+void CLI_Usage();
+
+
+#endif
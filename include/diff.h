@@ -0,0 +1,105 @@
+#ifndef DIFF_H
+#define DIFF_H
+
+//	Comparing two disk images block by block: which sectors changed, which
+//	bytes of them, and which files those sectors belong to
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+#include "../include/arena.h"
+
+#define DIF_BITSET_WORDS ((NYBLOG_SECTOR_COUNT + 31) / 32)
+#define DIF_MAX_RANGES 8		// Byte ranges reported per sector; the rest are only counted
+
+//	Scratch space DIF_DiffFiles needs for both images
+#define DIF_ARENA_SIZE (2 * (ARN_SIZE(NYBLOG_IMAGE_SIZE) + ARN_SIZE(sizeof(DSK_Directory))))
+
+
+//
+//	Type Definitions
+//
+
+//	Bytes `start` to `end` (inclusive) of a block differ
+typedef struct {
+	uint16_t start;
+	uint16_t end;
+} DIF_Range;
+
+//	Differences between two images
+typedef struct {
+	uint32_t changed[DIF_BITSET_WORDS];				// Bit per sector index
+	uint16_t bytes_changed[NYBLOG_SECTOR_COUNT];	// 0 - BLOCK_SIZE
+	int num_changed;
+	int num_bytes_changed;
+} DIF_Diff;
+
+//	Totals of the files of two images
+typedef struct {
+	int files_changed;		// In both images, with a changed block or a different chain
+	int files_added;		// Only in the second image
+	int files_removed;		// Only in the first image
+} DIF_FileStats;
+
+
+//
+//	Function Declarations
+//
+
+//	Reads the blocks of a disk image & its directory into memory
+//
+//	Any error bytes at the end are ignored, and a short image is padded with
+//	zeroes. The BAM isn't checked; only the directory entries are needed.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the image
+//		3 = Failed to parse the directory; the image is read, but dir is empty
+int DIF_LoadImage(const char *filename, uint8_t *image, DSK_Directory *dir);
+
+//	Compares two in-memory disk images of NYBLOG_SECTOR_COUNT blocks
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int DIF_DiffImages(const uint8_t *image_a, const uint8_t *image_b, DIF_Diff *diff);
+
+//	Returns true if the sector at `index` differs between the images
+//
+bool DIF_IsChanged(const DIF_Diff *diff, int index);
+
+//	Finds the runs of differing bytes of two blocks, up to `max_ranges` of them
+//
+//	Returns how many runs there are in total, or -1 for a NULL argument
+int DIF_GetRanges(const uint8_t *block_a, const uint8_t *block_b, DIF_Range *ranges, int max_ranges);
+
+//	Writes the changed sectors & files of two images to `f_report`
+//
+//	Files are matched by name & type. A file has changed if any block of its
+//	chain did, in either image, or if it starts elsewhere.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int DIF_WriteReport(FILE *f_report, const uint8_t *image_a, const DSK_Directory *dir_a, const uint8_t *image_b, const DSK_Directory *dir_b, const DIF_Diff *diff, DIF_FileStats *stats);
+
+//	Reads & compares two disk images, writing the report to `f_report` if it
+//	isn't NULL
+//
+//	Both images are read into `arena`, which is reset first and has to hold
+//	at least DIF_ARENA_SIZE bytes; reusing it keeps comparing many pairs
+//	from allocating anything.
+//	The files are only compared (and `stats` filled in) along with the report.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the first image
+//		3 = Failed to read the second image
+//		4 = The arena is too small
+int DIF_DiffFiles(const char *filename_a, const char *filename_b, ARN_Arena *arena, FILE *f_report, DIF_Diff *diff, DIF_FileStats *stats);
+
+
+#endif
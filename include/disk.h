@@ -7,22 +7,16 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <ctype.h>
-#include <raylib.h>
 
 #include "../include/debug.h"
-#include "../include/arc.h"
 
 
 #define MIN_TRACKS 1		// Track numbers range from 1 - 35
 #define MAX_TRACKS 35
 #define BLOCK_SIZE 0x100	// A single disk sector is 256 Bytes
-#define TRACK_GAPS 2		// How many pixels between each track
-#define SECTOR_GAPS 8.0f	// How much of a gap to leave between each sector
-#define SPINDLE_RADIUS 50	// in px
-#define DISK_RADIUS 450		// in px
-#define DISK_CENTRE_X 500	// Disk centre pos
-#define DISK_CENTRE_Y 500
 #define DIR_HEADER_SIZE 113	// From 144 to 256 plus null-terminator
+#define DSK_DESCRIPTION_SIZE (DIR_HEADER_SIZE + 1)	// Buffer size that always fits DSK_GetDescription
+#define DSK_NAME_SIZE 18		// Buffer size that always fits DSK_GetName
 #define MAX_DIR_ENTRIES 144	// 18 directory sectors; each with 8 entries; rounded up
 
 
@@ -30,12 +24,6 @@
 //	Type Definitions
 //	
 
-typedef enum {
-	DSK_DRAW_NORMAL,
-	DSK_DRAW_HIGHLIGHT,
-	DSK_DRAW_SELECTED,
-} DSK_DrawMode;
-
 typedef struct {
 	uint8_t track;
 	uint8_t sector;
@@ -103,6 +91,11 @@ bool DSK_PositionsEqual(DSK_Position a, DSK_Position b);
 //	Returns -1 if the position is invalid
 int DSK_PositionToIndex(DSK_Position pos);
 
+//	Converts an index in blocks back to its disk position
+//
+//	Returns { 0, 0 } (an invalid position) if the index is out of range
+DSK_Position DSK_IndexToPosition(int index);
+
 //	Seeks to the start of a given sector in a disk image file pointer
 //
 //	Returns 0 on success or
@@ -110,10 +103,6 @@ int DSK_PositionToIndex(DSK_Position pos);
 //		2 - if pos is invalid
 int DSK_File_SeekPosition(FILE *f_disk, DSK_Position pos);
 
-//	Gets the disk position of the sector the mouse is hovering over
-//
-DSK_Position DSK_GetHoveredSector();
-
 //	---- Retrieving Data
 
 //	Fetches an arbitrary block of data from a given sector
@@ -127,58 +116,47 @@ int DSK_File_GetData(FILE *f_disk, DSK_Position pos, void *buf, size_t bufsz);
 //
 //	Returns 0 on success, otherwise:
 //		1 = Received NULL argument pointer
+//		2 = The BAM doesn't point to a valid directory sector
+//		3 = The BAM's format byte isn't 'A'
+//		4 = The directory chain loops back or has more than MAX_DIR_ENTRIES
+//			entries; the entries read up to there are kept
 int DSK_File_ParseDirectory(FILE *f_disk, DSK_Directory *dir, bool ignore_bam);
 
 //	---- Debug Printing
 
-//	Prints out the contents of the BAM
+//	Prints out the contents of the BAM to `f_out`
 //
-void DSK_PrintBAM(uint32_t bam[MAX_TRACKS]);
+void DSK_PrintBAM(FILE *f_out, uint32_t bam[MAX_TRACKS]);
 
-//	Prints out the contents of the Directory
+//	Prints out the contents of the Directory to `f_out`
 //
-void DSK_PrintDirectory(DSK_Directory dir);
-
-//	---- Getting Strings & Colours
+void DSK_PrintDirectory(FILE *f_out, DSK_Directory dir);
 
-//	Gets the full directory header text
-//
-// Internal buffer; do not `free` !
-// Replaces "shifted" spaces and trims leading/trailing spaces
-char *DSK_GetDescription(DSK_Directory dir);
+//	---- Getting Strings
 
-//	Gets a disk name from the directory header
+//	Gets the full directory header text into `buf`
 //
-// Internal buffer; do not `free` !
-// Limits the name to 17 chars trims and replaces shifted spaces
-char *DSK_GetName(DSK_Directory dir);
-
-//	Get a constant string for the name of a sector-type
+//	Replaces "shifted" spaces and trims leading/trailing spaces; a buffer of
+//	DSK_DESCRIPTION_SIZE always fits it. Safe to call from several threads.
 //
-const char *DSK_Sector_GetTypeName(DSK_SectorType type);
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The buffer is too small; it holds as much as fits
+int DSK_GetDescription(DSK_Directory dir, char *buf, size_t bufsz);
 
-//	Get a colour for a sector based on its type
+//	Gets a disk name from the directory header into `buf`
 //
-Color DSK_Sector_GetTypeColour(DSK_SectorType type);
-
-//	---- Drawing Functions
-
-//	Draws a sector to the screen
+//	Limits the name to 17 chars, trims and replaces shifted spaces; a buffer
+//	of DSK_NAME_SIZE always fits it. Safe to call from several threads.
 //
-void DSK_Sector_Draw(DSK_Directory dir, DSK_Position pos, DSK_DrawMode mode, Color clr);
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The buffer is too small; it holds as much as fits
+int DSK_GetName(DSK_Directory dir, char *buf, size_t bufsz);
 
-//	Draw a block of sector-data to the screen in fixed-width ASCII columns
-//
-//	The argument `hex_mode` determines whether to print the hexadecimal values or their ASCII characters
-//	The last argument `show_offset` determines whether to include the byte count
-//	before each row:
-//
-//		Off:				On:
-//		| A B C D |			0x00 | A B C D |	
-//		| E F G H |			0x04 | E F G H |	
-//		| I J K L |			0x08 | I J K L |	
+//	Get a constant string for the name of a sector-type
 //
-void DSK_DrawData(int x, int y, void *buf, size_t bufsz, bool hex_mode, bool show_offset);
+const char *DSK_Sector_GetTypeName(DSK_SectorType type);
 
 
 #endif
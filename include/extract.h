@@ -0,0 +1,122 @@
+#ifndef EXTRACT_H
+#define EXTRACT_H
+
+//	Helper functions for extracting the files of a disk image into the
+//	host's file system
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define EXT_MAX_THREADS 16
+#define EXT_P00_MAGIC "C64File"
+#define EXT_P00_HEADER_SIZE 26		// Magic, null, 16 byte name, null, REL record size
+#define EXT_PATH_SIZE 4096
+
+#define EXT_FLAG_P00 0x01			// Write PC64 files (.P00 / .S00 / .U00) instead of plain ones
+#define EXT_FLAG_LIST_FILES 0x02	// Report every file written, not just the broken ones
+
+
+//
+//	Type Definitions
+//
+
+typedef enum {
+	EXTCHAIN_OK = 0x00,
+	EXTCHAIN_INVALID_LINK = 0x01,	// A block links to a position that isn't on the disk
+	EXTCHAIN_LOOP = 0x02,			// The chain runs back into itself
+	EXTCHAIN_INVALID_END = 0x03,	// The last block's used-byte count is impossible
+	EXTCHAIN_BLANK_BLOCK = 0x04,	// A block is all zeroes; most likely it was never transferred
+} EXT_ChainStatus;
+
+//	Where a file's data is on the disk
+typedef struct {
+	EXT_ChainStatus status;
+	DSK_Position broken_pos;	// Block the chain broke at, if it did
+	int num_blocks;
+	size_t size;				// Bytes of data in the file, without the links
+} EXT_Chain;
+
+//	Totals of an extraction
+typedef struct {
+	int files_written;
+	int files_broken;		// Files that weren't written since their chain is broken
+	int files_skipped;		// Deleted, relative & unknown files
+	int images_failed;		// Images that couldn't be read at all
+	uint64_t bytes;
+} EXT_Stats;
+
+
+//
+//	Function Declarations
+//
+
+//	Follows the chain of blocks of a file through an in-memory disk image
+//
+//	The image holds NYBLOG_SECTOR_COUNT blocks in order. The last block's
+//	second byte is the index of its last used byte, so only the bytes up to
+//	it count towards the size.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The chain is broken; see chain->status
+int EXT_FollowChain(const uint8_t *image, DSK_Position head, EXT_Chain *chain);
+
+//	Gets a file name for a directory entry that's safe to use on the host
+//
+//	Characters that aren't allowed in file names are replaced with '_', and
+//	the extension matches the file type (and EXT_FLAG_P00).
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The buffer is too small
+int EXT_GetHostFilename(DSK_DirEntry entry, uint32_t flags, char *buf, size_t bufsz);
+
+//	Gets a constant char pointer to a description of a chain's status
+//
+const char *EXT_GetChainStatusName(EXT_ChainStatus status);
+
+//	Writes a single file of an in-memory disk image to `filename`
+//
+//	The chain is checked first, so nothing is written for a broken file.
+//	The data is then written block by block, straight from the image.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The file's chain is broken; see chain
+//		3 = Failed to write the file
+int EXT_ExtractFile(const uint8_t *image, DSK_DirEntry entry, const char *filename, uint32_t flags, EXT_Chain *chain);
+
+//	Writes every PRG, SEQ & USR file of an in-memory disk image to a directory
+//
+//	Files with the same name get a number added to them. Broken chains are
+//	written to `f_report` (if it isn't NULL) instead of the file, as are the
+//	files written with EXT_FLAG_LIST_FILES.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to create the directory
+//		3 = Failed to write a file
+int EXT_ExtractDirectory(const uint8_t *image, DSK_Directory *dir, const char *directory, uint32_t flags, FILE *f_report, EXT_Stats *stats);
+
+//	Extracts every file of several disk images on several threads
+//
+//	With a single image, its files are written to `directory`; otherwise each
+//	image gets a directory of its own in there, named after it; images of the
+//	same name get "~N" added to theirs. Reports are
+//	written to `f_report` in the order of the images. `num_threads` of 0
+//	uses every processor.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to create the directory
+//		3 = Some images couldn't be read or written; see stats
+int EXT_ExtractImages(char **filenames, int num_images, const char *directory, uint32_t flags, int num_threads, FILE *f_report, EXT_Stats *stats);
+
+
+#endif
@@ -0,0 +1,114 @@
+#ifndef GUI_H
+#define GUI_H
+
+//	Helper functions for drawing the disk & its analysis with raylib
+//
+//	Everything that needs raylib lives here, so the rest of disekt can be
+//	built into libdisekt without it
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <math.h>
+#include <raylib.h>
+
+#include "../include/debug.h"
+#include "../include/arc.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+
+#define TRACK_GAPS 2		// How many pixels between each track
+#define SECTOR_GAPS 8.0f	// How much of a gap to leave between each sector
+#define SPINDLE_RADIUS 50	// in px
+#define DISK_RADIUS 450		// in px
+#define DISK_CENTRE_X 500	// Disk centre pos
+#define DISK_CENTRE_Y 500
+
+#define KEYCODE_SHIFT 340
+#define KEYCODE_DEBUG_INT_INC 334
+#define KEYCODE_DEBUG_INT_DEC 333
+#define KEYCODE_DEBUG_VIEW_TOGGLE 294
+
+extern int g_debug_int;
+extern double g_debug_prog;
+extern bool g_show_debug_view;
+
+
+//
+//	Type Definitions
+//
+
+typedef enum {
+	DSK_DRAW_NORMAL,
+	DSK_DRAW_HIGHLIGHT,
+	DSK_DRAW_SELECTED,
+} DSK_DrawMode;
+
+
+//
+//	Function Declarations
+//
+
+//	---- Colours
+
+//	Get a colour for a sector based on its type
+//
+Color DSK_Sector_GetTypeColour(DSK_SectorType type);
+
+//	Get a colour for a sector based on its state
+//
+//	*Deprecated*
+Color ANA_GetStatusColour(ANA_Status status);
+
+//	Get a colour for a sector based on which file it belongs to
+//
+Color ANA_GetFileColour(DSK_Directory dir, ANA_SectorInfo entry, bool is_hovered, bool is_selected);
+
+//	Get a colour for a nyb-log parsing error code
+//
+Color ANA_GetParseErrorColour(int err_code);
+
+//	Get a colour for a DOS disk error code
+//
+Color ANA_GetDiskErrorColour(uint8_t  err_code);
+
+//	Get a colour for how often a sector fails, from 0 (green) to 1 (red)
+//
+Color HMP_GetHeatColour(float heat);
+
+//	---- Drawing Functions
+
+//	Draws a sector to the screen
+//
+void DSK_Sector_Draw(DSK_Directory dir, DSK_Position pos, DSK_DrawMode mode, Color clr);
+
+//	Draw a block of sector-data to the screen in fixed-width ASCII columns
+//
+//	The argument `hex_mode` determines whether to print the hexadecimal values or their ASCII characters
+//	The last argument `show_offset` determines whether to include the byte count
+//	before each row:
+//
+//		Off:				On:
+//		| A B C D |			0x00 | A B C D |
+//		| E F G H |			0x04 | E F G H |
+//		| I J K L |			0x08 | I J K L |
+//
+void DSK_DrawData(int x, int y, void *buf, size_t bufsz, bool hex_mode, bool show_offset);
+
+//	Gets the disk position of the sector the mouse is hovering over
+//
+DSK_Position DSK_GetHoveredSector();
+
+//	---- Debug View
+
+//	Handles events that impact the debug variables
+//
+//	returns true if the screen should be redrawn
+bool DEBUG_HandleEvents(int key);
+
+//	Draws debug info to the screen
+//
+void DEBUG_DrawDevInfo();
+
+
+#endif
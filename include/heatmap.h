@@ -0,0 +1,109 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+
+//	Counting where transfers fail across a whole archive of recon files,
+//	sector by sector and by speed zone
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define HMP_MAX_THREADS 16
+#define HMP_NUM_ZONES 4				// Tracks 1 - 17, 18 - 24, 25 - 30 & 31 - 35
+#define HMP_NUM_DISK_ERRORS 11		// Read errors 20 - 29, then every other code
+#define HMP_DISK_ERROR_OTHER 10
+
+
+//
+//	Type Definitions
+//
+
+//	Counts for a sector, or every sector of a zone
+typedef struct {
+	uint32_t transfers;			// Recons with transfer info for it
+	uint32_t attempts;			// Times it was transferred, retries included
+	uint32_t failures;			// Transfers with a disk error, a parse error or a bad checksum
+	uint32_t disk_errors[HMP_NUM_DISK_ERRORS];
+	uint32_t parse_errors;
+	uint32_t checksum_mismatches;
+	uint32_t unchecked;			// Sparse transfers whose checksum couldn't be checked without their image
+} HMP_Cell;
+
+//	Everything counted so far; the same size however many recons went into it
+typedef struct {
+	HMP_Cell sectors[NYBLOG_SECTOR_COUNT];
+	HMP_Cell zones[HMP_NUM_ZONES];
+	HMP_Cell total;
+	uint32_t num_recons;
+	uint32_t num_failed;		// Recons that couldn't be read
+	uint32_t num_without_image;	// Sparse recons whose disk image wasn't found or is a different one
+} HMP_Heatmap;
+
+
+//
+//	Function Declarations
+//
+
+//	Clears every count of a heatmap
+//
+void HMP_Init(HMP_Heatmap *heatmap);
+
+//	Gets the speed zone of a track, 0 for the outermost
+//
+//	Returns -1 if the track doesn't exist
+int HMP_GetZone(int track);
+
+//	Gets which of HMP_Cell.disk_errors a DOS error code is counted in
+//
+//	Returns -1 for 0, which isn't an error
+int HMP_GetDiskErrorBucket(uint8_t err_code);
+
+//	Counts the transfers of a recon
+//
+//	`image` is the disk image the recon belongs to; if it's NULL, the
+//	checksums of blocks whose data is only in the image aren't checked.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int HMP_AddRecon(HMP_Heatmap *heatmap, const NYB_Recon *recon, const uint8_t *image);
+
+//	Adds the counts of one heatmap to another
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int HMP_Merge(HMP_Heatmap *heatmap, const HMP_Heatmap *other);
+
+//	Counts the transfers of several recon files on `num_threads` threads
+//
+//	Each thread keeps a single recon, image & heatmap, which are merged into
+//	`heatmap` at the end; the memory used doesn't grow with the number of
+//	files. Their disk images are expected next to them with the extension `.d64`.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Some recons couldn't be read; see `heatmap->num_failed`
+int HMP_AddRecons(HMP_Heatmap *heatmap, char **filenames, int num_recons, int num_threads);
+
+//	Gets the share of a cell's transfers that failed, from 0 to 1
+//
+float HMP_GetFailureRate(const HMP_Cell *cell);
+
+//	Writes the counts of every zone & the `max_sectors` sectors that fail
+//	the most to `f_report`
+//
+void HMP_WriteReport(FILE *f_report, const HMP_Heatmap *heatmap, int max_sectors);
+
+//	Writes a line of counts per sector to `f_csv`
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to write the file
+int HMP_WriteCSV(FILE *f_csv, const HMP_Heatmap *heatmap);
+
+
+#endif
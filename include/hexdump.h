@@ -0,0 +1,42 @@
+#ifndef HEXDUMP_H
+#define HEXDUMP_H
+
+//	Helper functions for reading raw hex dumps of the data the arduino
+//	receives from the 1541, before it's turned into a text-log
+//
+//	Every block in a dump starts with the sync bytes `FF 00`, followed by the
+//	track & sector, 256 data bytes, the checksum (low byte first), an error
+//	code and one more byte that's unused.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define HEX_READ_BUFFER_SIZE 0x10000
+#define HEX_SYNC_HI 0xFF
+#define HEX_SYNC_LO 0x00
+
+
+//
+//	Function Declarations
+//
+
+//	Reads every block of a hex dump and passes it to a callback
+//
+//	The dump is read in a single pass with a fixed-size buffer. Bytes are
+//	written as two hex digits followed by whitespace; anything else is
+//	skipped. A dump that ends part of the way through a block still passes
+//	that block on, with the parse error NYBLOG_ERR_TRUNCATED. Blocks that
+//	don't end the way they should are reported to `info_callback`, which
+//	can be NULL.
+//
+//	Returns the number of blocks read or -1 if reading the file failed
+int HEX_ParseHexDump(const char *filename, NYB_BlockCallback callback, NYB_InfoCallback info_callback, void *user_data);
+
+
+#endif
@@ -0,0 +1,157 @@
+#ifndef INDEX_H
+#define INDEX_H
+
+//	An index of the directories of every disk image in an archive, so files
+//	can be found without opening each image. It's stored in the archive's
+//	directory and only images that changed are read again when it's updated.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/extract.h"
+
+#define IDX_MAGIC (uint32_t)(*(uint32_t *)"DKIX")
+#define IDX_VERSION 1				// Bump whenever the layout or the tokens change
+#define IDX_FILENAME ".disekt-index"
+#define IDX_EXTENSION ".d64"		// Images with this extension (in any case) are indexed
+#define IDX_PATH_SIZE 4096
+#define IDX_TOKEN_SIZE 20			// A whole file name fits, with room to spare
+
+
+//
+//	Type Definitions
+//
+
+//	A disk image as it's stored in the index
+typedef struct {
+	uint32_t path;			// Offset of the path, relative to the archive, in the string table
+	uint32_t first_file;
+	uint32_t num_files;
+	int32_t err;			// DIF_LoadImage's error if the image couldn't be read
+	int64_t mtime_ns;		// Only re-read if this or the size changes
+	int64_t size;
+	char name[17];
+	char id[3];
+} IDX_Disk;
+
+//	A directory entry as it's stored in the index
+typedef struct {
+	uint32_t disk;
+	char filename[17];
+	uint8_t type;			// DSK_SectorType
+	uint8_t chain_status;	// EXT_ChainStatus of the file's chain
+	uint8_t __padding;
+	uint16_t block_count;	// What the directory says
+	uint16_t chain_blocks;	// What the chain holds, as far as it could be followed
+} IDX_File;
+
+//	A word of file & disk names and every file it's in
+typedef struct {
+	char token[IDX_TOKEN_SIZE];		// Lower case letters & digits
+	uint32_t first_posting;
+	uint32_t num_postings;
+} IDX_Token;
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t num_disks;
+	uint32_t num_files;
+	uint32_t num_tokens;
+	uint32_t num_postings;
+	uint32_t strings_size;
+	uint32_t struct_sizes;	// Sizes of the disk, file & token structs, to catch a different layout
+} IDX_Header;
+
+//	An index that's been opened; every pointer points into the mapped file
+typedef struct {
+	void *data;
+	size_t size;
+	const IDX_Header *header;
+	const IDX_Disk *disks;
+	const IDX_File *files;
+	const IDX_Token *tokens;		// Sorted
+	const uint32_t *postings;		// File indices of each token, sorted
+	const char *strings;
+} IDX_Index;
+
+//	What updating an index did
+typedef struct {
+	int disks_read;			// New or changed images
+	int disks_unchanged;	// Copied over from the previous index
+	int disks_failed;		// Images or directories that couldn't be read; they're kept so they aren't retried every time
+	int num_files;
+	int num_tokens;
+} IDX_Stats;
+
+
+//
+//	Function Declarations
+//
+
+//	Gets the path of the index of an archive directory
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The path didn't fit into the buffer
+int IDX_GetPath(const char *directory, char *buf, size_t bufsz);
+
+//	Indexes every image in a directory & its sub-directories
+//
+//	Images whose modification time & size are the same as in the previous
+//	index are taken from there instead of being read. The index is written to
+//	a temporary file first and then renamed, like the analysis cache. Every
+//	image that's read is listed in `f_report`, if it isn't NULL.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the directory
+//		3 = Failed to write the index
+int IDX_Update(const char *directory, FILE *f_report, IDX_Stats *stats);
+
+//	Maps the index of an archive directory into memory
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = There's no index
+//		3 = The index is from an incompatible version
+//		4 = The index is truncated or refers to something outside of itself
+int IDX_Open(const char *directory, IDX_Index *index);
+
+//	Unmaps an index
+//
+void IDX_Close(IDX_Index *index);
+
+//	Finds the files matching every term of a query
+//
+//	Terms are separated by spaces:
+//		word			A word of the file's name or its disk's name
+//		word*			A word starting with `word`
+//		type:prg		The file's type (del, seq, prg, usr or rel)
+//		health:ok		Whether the file's chain is intact (ok or broken)
+//		id:2a			The disk's ID
+//		blocks>N		The file's block count; also blocks<N & blocks=N
+//	Words are matched in any case. Matches are in the order of the index;
+//	`*num_results` counts all of them, even those past `max_results`.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Invalid term in the query
+//		3 = Failed to allocate memory
+int IDX_Query(const IDX_Index *index, const char *query, uint32_t *results, int max_results, int *num_results);
+
+//	Gets a constant char pointer to the path of a disk image in an index
+//
+const char *IDX_GetDiskPath(const IDX_Index *index, uint32_t disk);
+
+//	Writes a line for a file of an index to `f_report`: its image, name, type,
+//	block count & whether its chain is intact
+//
+void IDX_WriteMatch(FILE *f_report, const IDX_Index *index, uint32_t file);
+
+
+#endif
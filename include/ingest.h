@@ -0,0 +1,65 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+//	Helper functions for reading the arduino's log straight from a serial
+//	port or pipe while a disk is being transferred, without a text-log in between
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define ING_RING_SIZE 0x40000					// Received bytes waiting to be parsed
+#define ING_HIGH_WATER (ING_RING_SIZE / 4 * 3)	// Ask the sender to pause above this
+#define ING_LOW_WATER (ING_RING_SIZE / 4)		// ...and to carry on again below this
+#define ING_POLL_MS 200
+#define ING_FLUSH_MS 2000						// How often the image & recon file are brought up to date
+#define ING_REPORT_MS 1000
+
+
+//
+//	Type Definitions
+//
+
+//	Running totals of an ingest
+typedef struct {
+	uint64_t bytes;
+	int blocks;
+	int blocks_written;		// Blocks that made it into the image
+	int count_disk_errors;
+	int count_checksum_errors;
+	int count_parse_errors;
+	int flushes;			// How many times the image & recon file were written
+	double seconds;
+} ING_Stats;
+
+
+//
+//	Function Declarations
+//
+
+//	Reads a log stream and writes its blocks to a disk image as they arrive
+//
+//	`source` is a serial device, FIFO or "-" for stdin. Serial devices are
+//	switched to raw mode, and XOFF/XON is sent while the ring buffer is close
+//	to full; the port's speed is left as it is. The image and recon file
+//	(if `recon_filename` isn't NULL) are written every ING_FLUSH_MS, and
+//	everything in between is journaled. Reading stops at the end of the stream
+//	or on SIGINT. If `f_report` isn't NULL, progress is written to it; every
+//	block and info message of the log is written to `f_log` if it isn't NULL.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to open the source
+//		3 = Failed to open the image, recon file or journal
+//		4 = Failed to read from the source
+//		5 = Failed to write the image, recon file or journal
+//		6 = The recon file is sparse & was saved with a different image
+int ING_Ingest(const char *source, const char *disk_filename, const char *recon_filename, bool ignore_errors, FILE *f_report, FILE *f_log, ING_Stats *stats);
+
+
+#endif
@@ -0,0 +1,94 @@
+#ifndef MERGE_H
+#define MERGE_H
+
+//	Helper functions for combining several transfers of the same disk
+//	into a single best-guess disk image
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define MAX_MERGE_INPUTS 255	// Vote counters are single bytes
+
+
+//
+//	Type Definitions
+//
+
+typedef enum {
+	MRGSRC_NONE = 0x00,				// No input contained this sector
+	MRGSRC_VERIFIED = 0x01,			// Copied from an input whose checksum matched
+	MRGSRC_VOTE_VERIFIED = 0x02,	// Reconstructed by vote; result matches a transferred checksum
+	MRGSRC_VOTE = 0x03,				// Reconstructed by vote; unverified
+	MRGSRC_SINGLE = 0x04,			// Only one unverified copy was available
+} MRG_Source;
+
+//	Where the data for a single merged sector came from
+typedef struct {
+	DSK_Position pos;
+	MRG_Source source;
+	int input_index;		// Which input the data was copied from (-1 if it was voted on)
+	int copies;				// How many inputs had a copy of this sector
+	uint8_t confidence;		// 0 - 100; for votes: the share of copies backing the weakest byte
+} MRG_SectorResult;
+
+
+//
+//	Function Declarations
+//
+
+//	Merges all copies of a single sector into one block
+//
+//	`copies` must only contain blocks that were actually transferred.
+//	The output block is filled with the chosen data and transfer info.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Too many copies
+int MRG_MergeSector(NYB_DataBlock *copies, int num_copies, NYB_DataBlock *out, MRG_SectorResult *result);
+
+//	Merges several recon files sector by sector into a disk image
+//
+//	Only one block per input is held in memory at a time, so the number
+//	of inputs is only limited by MAX_MERGE_INPUTS. Sparse recon files keep
+//	the data of good transfers in their disk image, which is expected next to
+//	them with the extension `.d64`; see MRG_CheckCompanionImage.
+//	If `recon_filename` isn't NULL, the merged transfer info is also written
+//	to a new recon file. If `f_report` isn't NULL, the provenance and confidence
+//	of every sector is written to it as text.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer or no inputs
+//		2 = Failed to open an input file
+//		3 = Failed to open an output file
+//		4 = Failed to write the disk image
+//		5 = Failed to write the recon file
+//		6 = A sparse input's image is missing or a different one; nothing was written
+int MRG_MergeRecons(char **input_filenames, int num_inputs, const char *disk_filename, const char *recon_filename, FILE *f_report);
+
+//	Opens the disk image a recon file belongs to, if there is one
+//
+//	That's the file next to it with the extension `.d64` instead of its own.
+//	Returns NULL if it can't be opened.
+FILE *MRG_OpenCompanionImage(const char *recon_filename);
+
+//	Checks that a sparse recon file's image is next to it, & is the one it was saved with
+//
+//	Returns 0 on success, or if the file isn't sparse
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the recon file
+//		3 = The image is missing
+//		4 = The image is a different one
+int MRG_CheckCompanionImage(const char *recon_filename);
+
+//	Gets a constant char pointer to the name of a merge source
+//
+const char *MRG_GetSourceName(MRG_Source source);
+
+
+#endif
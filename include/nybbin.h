@@ -0,0 +1,101 @@
+#ifndef NYBBIN_H
+#define NYBBIN_H
+
+//	Helper functions for a compact binary version of the text-log,
+//	with an index to find every transfer attempt of a sector straight away
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define NYBBIN_MAGIC (uint32_t)(*(uint32_t *)"NYBX")
+#define NYBBIN_VERSION 1
+#define NYBBIN_INDEX_SIZE 683		// One index entry for every sector on a disk
+#define NYBBIN_MAX_MESSAGE 256		// Longest info message passed on by the reader
+
+
+//
+//	Struct Declarations
+//
+
+//	Where the attempts of a single sector are listed in the attempt table
+typedef struct {
+	uint32_t first;
+	uint32_t count;
+} NYB_BinIndexEntry;
+
+//	File header; records start straight after it
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint64_t record_count;
+	uint64_t block_count;
+	uint64_t records_offset;
+	uint64_t attempts_offset;		// Table of record offsets, grouped by sector
+	NYB_BinIndexEntry index[NYBBIN_INDEX_SIZE];
+} NYB_BinHeader;
+
+//	Every entry of the text-log in the order it arrived in
+//
+//	Block records are followed by the 256 data bytes, info records by the message text
+typedef struct {
+	uint8_t type;			// NYB_LogLineType of the line that ended this record
+	uint8_t track_num;
+	uint8_t sector_index;
+	uint8_t err_code;
+	uint16_t checksum;
+	uint8_t parse_error;
+	uint8_t __padding1;
+	uint32_t length;		// Number of payload bytes after the record
+} NYB_BinRecord;
+
+//	An open binary log for looking up sectors
+typedef struct {
+	FILE *f_bin;
+	NYB_BinHeader header;
+} NYB_BinLog;
+
+
+//
+//	Function Declarations
+//
+
+//	Converts a text-log into a binary log
+//
+//	Returns the number of records written or -1 if it fails
+long NYB_Bin_Convert(const char *log_filename, const char *bin_filename);
+
+//	Opens a binary log for looking up sectors
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to open the file
+//		3 = Not a binary log, or an unsupported version
+int NYB_Bin_Open(NYB_BinLog *log, const char *filename);
+
+//	Gets how many times a sector was transferred
+//
+//	Returns 0 for invalid positions
+int NYB_Bin_GetAttemptCount(NYB_BinLog *log, DSK_Position pos);
+
+//	Reads one transfer attempt of a sector, in the order they arrived in
+//
+//	Like the blocks of the log reader, its block_status is 0x01.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Invalid position or attempt number
+//		3 = Failed to read the record
+int NYB_Bin_ReadAttempt(NYB_BinLog *log, DSK_Position pos, int attempt, NYB_DataBlock *block);
+
+//	Closes a binary log
+//
+void NYB_Bin_Close(NYB_BinLog *log);
+
+
+#endif
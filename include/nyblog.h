@@ -10,11 +10,29 @@
 #include <stdio.h>
 #include <ctype.h>
 #include <string.h>
+#include <sys/types.h>
 #include "../include/debug.h"
 #include "../include/disk.h"
 
 
 #define NYBLOG_BIN_MAGIC (uint32_t)(*(uint32_t *)"NYBB")
+#define NYBLOG_READ_BUFFER_SIZE 0x10000		// Only this much of a log is held in memory at once
+#define NYBLOG_ERR_TRUNCATED 0x05			// Parse error for blocks the log ends in the middle of
+#define NYBLOG_CHUNK_SIZE 0x100000			// How much of a log each thread parses at once
+#define NYBLOG_MAX_THREADS 16
+#define NYBLOG_SECTOR_COUNT 683						// Sectors on a standard 35-track disk
+#define NYBLOG_IMAGE_SIZE (NYBLOG_SECTOR_COUNT * BLOCK_SIZE)
+
+#define NYBLOG_META_VERSION 2					// Recon files from before versioning count as version 0
+#define NYBLOG_META_FLAG_SPARSE 0x00000001		// Data is only stored for sectors that differ from the image
+#define NYBLOG_META_FLAG_IMAGE_HASH 0x00000002	// Header words 4 & 5 hold the hash of the image the file was saved with
+#define NYBLOG_STATUS_IN_IMAGE 0x80				// Block status bit; the recon file has no data of its own for this block
+
+#define NYBLOG_JOURNAL_MAGIC (uint32_t)(*(uint32_t *)"NYBJ")
+#define NYBLOG_JOURNAL_VERSION 1
+#define NYBLOG_JOURNAL_EXTENSION ".jnl"
+#define NYBLOG_JOURNAL_BATCH 64				// Records are synced to disk this many at a time
+#define NYBLOG_JOURNAL_SOURCE_SIZE 256
 
 
 //	
@@ -41,6 +59,95 @@ typedef struct {
 	uint8_t data[BLOCK_SIZE];
 } NYB_DataBlock;
 
+//	Called for every info message read from a log; readers don't print them themselves
+typedef void (*NYB_InfoCallback)(const char *message, void *user_data);
+
+//	Reads more of a log from somewhere other than a file; works like read(2)
+typedef ssize_t (*NYB_ReadFunction)(void *source, void *buf, size_t len);
+
+//	Reads the blocks of a log one at a time, keeping the file open
+//
+//	Both text-logs and binary logs (see nybbin.h) can be read
+typedef struct {
+	int fd;
+	NYB_ReadFunction read_fn;	// Used instead of the file if it's set
+	void *source;
+	char *buf;
+	bool owns_buf;
+	size_t buf_len;			// How many bytes of the buffer are filled
+	size_t buf_pos;			// Start of the next unread line
+	long offset;			// File offset of buf[0]
+	bool at_eof;
+	bool is_binary;			// Whether this is a binary log instead of a text-log
+	long records_end;		// Where the records of a binary log stop
+
+	bool in_block;			// Whether a BLOCK-START has been read without its BLOCK-END
+	long block_offset;		// File offset of the current block's BLOCK-START line
+	NYB_DataBlock block;	// The block currently being read
+	NYB_LogLineType end_type;	// Which line ended the last block that was returned
+
+	NYB_InfoCallback info_callback;
+	void *info_user_data;
+} NYB_LogReader;
+
+//	A disk image held in memory while blocks are written to it
+//
+//	Nothing touches the file until the image is flushed
+typedef struct {
+	const char *filename;
+	uint8_t *data;
+	size_t size;			// Never less than NYBLOG_IMAGE_SIZE; longer images keep their extra bytes
+	bool owns_data;			// False if `data` is the caller's buffer
+	FILE *f_log;			// Every block written or skipped is logged here; NULL after opening
+} NYB_DiskImage;
+
+//	Transfer info of a single sector in a version 2 recon file
+//
+//	Version 2 files hold a header, a table of these for every sector and then
+//	the data of whichever sectors need it, in the order they're referenced
+typedef struct {
+	uint8_t block_status;	// 0x00 if there's no transfer info for this sector
+	uint8_t err_code;
+	uint16_t checksum;
+	uint8_t parse_error;
+	uint8_t attempts;		// How many times the sector was transferred
+	uint16_t data_index;	// 1-based index into the data table, or 0 for data that's the same as the image
+} NYB_MetaRecord;
+
+//	The transfer info of a whole disk, held in memory
+typedef struct {
+	NYB_DataBlock blocks[NYBLOG_SECTOR_COUNT];
+	uint8_t attempts[NYBLOG_SECTOR_COUNT];
+	uint32_t added[(NYBLOG_SECTOR_COUNT + 31) / 32];	// Sectors added to it since it was loaded
+} NYB_Recon;
+
+//	A single block in an import journal
+typedef struct {
+	uint32_t sequence;		// How many blocks of the log came before this one
+	uint32_t __padding1;
+	NYB_DataBlock block;
+	uint32_t checksum;		// Of everything before it; torn records don't match
+	uint32_t __padding2;
+} NYB_JournalRecord;
+
+//	Every block of an import, written to disk as it arrives
+//
+//	The image and recon file are only written once an import finishes; until
+//	then, the journal holds everything needed to pick up where it stopped.
+typedef struct {
+	FILE *f_journal;
+	char filename[4096];
+	uint32_t sequence;		// Sequence number of the next record
+	int num_replayed;		// How many records were recovered from an interrupted import
+	bool was_discarded;		// Whether a journal of a different import was started over
+	int pending;			// Records written since the last sync
+} NYB_Journal;
+
+//	Called for every block read from a log
+//
+//	Return non-zero to stop reading
+typedef int (*NYB_BlockCallback)(NYB_DataBlock *block, void *user_data);
+
 
 //	
 //	Function Declarations
@@ -56,10 +163,65 @@ int NYB_ParseLogLine(char *line, NYB_LogLineType *type, char data[26][32]);
 //	Intended to be used internally
 int NYB_ParseDataLine(char *line, uint8_t *offset, uint8_t data[16]);
 
-//	Reads text from a file pointer until it's read a complete block
+//	Opens a transmission log for reading
 //
-//	Intended to be used internally
-int NYB_ParseLogBlock(FILE *f_log, NYB_DataBlock *block);
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to open the file
+//		3 = Failed to allocate the read buffer
+int NYB_LogReader_Open(NYB_LogReader *reader, const char *filename);
+
+//	Opens a transmission log that's read through a function, like a stream
+//
+//	Returns the same codes as NYB_LogReader_Open
+int NYB_LogReader_OpenSource(NYB_LogReader *reader, NYB_ReadFunction read_fn, void *source);
+
+//	Reads the next block from a log
+//
+//	If the log ends part of the way through a block, that block is still returned
+//	but with the parse error NYBLOG_ERR_TRUNCATED. The same goes for blocks that
+//	are interrupted by the start of another block.
+//
+//	Returns 0 if a block was read
+//		1 = Received NULL argument pointer
+//		2 = The end of the log was reached
+//		3 = Failed to read from the file
+int NYB_LogReader_Next(NYB_LogReader *reader, NYB_DataBlock *block);
+
+//	Reads all remaining blocks from a log and passes them to a callback
+//
+//	Returns the number of blocks read or -1 if reading the file failed
+int NYB_LogReader_ForEach(NYB_LogReader *reader, NYB_BlockCallback callback, void *user_data);
+
+//	Sets a function to pass every info message in the log to
+//
+void NYB_LogReader_SetInfoCallback(NYB_LogReader *reader, NYB_InfoCallback callback, void *user_data);
+
+//	Gets the file offset of the first line that hasn't been read yet
+//
+long NYB_LogReader_Tell(NYB_LogReader *reader);
+
+//	Continues reading from a file offset returned by NYB_LogReader_Tell
+//
+//	Only works for logs opened from a file
+//
+//	Returns 0 on success
+int NYB_LogReader_Seek(NYB_LogReader *reader, long offset);
+
+//	Closes a log and frees its read buffer
+//
+void NYB_LogReader_Close(NYB_LogReader *reader);
+
+//	Reads all blocks of a text-log on several threads and passes them to a callback
+//
+//	The log is split into chunks at the start of blocks, which are parsed at
+//	the same time and passed on in the order they appear in the log, so the
+//	callbacks get exactly what NYB_LogReader_ForEach would give them.
+//	`info_callback` can be NULL, and `num_threads` of 0 uses every processor.
+//	Binary logs and files that can't be read in chunks are read sequentially.
+//
+//	Returns the number of blocks read or -1 if reading the file failed
+int NYB_ParseLogParallel(const char *filename, int num_threads, NYB_BlockCallback callback, NYB_InfoCallback info_callback, void *user_data);
 
 //	Function to open and parse a transmission log
 //
@@ -74,13 +236,140 @@ int NYB_ParseLog(const char *filename, NYB_DataBlock *block_buf, int buf_len, lo
 
 //	Function to read a binary block from a meta-disk file
 //
+//	If the file has no data of its own for the block, it's zeroed and the
+//	status bit NYBLOG_STATUS_IN_IMAGE is set; the data is in the disk image.
+//
 //	Returns 0 on success
 int NYB_Meta_ReadBlock(FILE *f_meta, NYB_DataBlock *block);
 
-//	Function to write a block to an output meta-disk file
+//	Clears all transfer info from a recon
+//
+void NYB_Recon_Init(NYB_Recon *recon);
+
+//	Reads a whole recon file of any version into memory
+//
+//	`image` is the disk image the file belongs to, which holds the data
+//	of sparse files; if it's NULL, those blocks keep NYBLOG_STATUS_IN_IMAGE.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Not a recon file, or an unsupported version
+//		3 = The file is sparse & `image` isn't the one it was saved with
+int NYB_Recon_Load(NYB_Recon *recon, FILE *f_meta, const uint8_t *image);
+
+//	Checks that a disk image is the one a sparse recon file was saved with
+//
+//	`image` is NYBLOG_IMAGE_SIZE bytes of sector data, or NULL if there's no image.
+//	Files that aren't sparse don't need their image, and sparse files written
+//	before images were hashed can't be checked; both are always fine.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Not a recon file, or an unsupported version
+//		3 = The file is sparse, but there's no image
+//		4 = The image is a different one
+int NYB_Recon_CheckImage(FILE *f_meta, const uint8_t *image);
+
+//	Same as NYB_Recon_CheckImage, but reads the image from a disk image file
+//
+//	`f_disk` can be NULL if there's no image.
+//	Returns NYB_Recon_CheckImage's return code, or 5 if the image can't be read
+int NYB_Recon_CheckImageFile(FILE *f_meta, FILE *f_disk);
+
+//	Adds a transferred block to a recon, replacing any earlier attempt
+//
+//	Attempts are counted from the first time a sector is added after the
+//	recon was initialised or loaded, so importing the same log into it again
+//	doesn't count its transfers twice.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Invalid block position
+int NYB_Recon_AddBlock(NYB_Recon *recon, NYB_DataBlock *block);
+
+//	Writes a recon to a version 2 recon file
+//
+//	With an `image`, only the data of sectors that differ from it is stored,
+//	and the hash of its first NYBLOG_IMAGE_SIZE bytes is kept to check it by.
+//	The file is written to a temporary file first, which then replaces the original.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to write the file
+int NYB_Recon_Save(NYB_Recon *recon, const char *filename, const uint8_t *image);
+
+//	Opens the journal of an import into a disk image
+//
+//	If an earlier import from the same `source` was interrupted, every block
+//	that made it into its journal is passed to `replay` in order, and the
+//	journal carries on after them; any torn record at the end is dropped.
+//	A journal of a different source is started over.
 //
 //	Returns 0 on success
-int NYB_Meta_WriteBlock(FILE *f_meta, NYB_DataBlock *block);
+//		1 = Received NULL argument pointer
+//		2 = Failed to open or create the journal
+int NYB_Journal_Open(NYB_Journal *journal, const char *disk_filename, const char *source, NYB_BlockCallback replay, void *user_data);
+
+//	Empties a journal once everything in it has been written to the image & recon file
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to truncate the journal
+int NYB_Journal_Checkpoint(NYB_Journal *journal);
+
+//	Appends a block to a journal
+//
+//	Records are synced to disk in batches of NYBLOG_JOURNAL_BATCH
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to write the record
+int NYB_Journal_Append(NYB_Journal *journal, NYB_DataBlock *block);
+
+//	Closes a journal, deleting it if its import has been written out
+//
+void NYB_Journal_Close(NYB_Journal *journal, bool discard);
+
+//	Loads a disk image into memory, or starts a blank one if the file doesn't exist
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the existing image
+//		3 = Failed to allocate memory for the image
+int NYB_Image_Open(NYB_DiskImage *image, const char *filename);
+
+//	Like NYB_Image_Open, but loads the image into the caller's buffer instead
+//	of allocating one; the buffer has to outlive the image
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the existing image
+//		3 = Failed to allocate memory for the image
+//		4 = The image doesn't fit into the buffer
+int NYB_Image_OpenInto(NYB_DiskImage *image, const char *filename, uint8_t *buf, size_t bufsz);
+
+//	Writes a single block to a disk image in memory
+//
+//	Returns 0 if the block was written
+//		1 = Input was NULL
+//		2 = The block was skipped because of a transfer error
+int NYB_Image_WriteBlock(NYB_DiskImage *image, NYB_DataBlock *block, bool ignore_errors);
+
+//	Writes a disk image to its file in one go
+//
+//	The image goes to a temporary file the size of the whole image first, which
+//	then replaces the original with the same permissions; an interrupted flush
+//	leaves the old image alone.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to write the temporary file
+//		3 = Failed to replace the original file
+int NYB_Image_Flush(NYB_DiskImage *image);
+
+//	Frees a disk image without writing it; a caller's buffer is left alone
+//
+void NYB_Image_Close(NYB_DiskImage *image);
 
 //	Function to write disk data to a `.d64` disk image
 //
@@ -88,6 +377,7 @@ int NYB_Meta_WriteBlock(FILE *f_meta, NYB_DataBlock *block);
 //
 //	Returns 0 on success
 //		1 = Input was NULL
+//		2 = Failed to write the image
 int NYB_WriteToDiskImage(char *filename, NYB_DataBlock *block_buf, int buf_len, bool ignore_errors);
 
 
@@ -0,0 +1,86 @@
+#ifndef PLAN_H
+#define PLAN_H
+
+//	Helper functions for planning which sectors to re-read from the
+//	original disk, in an order that keeps the 1541 busy as little as possible
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+
+#define PLN_ROTATION_MS 200.0		// 300 RPM
+#define PLN_STEP_MS 6.0				// Head movement per track (two half-track steps)
+#define PLN_SETTLE_MS 15.0			// Head settle time after stepping
+#define PLN_LINK_MS 1750.0			// Sending one block over the arduino link
+#define PLN_START_TRACK 18			// The drive starts out on the directory track
+
+
+//
+//	Type Definitions
+//
+
+//	Timing parameters of the drive and transfer link
+typedef struct {
+	double rotation_ms;
+	double step_ms;
+	double settle_ms;
+	double link_ms;
+	int start_track;
+} PLN_DriveModel;
+
+#define PLN_DEFAULT_MODEL (PLN_DriveModel){ PLN_ROTATION_MS, PLN_STEP_MS, PLN_SETTLE_MS, PLN_LINK_MS, PLN_START_TRACK }
+
+//	A single sector that should be transferred again
+typedef struct {
+	DSK_Position pos;
+	ANA_Status status;		// Why this sector needs to be re-read
+	double start_ms;		// Estimated time the read begins at, from the start of the plan
+} PLN_Entry;
+
+typedef struct {
+	PLN_Entry entries[MAX_ANALYSIS_ENTRIES];
+	int num_entries;
+	int count_missing;
+	int count_corrupted;
+	int count_bad;
+	double total_ms;		// Estimated time for the whole plan
+	double full_dump_ms;	// Estimated time for transferring the whole disk again
+} PLN_Plan;
+
+
+//
+//	Function Declarations
+//
+
+//	Checks whether a sector should be part of a re-transfer plan
+//
+bool PLN_NeedsRetransfer(ANA_SectorInfo info);
+
+//	Creates a re-transfer plan for all missing, corrupted and bad sectors
+//
+//	Tracks are visited in a single sweep starting from the nearer end, and
+//	the sectors on each track are ordered by whichever one passes under the
+//	head soonest after the previous block has been sent over the link.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int PLN_CreatePlan(ANA_DiskInfo *analysis, PLN_DriveModel model, PLN_Plan *plan);
+
+//	Estimates how long a sequential transfer of the whole disk takes
+//
+double PLN_EstimateFullDump(PLN_DriveModel model);
+
+//	Writes a plan to a text file
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int PLN_WritePlan(FILE *f_plan, PLN_Plan *plan, const char *disk_filename);
+
+
+#endif
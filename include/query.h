@@ -0,0 +1,75 @@
+#ifndef QUERY_H
+#define QUERY_H
+
+//	Expressions over the attributes of sectors, like "!free && !checksum_match",
+//	evaluated to a bitset of the sectors they match
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+
+#define QRY_MAX_OPS 64			// Names & operators in an expression
+#define QRY_MAX_TEXT 256
+
+
+//
+//	Type Definitions
+//
+
+typedef enum {
+	QRYOP_ATTRIBUTE,	// Pushes the sectors with an attribute
+	QRYOP_FILE,			// Pushes the blocks of a directory entry
+	QRYOP_TRACK,		// Pushes the sectors of a track
+	QRYOP_NOT,
+	QRYOP_AND,
+	QRYOP_OR,
+} QRY_OpType;
+
+typedef struct {
+	uint8_t type;		// QRY_OpType
+	uint8_t arg;		// Attribute, entry or track number
+} QRY_Op;
+
+//	A parsed expression, in postfix order
+typedef struct {
+	QRY_Op ops[QRY_MAX_OPS];
+	int num_ops;
+	char text[QRY_MAX_TEXT];	// What it was parsed from
+} QRY_Query;
+
+
+//
+//	Function Declarations
+//
+
+//	Parses an expression
+//
+//	Names are those of ANA_GetAttributeName (e.g. "free", "status:missing",
+//	"type:prg"), "file:N" for the blocks of directory entry N and "track:N".
+//	They're combined with "!", "&&", "||" and parentheses; "&&" binds tighter.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Syntax error at `*err_pos`
+//		3 = Unknown name at `*err_pos`
+//		4 = The expression is too long
+int QRY_Parse(const char *str, QRY_Query *query, int *err_pos);
+
+//	Works out which sectors of an analysis match an expression
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The expression is invalid
+int QRY_Evaluate(const QRY_Query *query, const ANA_DiskInfo *analysis, ANA_Bitset *result);
+
+//	Gets a constant char pointer to a description of a QRY_Parse error
+//
+const char *QRY_GetErrorName(int err_code);
+
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SEARCH_H
+#define SEARCH_H
+
+//	Finding byte signatures & PETSCII text in the sectors of a disk image,
+//	including matches that carry on into the next block of a file
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/nyblog.h"
+
+#define SCH_MAX_PATTERN 64		// Bytes; always less than a block's data, so a match spans 2 blocks at most
+#define SCH_MAX_HITS 1024		// Hits past this many are only counted
+#define SCH_MAX_THREADS 16
+#define SCH_BITSET_WORDS ((NYBLOG_SECTOR_COUNT + 31) / 32)
+
+
+//
+//	Type Definitions
+//
+
+//	What to look for; every byte is ANDed with its mask before it's compared
+typedef struct {
+	uint8_t value[SCH_MAX_PATTERN];
+	uint8_t mask[SCH_MAX_PATTERN];	// 0x00 for wildcards
+	int len;
+} SCH_Pattern;
+
+//	Where a match starts & ends
+typedef struct {
+	DSK_Position pos;		// Block the match starts in
+	uint16_t offset;		// Byte of that block it starts at
+	DSK_Position end_pos;	// Block it ends in; the next one of the file if it spans two
+	int dir_index;			// Entry of the file the block belongs to, or -1
+} SCH_Hit;
+
+//	Every match of a pattern on a disk
+typedef struct {
+	uint32_t hit_sectors[SCH_BITSET_WORDS];		// Bit per sector index a match has bytes in
+	SCH_Hit hits[SCH_MAX_HITS];					// In order of their position on the disk
+	int num_hits;								// All of them, even those past SCH_MAX_HITS
+} SCH_Result;
+
+//	Totals of a search through several images
+typedef struct {
+	int images_matched;
+	int images_failed;		// Images that couldn't be read
+	uint64_t hits;
+} SCH_Stats;
+
+
+//
+//	Function Declarations
+//
+
+//	Reads a pattern from a string
+//
+//	Hex patterns are pairs of hex digits, optionally separated by spaces, with
+//	"??" matching any byte (e.g. "A9 ?? 8D 20 D0"). Text is matched as PETSCII:
+//	letters match either case, whichever character set the C64 was in.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = The pattern is empty or only has wildcards
+//		3 = The pattern is longer than SCH_MAX_PATTERN
+//		4 = Invalid hex digits
+int SCH_ParsePattern(const char *str, bool is_hex, SCH_Pattern *pattern);
+
+//	Searches every block of an in-memory disk image of NYBLOG_SECTOR_COUNT blocks
+//
+//	Matches that cross from a block into the next one of a file's chain are
+//	found by following the chains of `dir`, which can be NULL to only search
+//	within blocks. The links at the start of each block are skipped there.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int SCH_SearchImage(const uint8_t *image, const DSK_Directory *dir, const SCH_Pattern *pattern, SCH_Result *result);
+
+//	Returns true if a match has bytes in the sector at `index`
+//
+bool SCH_IsHit(const SCH_Result *result, int index);
+
+//	Writes a line per hit to `f_report`, prefixed with `filename` if it isn't NULL
+//
+void SCH_WriteHits(FILE *f_report, const char *filename, const DSK_Directory *dir, const SCH_Result *result);
+
+//	Searches several disk images on several threads
+//
+//	Hits are written to `f_report` in the order of the images, like grep
+//	does. `num_threads` of 0 uses every processor.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Some images couldn't be read; see stats
+int SCH_SearchImages(char **filenames, int num_images, const SCH_Pattern *pattern, int num_threads, FILE *f_report, SCH_Stats *stats);
+
+
+#endif
@@ -0,0 +1,179 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+//	Loading a disk from start to finish: importing its log, reading the
+//	directory and analysing it, either straight away or on a worker thread
+//	that publishes what it has after every step
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "../include/debug.h"
+#include "../include/disk.h"
+#include "../include/analysis.h"
+#include "../include/nyblog.h"
+#include "../include/arena.h"
+
+#define SES_IMAGE_SIZE (NYBLOG_IMAGE_SIZE + NYBLOG_SECTOR_COUNT)	// Room for an error byte per sector
+
+//	Everything a session takes from its arena
+#define SES_ARENA_SIZE ( \
+	ARN_SIZE(sizeof(DSK_Directory)) * 3 \
+	+ ARN_SIZE(sizeof(ANA_DiskInfo)) * 3 \
+	+ ARN_SIZE(sizeof(NYB_Recon)) \
+	+ ARN_SIZE(SES_IMAGE_SIZE) \
+)
+
+
+//
+//	Type Definitions
+//
+
+//	What to load and how
+typedef struct {
+	const char *disk_filename;
+	const char *recon_filename;		// Can be NULL
+	const char *import_filename;	// Log or hex dump to import first; can be NULL
+	bool import_is_hexdump;
+	bool ignore_invalid_bam;		// Use a blank BAM if the disk's is invalid
+	bool ignore_image_write;		// Write blocks with transfer errors to the image too
+	bool use_cache;
+	FILE *f_log;					// What's done is logged here; NULL to log nothing
+} SES_Options;
+
+typedef enum {
+	SESSTAGE_IDLE,
+	SESSTAGE_IMPORT,		// Reading the log or hex dump into the image
+	SESSTAGE_DIRECTORY,		// Reading track 18 & looking for a cached analysis
+	SESSTAGE_ANALYSIS,		// Running the analysis passes
+	SESSTAGE_DONE,
+	SESSTAGE_FAILED,		// See err & err_detail
+	SESSTAGE_CANCELLED,
+} SES_Stage;
+
+//	How far a session has got
+typedef struct {
+	SES_Stage stage;
+	ANA_Pass pass;			// Pass being run while analysing
+	int blocks_imported;
+	float progress;			// 0.0 - 1.0 over the whole session
+	int err;				// Return code of SES_Load, once it's failed
+	int err_detail;			// Error code of the step that failed
+} SES_Progress;
+
+//	A disk being loaded
+//
+//	All of a disk's data lives in the session's arena, which is allocated
+//	once and can be reused for any number of disks with SES_Reset.
+//	Everything but `options`, `view_dir` & `view` belongs to the worker while
+//	it's running; only read the results through SES_Poll until SES_Finish
+//	has returned.
+typedef struct {
+	SES_Options options;
+	ARN_Arena arena;
+	DSK_Directory *dir;
+	ANA_DiskInfo *analysis;			// Results of the passes finished so far
+	NYB_Recon *recon;				// Transfer info collected while importing
+	uint8_t *image;					// Image being imported into, SES_IMAGE_SIZE bytes
+
+	DSK_Directory *view_dir;		// The latest snapshot SES_Poll got; only the polling thread uses these
+	ANA_DiskInfo *view;
+
+	pthread_mutex_t lock;			// Guards everything below
+	pthread_t thread;
+	bool is_threaded;
+	bool cancel_requested;
+	SES_Progress progress;
+	int generation;					// Bumped every time a snapshot is published
+	DSK_Directory *snapshot_dir;
+	ANA_DiskInfo *snapshot;
+} SES_Session;
+
+
+//
+//	Function Declarations
+//
+
+//	Sets up a session & allocates its arena; nothing is read until it's
+//	loaded or started
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to allocate the arena
+int SES_Init(SES_Session *session, SES_Options options);
+
+//	Gets a session ready for another disk, reusing its arena
+//
+//	The previous disk's results are gone afterwards; a worker that's still
+//	running is cancelled & waited for first.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+int SES_Reset(SES_Session *session, SES_Options options);
+
+//	Loads the disk on the calling thread; the results are in session->dir &
+//	session->analysis afterwards, until the session is reset or closed
+//
+//	An import writes the image (and recon file) once the whole log is read;
+//	everything is journaled until then, so an interrupted or cancelled import
+//	carries on where it stopped next time. Unless `use_cache` is false, an
+//	unchanged cached analysis is loaded instead of analysing the disk again.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to read the log file
+//		3 = Failed to read the disk image to import into
+//		4 = Failed to open the import journal
+//		5 = Failed to write the import journal
+//		6 = Failed to write the disk image
+//		7 = Failed to write the recon file
+//		8 = Failed to read the disk image
+//		9 = Failed to read the recon file
+//		10 = Failed to parse track 18; err_detail is DSK_File_ParseDirectory's error
+//		11 = Failed to analyse the disk; err_detail is the pass' error
+//		12 = Failed to gather the disk's stats
+//		13 = Cancelled
+//		14 = The recon file is sparse & was saved with a different disk image
+int SES_Load(SES_Session *session);
+
+//	Loads the disk on a worker thread
+//
+//	A snapshot is published once the BAM has been read, and again after every
+//	analysis pass, so the disk can be shown long before it's finished.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to start the thread
+int SES_Start(SES_Session *session);
+
+//	Gets the progress of a session, and the latest snapshot if it's newer than
+//	`*generation`
+//
+//	The snapshot is copied to session->view_dir & session->view, which stay
+//	as they are until the next newer snapshot. `*generation` starts at 0.
+//
+//	Returns true if a newer snapshot was copied
+bool SES_Poll(SES_Session *session, int *generation, SES_Progress *progress);
+
+//	Asks the worker to stop after the block or pass it's on
+//
+void SES_Cancel(SES_Session *session);
+
+//	Waits for the worker to stop
+//
+//	Returns SES_Load's return code
+int SES_Finish(SES_Session *session);
+
+//	Cancels & waits for the worker if there is one, and frees the session's arena & lock
+//
+void SES_Close(SES_Session *session);
+
+//	Gets a constant char pointer to a description of what a session is doing
+//
+const char *SES_GetStageName(SES_Stage stage);
+
+
+#endif
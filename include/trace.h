@@ -0,0 +1,76 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+//	Timing spans of the slow parts of disekt, written as a Chrome trace
+//	(chrome://tracing, Perfetto) so every thread's work can be seen on one
+//	timeline. Spans only exist in builds with DISEKT_TRACE defined; without
+//	it, TRC_SCOPE compiles to nothing.
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include "../include/debug.h"
+
+#define TRC_MAX_EVENTS 0x100000		// Spans past this many are dropped
+#define TRC_DETAIL_SIZE 64
+#define TRC_NAME_SIZE 32
+
+
+//
+//	Type Definitions
+//
+
+//	A span that's been started; ended when it goes out of scope
+typedef struct {
+	const char *name;		// NULL if tracing is off
+	const char *detail;		// Can be NULL
+	double start_us;
+} TRC_Span;
+
+#ifdef DISEKT_TRACE
+#define TRC_SCOPE(name) TRC_Span __trc_span __attribute__((cleanup(TRC_EndSpan))) = TRC_BeginSpan(name, NULL)
+#define TRC_SCOPE_DETAIL(name, detail) TRC_Span __trc_span __attribute__((cleanup(TRC_EndSpan))) = TRC_BeginSpan(name, detail)
+#else
+#define TRC_SCOPE(name)
+#define TRC_SCOPE_DETAIL(name, detail)
+#endif
+
+
+//
+//	Function Declarations
+//
+
+//	Starts recording spans, to be written to `filename` by TRC_Close or at exit
+//
+//	The file is created straight away, so a bad path fails here.
+//
+//	Returns 0 on success
+//		1 = Received NULL argument pointer
+//		2 = Failed to create the file
+//		3 = disekt was built without trace spans
+int TRC_Open(const char *filename);
+
+//	Writes the recorded spans & stops recording
+//
+//	Returns 0 on success
+//		2 = Failed to write the file
+int TRC_Close();
+
+//	Names the calling thread in the trace
+//
+void TRC_SetThreadName(const char *name);
+
+//	Starts a span; use TRC_SCOPE instead, so it ends by itself
+//
+//	`name` is the function being traced; the part before the first '_' is
+//	its category. `detail` is copied when the span ends.
+TRC_Span TRC_BeginSpan(const char *name, const char *detail);
+
+//	Ends a span & records it
+//
+void TRC_EndSpan(TRC_Span *span);
+
+
+#endif
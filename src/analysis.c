@@ -1,12 +1,9 @@
 #include "../include/analysis.h"
+#include "../include/trace.h"
 
 
-int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo *analysis) {
-	if (f_disk == NULL || analysis == NULL) return 1;
-
-	analysis->dir = dir;
-
-	// Initialise analysis struct with basic information for each sector
+//	Sector types & free flags, as far as the BAM tells them
+void __pass_bam(DSK_Directory dir, ANA_DiskInfo *analysis) {
 	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
 		for (int s=0; s<21; s++) {
 			DSK_Position pos = { t, s };
@@ -49,6 +46,17 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 					}
 				}
 			}
+		}
+	}
+}
+
+//	Sector data, transfer info & basic status of every sector
+void __pass_data(FILE *f_disk, FILE *f_meta, ANA_DiskInfo *analysis) {
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		for (int s=0; s<21; s++) {
+			DSK_Position pos = { t, s };
+			int index = DSK_PositionToIndex(pos);
+			if (index < 0) continue;
 
 			// Get the metadata entry if available
 			if (f_meta != NULL) {
@@ -61,6 +69,11 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 					analysis->sectors[index].checksum = block.checksum;
 					analysis->sectors[index].disk_err = block.err_code | 0x80;
 					analysis->sectors[index].parse_err = block.parse_error;
+
+					// Sparse recon files leave the data of good transfers in the image
+					if (block.block_status & NYBLOG_STATUS_IN_IMAGE) {
+						DSK_File_GetData(f_disk, pos, block.data, BLOCK_SIZE);
+					}
 					analysis->sectors[index].checksum_match = block.checksum == DSK_Checksum(block.data);
 
 					memcpy(analysis->sectors[index].data, block.data, BLOCK_SIZE);
@@ -99,10 +112,11 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 					if (transfer_err) analysis->sectors[index].status = SECSTAT_CORRUPTED;
 				}
 			}
-
 		}
 	}
+}
 
+void __pass_directory(FILE *f_disk, ANA_DiskInfo *analysis) {
 	//	Find the directory blocks on track 18
 	DSK_Position pos;
 	DSK_File_SeekPosition(f_disk, DSK_POSITION_BAM);
@@ -132,7 +146,9 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 		prev = index;
 		index = DSK_PositionToIndex(pos);
 	}
+}
 
+void __pass_chains(FILE *f_disk, DSK_Directory dir, ANA_DiskInfo *analysis) {
 	// Traverse each block for each directory file and assign entries to known sectors
 	for (int i=0; i<dir.num_entries; i++) {
 		DSK_DirEntry entry = dir.entries[i];
@@ -183,9 +199,10 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 		}
 
 	}
+}
 
+void __pass_blanks(ANA_DiskInfo *analysis) {
 	// Mark blocks with a known blank pattern as "empty" (not "unexpected")
-	// TODO: Refactor into separate function
 	uint8_t *blank_patterns[64];
 	int blank_matches[64];
 	int blank_pattern_count = 0;
@@ -238,7 +255,9 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 			if (analysis->sectors[i].status == SECSTAT_UNEXPECTED) analysis->sectors[i].status = SECSTAT_EMPTY;
 		}
 	}
+}
 
+void __pass_orphans(ANA_DiskInfo *analysis) {
 	// Link together orphaned sectors to make reconnecting broken chains easier
 	for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) {
 		ANA_SectorInfo curr = analysis->sectors[i];
@@ -261,55 +280,208 @@ int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo
 			index = next;
 		}
 	}
+}
 
+void __pass_checksums(ANA_DiskInfo *analysis) {
 	// Last pass to add confirmed checksums
 	for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) {
 		ANA_SectorInfo curr = analysis->sectors[i];
 		if (!curr.has_transfer_info) continue;
 		if (curr.status == SECSTAT_GOOD && curr.checksum_match) analysis->sectors[i].status = SECSTAT_CONFIRMED;
 	}
+}
+
+int ANA_AnalysePass(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo *analysis, ANA_Pass pass) {
+	TRC_SCOPE_DETAIL("ANA_AnalysePass", ANA_GetPassName(pass));
+	if (f_disk == NULL || analysis == NULL) return 1;
+
+	switch (pass) {
+		case ANAPASS_BAM: {
+			analysis->dir = dir;
+			__pass_bam(dir, analysis);
+		} break;
+
+		case ANAPASS_DATA: __pass_data(f_disk, f_meta, analysis); break;
+		case ANAPASS_DIRECTORY: __pass_directory(f_disk, analysis); break;
+		case ANAPASS_CHAINS: __pass_chains(f_disk, dir, analysis); break;
+		case ANAPASS_BLANKS: __pass_blanks(analysis); break;
+		case ANAPASS_ORPHANS: __pass_orphans(analysis); break;
+		case ANAPASS_CHECKSUMS: __pass_checksums(analysis); break;
+		default: return 2;
+	}
+
+	return 0;
+}
+
+int ANA_AnalyseDisk(FILE *f_disk, FILE *f_meta, DSK_Directory dir, ANA_DiskInfo *analysis) {
+	TRC_SCOPE("ANA_AnalyseDisk");
+	if (f_disk == NULL || analysis == NULL) return 1;
+
+	for (int pass=0; pass<NUM_ANAPASSES; pass++) {
+		int err = ANA_AnalysePass(f_disk, f_meta, dir, analysis, pass);
+		if (err != 0) return err;
+	}
 
 	return 0;
 }
 
+const char *ANA_GetPassName(ANA_Pass pass) {
+	switch (pass) {
+		case ANAPASS_BAM: return "Reading the BAM";
+		case ANAPASS_DATA: return "Reading sector data";
+		case ANAPASS_DIRECTORY: return "Following the directory";
+		case ANAPASS_CHAINS: return "Following file chains";
+		case ANAPASS_BLANKS: return "Finding blank sectors";
+		case ANAPASS_ORPHANS: return "Linking orphaned sectors";
+		case ANAPASS_CHECKSUMS: return "Confirming checksums";
+		case NUM_ANAPASSES: break;
+	}
+	return "";
+}
+
 int ANA_GatherStats(ANA_DiskInfo *analysis) {
+	TRC_SCOPE("ANA_GatherStats");
 	if (analysis == NULL) return 1;
 
-	analysis->count_in_use = 0;
+	memset(analysis->attributes, 0, sizeof(analysis->attributes));
+	memset(analysis->files, 0, sizeof(analysis->files));
+
+	// Every flag is shifted into its bitset as it is, without branching on it
+	ANA_Bitset *sets = analysis->attributes;
+	for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) {
+		const ANA_SectorInfo *entry = &analysis->sectors[i];
+		const int w = i / 32;
+		const int b = i % 32;
+		const uint32_t bit = 1u << b;
+
+		sets[ANAATTR_FREE].words[w] |= (uint32_t) entry->is_free << b;
+		sets[ANAATTR_HAS_DATA].words[w] |= (uint32_t) entry->has_data << b;
+		sets[ANAATTR_BLANK].words[w] |= (uint32_t) entry->is_blank << b;
+		sets[ANAATTR_TRANSFER_INFO].words[w] |= (uint32_t) entry->has_transfer_info << b;
+		sets[ANAATTR_DIRECTORY_INFO].words[w] |= (uint32_t) entry->has_directory_info << b;
+		sets[ANAATTR_CHECKSUM_MATCH].words[w] |= (uint32_t) entry->checksum_match << b;
+		sets[ANAATTR_TRANSFER_ERROR].words[w] |= (uint32_t) (entry->has_transfer_info
+			&& (entry->parse_err != 0x00 || entry->disk_err != 0x80)) << b;
+		sets[ANA_GetStatusAttribute(entry->status)].words[w] |= bit;
+		sets[ANA_GetTypeAttribute(entry->type)].words[w] |= bit;
+
+		// Directory blocks hold the index of their first entry instead
+		if (entry->dir_index >= 0 && entry->dir_index < MAX_DIR_ENTRIES && entry->type != SECTYPE_DIR) {
+			analysis->files[entry->dir_index].words[w] |= bit;
+		}
+	}
+
+	int count_free = 0;
 	analysis->count_healthy = 0;
 	analysis->count_missing = 0;
 	analysis->count_bad = 0;
+	for (int w=0; w<ANA_BITSET_WORDS; w++) {
+		uint32_t in_use = ~sets[ANAATTR_FREE].words[w];
+		uint32_t healthy = sets[ANAATTR_STATUS_GOOD].words[w] | sets[ANAATTR_STATUS_PRESENT].words[w] | sets[ANAATTR_STATUS_CONFIRMED].words[w];
+		uint32_t bad = sets[ANAATTR_STATUS_BAD].words[w] | sets[ANAATTR_STATUS_CORRUPTED].words[w] | sets[ANAATTR_STATUS_INVALID].words[w];
+
+		count_free += __builtin_popcount(sets[ANAATTR_FREE].words[w]);
+		analysis->count_healthy += __builtin_popcount(in_use & healthy);
+		analysis->count_missing += __builtin_popcount(in_use & sets[ANAATTR_STATUS_MISSING].words[w]);
+		analysis->count_bad += __builtin_popcount(in_use & bad);
+	}
+	analysis->count_in_use = MAX_ANALYSIS_ENTRIES - count_free;
 
-	for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) {
-		ANA_SectorInfo entry = analysis->sectors[i];
+	return 0;
+}
 
-		if (entry.is_free) continue;
+ANA_Attribute ANA_GetStatusAttribute(ANA_Status status) {
+	switch (status) {
+		case SECSTAT_INVALID: return ANAATTR_STATUS_INVALID;
+		case SECSTAT_EMPTY: return ANAATTR_STATUS_EMPTY;
+		case SECSTAT_UNEXPECTED: return ANAATTR_STATUS_UNEXPECTED;
+		case SECSTAT_MISSING: return ANAATTR_STATUS_MISSING;
+		case SECSTAT_PRESENT: return ANAATTR_STATUS_PRESENT;
+		case SECSTAT_CORRUPTED: return ANAATTR_STATUS_CORRUPTED;
+		case SECSTAT_CONFIRMED: return ANAATTR_STATUS_CONFIRMED;
+		case SECSTAT_BAD: return ANAATTR_STATUS_BAD;
+		case SECSTAT_GOOD: return ANAATTR_STATUS_GOOD;
+		case SECSTAT_UNKNOWN: return ANAATTR_STATUS_UNKNOWN;
+	}
+	return ANAATTR_STATUS_UNKNOWN;
+}
 
-		analysis->count_in_use++;
+ANA_Attribute ANA_GetTypeAttribute(DSK_SectorType type) {
+	switch (type) {
+		case SECTYPE_DEL: return ANAATTR_TYPE_DEL;
+		case SECTYPE_SEQ: return ANAATTR_TYPE_SEQ;
+		case SECTYPE_PRG: return ANAATTR_TYPE_PRG;
+		case SECTYPE_USR: return ANAATTR_TYPE_USR;
+		case SECTYPE_REL: return ANAATTR_TYPE_REL;
+		case SECTYPE_EMPTY: return ANAATTR_TYPE_EMPTY;
+		case SECTYPE_BAM: return ANAATTR_TYPE_BAM;
+		case SECTYPE_DIR: return ANAATTR_TYPE_DIR;
+		case SECTYPE_UNKNOWN: return ANAATTR_TYPE_UNKNOWN;
+		case SECTYPE_INVALID: return ANAATTR_TYPE_INVALID;
+	}
+	return ANAATTR_TYPE_INVALID;
+}
 
-		if (entry.status == SECSTAT_GOOD
-			|| entry.status == SECSTAT_PRESENT
-			|| entry.status == SECSTAT_CONFIRMED
-		) {
-			analysis->count_healthy++;
-			continue;
-		}
+const char *ANA_GetAttributeName(ANA_Attribute attribute) {
+	switch (attribute) {
+		case ANAATTR_FREE: return "free";
+		case ANAATTR_HAS_DATA: return "data";
+		case ANAATTR_BLANK: return "blank";
+		case ANAATTR_TRANSFER_INFO: return "transfer_info";
+		case ANAATTR_DIRECTORY_INFO: return "directory_info";
+		case ANAATTR_CHECKSUM_MATCH: return "checksum_match";
+		case ANAATTR_TRANSFER_ERROR: return "transfer_error";
+		case ANAATTR_STATUS_INVALID: return "status:invalid";
+		case ANAATTR_STATUS_EMPTY: return "status:empty";
+		case ANAATTR_STATUS_UNEXPECTED: return "status:unexpected";
+		case ANAATTR_STATUS_MISSING: return "status:missing";
+		case ANAATTR_STATUS_PRESENT: return "status:present";
+		case ANAATTR_STATUS_CORRUPTED: return "status:corrupted";
+		case ANAATTR_STATUS_CONFIRMED: return "status:confirmed";
+		case ANAATTR_STATUS_BAD: return "status:bad";
+		case ANAATTR_STATUS_GOOD: return "status:good";
+		case ANAATTR_STATUS_UNKNOWN: return "status:unknown";
+		case ANAATTR_TYPE_DEL: return "type:del";
+		case ANAATTR_TYPE_SEQ: return "type:seq";
+		case ANAATTR_TYPE_PRG: return "type:prg";
+		case ANAATTR_TYPE_USR: return "type:usr";
+		case ANAATTR_TYPE_REL: return "type:rel";
+		case ANAATTR_TYPE_EMPTY: return "type:empty";
+		case ANAATTR_TYPE_BAM: return "type:bam";
+		case ANAATTR_TYPE_DIR: return "type:dir";
+		case ANAATTR_TYPE_UNKNOWN: return "type:unknown";
+		case ANAATTR_TYPE_INVALID: return "type:invalid";
+		case NUM_ANAATTRS: break;
+	}
+	return NULL;
+}
 
-		if (entry.status == SECSTAT_MISSING) {
-			analysis->count_missing++;
-			continue;
-		}
+bool ANA_Bitset_Test(const ANA_Bitset *set, int index) {
+	if (set == NULL || index < 0 || index >= MAX_ANALYSIS_ENTRIES) return false;
 
-		if (entry.status == SECSTAT_BAD
-			|| entry.status == SECSTAT_CORRUPTED
-			|| entry.status == SECSTAT_INVALID
-		) {
-			analysis->count_bad++;
-			continue;
-		}
-	}
+	return (set->words[index / 32] >> (index % 32)) & 1;
+}
 
-	return 0;
+int ANA_Bitset_Count(const ANA_Bitset *set) {
+	if (set == NULL) return 0;
+
+	int count = 0;
+	for (int w=0; w<ANA_BITSET_WORDS; w++) count += __builtin_popcount(set->words[w]);
+	return count;
+}
+
+int ANA_Bitset_Next(const ANA_Bitset *set, int index) {
+	if (set == NULL) return -1;
+
+	// Starts in the word after `index`, with the bits up to it cleared, and goes round once
+	int start = (index < -1 || index >= MAX_ANALYSIS_ENTRIES - 1) ? 0 : index + 1;
+	for (int n=0; n<=ANA_BITSET_WORDS; n++) {
+		int w = (start / 32 + n) % ANA_BITSET_WORDS;
+		uint32_t word = set->words[w];
+		if (n == 0) word &= ~0u << (start % 32);
+		if (word != 0) return w * 32 + __builtin_ctz(word);
+	}
+	return -1;
 }
 
 int ANA_GetInfo(ANA_DiskInfo analysis, DSK_Position pos, ANA_SectorInfo *entry) {
@@ -340,89 +512,6 @@ const char *ANA_GetStatusName(ANA_Status status) {
 	return "";
 }
 
-Color ANA_GetStatusColour(ANA_Status status) {
-	switch (status) {
-		case SECSTAT_EMPTY: return LIGHTGRAY;
-		case SECSTAT_UNEXPECTED: return SKYBLUE;
-
-		case SECSTAT_MISSING: return BLACK;
-		case SECSTAT_BAD: return RED;
-		case SECSTAT_CORRUPTED: return MAROON;
-
-		case SECSTAT_PRESENT: return GOLD;
-
-		case SECSTAT_GOOD: return GREEN;
-		case SECSTAT_CONFIRMED: return LIME;
-
-		case SECSTAT_UNKNOWN: return DARKGRAY;
-
-		case SECSTAT_INVALID: return MAGENTA;
-	}
-
-	return BLACK;
-}
-
-double __normalise(double x) {
-	if (x < 0.0) x = fabs(x);
-	if (x > 1.0) x -= (int) x;
-	return x;
-}
-
-double __clamp(double x) {
-	if (x < 0.0) return 0.0;
-	if (x > 1.0) return 1.0;
-	return x;
-}
-
-double __trapezoid_wave(double x) {
-	x = __normalise(x);
-
-	double m = x * 6;
-	int seg = m;
-	switch (seg) {
-		case 0: return m;
-		case 1: return 1.0;
-		case 2: return 1.0;
-		case 3: return 1.0 - (m - 3.0);
-		case 4: return 0.0;
-		case 5: return 0.0;
-	}
-	return x;
-}
-
-Color __hsv_to_rgb(double h, double s, double v) {
-	h = __normalise(h);
-	s = __normalise(s);
-	v = __normalise(v);
-
-	double c = v * s;
-	double m = v - c;
-
-	double r = c * __trapezoid_wave(h + 0.6666);
-	double g = c * __trapezoid_wave(h + 0.0001);
-	double b = c * __trapezoid_wave(h + 0.3333);
-
-	return (Color){
-		0xFF * (r + m),
-		0xFF * (g + m),
-		0xFF * (b + m),
-		0xFF
-	};
-}
-
-Color ANA_GetFileColour(DSK_Directory dir, ANA_SectorInfo entry, bool is_hovered, bool is_selected) {
-	if (entry.dir_index < 0) return LIGHTGRAY;
-
-	Color clr = __hsv_to_rgb(
-		(double) entry.dir_index / (double) dir.num_entries,
-		//(double) entry.dir_entry.pos.track / (double) 15,
-		0.5 + (is_selected ? 0.5 : 0.0),
-		0.7 + (!is_selected && is_hovered ? 0.1 : 0.0) + (is_selected ? 0.3 : 0.0)
-	);
-
-	return clr;
-}
-
 const char *ANA_GetParseErrorName(int err_code) {
 	switch (err_code) {
 		case 0: return "No Error";
@@ -430,14 +519,9 @@ const char *ANA_GetParseErrorName(int err_code) {
 		case 2: return "Checksum failed on second byte (chk_hi)";
 		case 3: return "Disk failed to read; See disk error code";
 		case 4: return "Final NULL missing; Format not quite as expected, but not necessarily fatal";
-		default: return TextFormat("Unrecognised Nyb-Log error code: %i", err_code);
+		case NYBLOG_ERR_TRUNCATED: return "Log ended part of the way through the block; Data is incomplete";
 	}
-	return "";
-}
-
-Color ANA_GetParseErrorColour(int err_code) {
-	if (err_code == 0) return GREEN;
-	return RED;
+	return "Unrecognised Nyb-Log error code";
 }
 
 const char *ANA_GetDiskErrorName(uint8_t err_code) {
@@ -479,12 +563,3 @@ const char *ANA_GetDiskErrorName(uint8_t err_code) {
 	}
 	return "Invalid Disk Error";
 }
-
-Color ANA_GetDiskErrorColour(uint8_t  err_code) {
-	uint8_t e = err_code & ~0x80;
-	if (e == 0) return GREEN;
-	if (e == 1) return BLUE;
-	if (e >= 20 && e <= 74) return RED;
-	return MAGENTA;
-}
-
@@ -0,0 +1,49 @@
+#include "../include/arena.h"
+
+
+int ARN_Init(ARN_Arena *arena, size_t size) {
+	if (arena == NULL) return 1;
+
+	arena->size = ARN_SIZE(size);
+	arena->used = 0;
+	arena->peak = 0;
+	arena->base = aligned_alloc(ARN_ALIGNMENT, arena->size);
+	if (arena->base == NULL) {
+		arena->size = 0;
+		return 2;
+	}
+
+	return 0;
+}
+
+void *ARN_Alloc(ARN_Arena *arena, size_t size) {
+	if (arena == NULL || arena->base == NULL) return NULL;
+
+	size = ARN_SIZE(size);
+	if (size > arena->size - arena->used) return NULL;
+
+	void *ptr = arena->base + arena->used;
+	arena->used += size;
+	if (arena->used > arena->peak) arena->peak = arena->used;
+	return ptr;
+}
+
+void *ARN_Calloc(ARN_Arena *arena, size_t size) {
+	void *ptr = ARN_Alloc(arena, size);
+	if (ptr != NULL) memset(ptr, 0, size);
+	return ptr;
+}
+
+void ARN_Reset(ARN_Arena *arena) {
+	if (arena == NULL) return;
+	arena->used = 0;
+}
+
+void ARN_Free(ARN_Arena *arena) {
+	if (arena == NULL) return;
+
+	free(arena->base);
+	arena->base = NULL;
+	arena->size = 0;
+	arena->used = 0;
+}
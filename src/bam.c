@@ -0,0 +1,227 @@
+#include "../include/bam.h"
+#include "../include/trace.h"
+
+#define __BAM_FILE_SIZE (NYBLOG_IMAGE_SIZE + NYBLOG_SECTOR_COUNT)		// With a byte of error info per sector
+
+
+//	Bits of the sectors a track has
+uint32_t __bam_track_mask(int track) {
+	return (1u << DSK_Track_GetSectorCount(track)) - 1;
+}
+
+const uint8_t *__bam_block(const uint8_t *image, DSK_Position pos) {
+	return image + DSK_PositionToIndex(pos) * BLOCK_SIZE;
+}
+
+//	Marks every block of a chain as used; blocks already in another chain are cross-linked
+//
+//	Returns 0 if the chain ends properly or 2 at an invalid link or a loop
+int __bam_follow(const uint8_t *image, DSK_Position pos, BAM_Report *report) {
+	uint32_t chain[MAX_TRACKS] = { 0 };
+	while (pos.track != 0) {
+		if (!DSK_IsPositionValid(pos)) return 2;
+
+		int t = pos.track - 1;
+		uint32_t bit = 1u << pos.sector;
+		if (chain[t] & bit) return 2;
+
+		chain[t] |= bit;
+		report->cross_linked[t] |= report->used[t] & bit;
+		report->used[t] |= bit;
+
+		const uint8_t *block = __bam_block(image, pos);
+		pos = (DSK_Position){ block[0], block[1] };
+	}
+	return 0;
+}
+
+//	Follows the directory & the chain of every file in it
+void __bam_follow_directory(const uint8_t *image, DSK_Position pos, BAM_Report *report) {
+	uint32_t chain[MAX_TRACKS] = { 0 };
+	while (DSK_IsPositionValid(pos)) {
+		int t = pos.track - 1;
+		uint32_t bit = 1u << pos.sector;
+		if (chain[t] & bit) break;
+
+		chain[t] |= bit;
+		report->cross_linked[t] |= report->used[t] & bit;
+		report->used[t] |= bit;
+
+		// Unlike DSK_File_ParseDirectory, a scratched entry doesn't end the directory
+		const uint8_t *block = __bam_block(image, pos);
+		for (int e=0; e<BLOCK_SIZE/32; e++) {
+			const uint8_t *entry = block + e * 32;
+			uint8_t type = entry[2] & 0x07;
+			if (entry[2] == 0x00 || type == SECTYPE_DEL) continue;
+
+			if (__bam_follow(image, (DSK_Position){ entry[3], entry[4] }, report) != 0) report->num_broken_chains++;
+			if (type == SECTYPE_REL && entry[0x15] != 0) {
+				if (__bam_follow(image, (DSK_Position){ entry[0x15], entry[0x16] }, report) != 0) report->num_broken_chains++;
+			}
+		}
+
+		pos = (DSK_Position){ block[0], block[1] };
+	}
+}
+
+int BAM_Verify(const uint8_t *image, BAM_Report *report) {
+	if (image == NULL || report == NULL) return 1;
+
+	memset(report, 0, sizeof(BAM_Report));
+
+	// The directory starts where the BAM says, or where it always does if the BAM is unreadable
+	const uint8_t *bam = __bam_block(image, DSK_POSITION_BAM);
+	DSK_Position dir_pos = { bam[0], bam[1] };
+	report->is_header_valid = DSK_IsPositionValid(dir_pos) && bam[2] == 'A';
+	if (!report->is_header_valid) dir_pos = (DSK_Position){ 18, 1 };
+
+	report->used[DSK_POSITION_BAM.track - 1] |= 1u << DSK_POSITION_BAM.sector;
+	__bam_follow_directory(image, dir_pos, report);
+
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		const uint8_t *entry = bam + BAM_ENTRIES_OFFSET + (t - 1) * BAM_ENTRY_SIZE;
+		uint32_t mask = __bam_track_mask(t);
+		uint32_t stored_free = (entry[1] | entry[2] << 8 | entry[3] << 16) & mask;
+		uint32_t used = report->used[t - 1];
+
+		report->stored_free[t - 1] = stored_free;
+		report->stored_counts[t - 1] = entry[0];
+		report->allocated_unused[t - 1] = mask & ~stored_free & ~used;
+		report->used_free[t - 1] = stored_free & used;
+
+		report->num_allocated_unused += __builtin_popcount(report->allocated_unused[t - 1]);
+		report->num_used_free += __builtin_popcount(report->used_free[t - 1]);
+		report->num_cross_linked += __builtin_popcount(report->cross_linked[t - 1]);
+		if (entry[0] != __builtin_popcount(stored_free)) report->num_bad_counts++;
+	}
+
+	return 0;
+}
+
+bool BAM_IsConsistent(const BAM_Report *report) {
+	if (report == NULL) return false;
+
+	return report->is_header_valid && report->num_allocated_unused == 0
+		&& report->num_used_free == 0 && report->num_bad_counts == 0;
+}
+
+void BAM_Pack(const uint32_t used[MAX_TRACKS], uint32_t bam[MAX_TRACKS]) {
+	if (used == NULL || bam == NULL) return;
+
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		uint32_t free = __bam_track_mask(t) & ~used[t - 1];
+		bam[t - 1] = __builtin_popcount(free) | free << 8;
+	}
+}
+
+int BAM_Rebuild(uint8_t *image, const BAM_Report *report) {
+	if (image == NULL || report == NULL) return 1;
+
+	// Past a broken link the rest of a file is unknown, so only the old BAM can say what it used
+	if (report->num_broken_chains > 0 && !report->is_header_valid) return 2;
+
+	uint32_t used[MAX_TRACKS];
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		used[t - 1] = report->used[t - 1];
+		if (report->num_broken_chains > 0) used[t - 1] |= __bam_track_mask(t) & ~report->stored_free[t - 1];
+	}
+
+	uint8_t *bam = image + DSK_PositionToIndex(DSK_POSITION_BAM) * BLOCK_SIZE;
+	if (!report->is_header_valid) {
+		bam[0] = 18;
+		bam[1] = 1;
+		bam[2] = 'A';
+	}
+
+	uint32_t packed[MAX_TRACKS];
+	BAM_Pack(used, packed);
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		uint8_t *entry = bam + BAM_ENTRIES_OFFSET + (t - 1) * BAM_ENTRY_SIZE;
+		for (int b=0; b<BAM_ENTRY_SIZE; b++) entry[b] = (packed[t - 1] >> (b * 8)) & 0xFF;
+	}
+
+	return 0;
+}
+
+//	Writes the positions of the sectors of a bitset on a single line
+void __bam_write_sectors(FILE *f_report, const char *filename, const char *label, const uint32_t sectors[MAX_TRACKS]) {
+	if (filename != NULL) fprintf(f_report, "%s: ", filename);
+	fprintf(f_report, "  %s:", label);
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		for (uint32_t bits = sectors[t - 1]; bits != 0; bits &= bits - 1) {
+			fprintf(f_report, " %i/%i", t, __builtin_ctz(bits));
+		}
+	}
+	fprintf(f_report, "\n");
+}
+
+void BAM_WriteReport(FILE *f_report, const char *filename, const BAM_Report *report) {
+	if (f_report == NULL || report == NULL) return;
+
+	if (filename != NULL) fprintf(f_report, "%s: ", filename);
+	if (BAM_IsConsistent(report)) {
+		fprintf(f_report, "BAM OK");
+	} else {
+		fprintf(f_report, "BAM %s: %i sectors allocated but unused, %i used but free, %i tracks with a wrong free count",
+			report->is_header_valid ? "differs" : "header invalid",
+			report->num_allocated_unused, report->num_used_free, report->num_bad_counts
+		);
+	}
+	if (report->num_cross_linked > 0) fprintf(f_report, "; %i cross-linked sectors", report->num_cross_linked);
+	if (report->num_broken_chains > 0) fprintf(f_report, "; %i broken chains", report->num_broken_chains);
+	fprintf(f_report, "\n");
+
+	if (report->num_allocated_unused > 0) __bam_write_sectors(f_report, filename, "Allocated but unused", report->allocated_unused);
+	if (report->num_used_free > 0) __bam_write_sectors(f_report, filename, "Used but free", report->used_free);
+	if (report->num_cross_linked > 0) __bam_write_sectors(f_report, filename, "Cross-linked", report->cross_linked);
+}
+
+int BAM_CheckImages(char **filenames, int num_images, const char *output_filename, FILE *f_report, BAM_Stats *stats) {
+	TRC_SCOPE("BAM_CheckImages");
+	if (filenames == NULL || stats == NULL) return 1;
+
+	memset(stats, 0, sizeof(BAM_Stats));
+
+	// The whole file is kept, so a corrected image keeps its error bytes
+	uint8_t *data = malloc(__BAM_FILE_SIZE);
+	if (data == NULL) return 1;
+
+	int err = 0;
+	for (int i=0; i<num_images; i++) {
+		FILE *f_disk = fopen(filenames[i], "rb");
+		size_t size = (f_disk != NULL) ? fread(data, sizeof(uint8_t), __BAM_FILE_SIZE, f_disk) : 0;
+		bool failed = (f_disk == NULL || ferror(f_disk));
+		if (f_disk != NULL) fclose(f_disk);
+		if (failed) {
+			if (f_report != NULL) fprintf(f_report, "%s: Failed to read the image\n", filenames[i]);
+			stats->images_failed++;
+			if (err == 0) err = 2;
+			continue;
+		}
+		if (size < NYBLOG_IMAGE_SIZE) {
+			memset(data + size, 0, NYBLOG_IMAGE_SIZE - size);
+			size = NYBLOG_IMAGE_SIZE;
+		}
+
+		BAM_Report report;
+		BAM_Verify(data, &report);
+		BAM_WriteReport(f_report, (num_images > 1) ? filenames[i] : NULL, &report);
+		if (BAM_IsConsistent(&report)) stats->images_consistent++;
+		stats->sectors_allocated_unused += report.num_allocated_unused;
+		stats->sectors_used_free += report.num_used_free;
+
+		if (i > 0 || output_filename == NULL) continue;
+
+		if (BAM_Rebuild(data, &report) != 0) {
+			err = 4;
+			continue;
+		}
+		FILE *f_out = fopen(output_filename, "wb");
+		failed = (f_out == NULL || fwrite(data, sizeof(uint8_t), size, f_out) != size);
+		if (f_out != NULL && fclose(f_out) != 0) failed = true;
+		if (failed) err = 3;
+	}
+	free(data);
+
+	return err;
+}
@@ -0,0 +1,162 @@
+#include "../include/cache.h"
+#include "../include/trace.h"
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#define CACHE_HASH_SEED 0xCBF29CE484222325ull
+#define CACHE_HASH_PRIME 0x00000100000001B3ull
+
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t struct_size;	// sizeof(ANA_DiskInfo) when it was written
+	uint32_t flags;
+	uint64_t disk_hash;
+	uint64_t recon_hash;
+} __cache_header;
+
+
+//	FNV-1a variant that consumes 8 bytes per step
+uint64_t __hash_bytes(uint64_t h, const uint8_t *buf, size_t len) {
+	size_t i = 0;
+	for (; i + 8 <= len; i += 8) {
+		uint64_t w;
+		memcpy(&w, buf + i, sizeof(uint64_t));
+		h = (h ^ w) * CACHE_HASH_PRIME;
+		h ^= h >> 32;
+	}
+	for (; i < len; i++) {
+		h = (h ^ buf[i]) * CACHE_HASH_PRIME;
+	}
+	return h;
+}
+
+uint64_t ANA_Cache_HashFile(FILE *f) {
+	if (f == NULL) return 0;
+
+	uint8_t buf[0x10000];
+	uint64_t h = CACHE_HASH_SEED;
+	uint64_t total = 0;
+
+	rewind(f);
+	size_t n = fread(buf, sizeof(uint8_t), sizeof(buf), f);
+	while (n > 0) {
+		h = __hash_bytes(h, buf, n);
+		total += n;
+		n = fread(buf, sizeof(uint8_t), sizeof(buf), f);
+	}
+	rewind(f);
+
+	// Mix in the length so zero-padding changes the hash
+	return __hash_bytes(h, (uint8_t *) &total, sizeof(total));
+}
+
+uint64_t ANA_Cache_HashBytes(const uint8_t *buf, size_t len) {
+	if (buf == NULL) return 0;
+
+	uint64_t total = len;
+	uint64_t h = __hash_bytes(CACHE_HASH_SEED, buf, len);
+	return __hash_bytes(h, (uint8_t *) &total, sizeof(total));
+}
+
+int ANA_Cache_GetKey(FILE *f_disk, FILE *f_meta, uint32_t flags, ANA_CacheKey *key) {
+	if (f_disk == NULL || key == NULL) return 1;
+
+	key->disk_hash = ANA_Cache_HashFile(f_disk);
+	key->recon_hash = ANA_Cache_HashFile(f_meta);
+	key->flags = flags;
+
+	return 0;
+}
+
+int ANA_Cache_GetPath(const char *disk_filename, ANA_CacheKey key, char *buf, size_t bufsz) {
+	if (disk_filename == NULL || buf == NULL) return 1;
+
+	int n;
+	const char *xdg = getenv("XDG_CACHE_HOME");
+	if (xdg != NULL && xdg[0] != '\0') {
+		// Make sure the cache directory exists
+		mkdir(xdg, 0755);
+		n = snprintf(buf, bufsz, "%s/%s", xdg, CACHE_DIR_NAME);
+		if (n < 0 || n >= bufsz) return 2;
+		mkdir(buf, 0755);
+
+		n = snprintf(buf, bufsz, "%s/%s/%016llX%016llX%02X%s", xdg, CACHE_DIR_NAME,
+			(unsigned long long) key.disk_hash, (unsigned long long) key.recon_hash,
+			key.flags & 0xFF, CACHE_EXTENSION
+		);
+	} else {
+		n = snprintf(buf, bufsz, "%s%s", disk_filename, CACHE_EXTENSION);
+	}
+	if (n < 0 || n >= bufsz) return 2;
+
+	return 0;
+}
+
+int ANA_Cache_Load(const char *path, ANA_CacheKey key, ANA_DiskInfo *analysis) {
+	TRC_SCOPE("ANA_Cache_Load");
+	if (path == NULL || analysis == NULL) return 1;
+
+	FILE *f_cache = fopen(path, "rb");
+	if (f_cache == NULL) return 2;
+
+	__cache_header header;
+	size_t r = fread(&header, sizeof(__cache_header), 1, f_cache);
+	if (r != 1 || header.magic != CACHE_MAGIC
+		|| header.version != CACHE_VERSION
+		|| header.struct_size != sizeof(ANA_DiskInfo)
+	) {
+		fclose(f_cache);
+		return 3;
+	}
+
+	if (header.disk_hash != key.disk_hash
+		|| header.recon_hash != key.recon_hash
+		|| header.flags != key.flags
+	) {
+		fclose(f_cache);
+		return 4;
+	}
+
+	r = fread(analysis, sizeof(ANA_DiskInfo), 1, f_cache);
+	fclose(f_cache);
+	if (r != 1) return 5;
+
+	return 0;
+}
+
+int ANA_Cache_Save(const char *path, ANA_CacheKey key, ANA_DiskInfo *analysis) {
+	TRC_SCOPE("ANA_Cache_Save");
+	if (path == NULL || analysis == NULL) return 1;
+
+	char tmp_path[CACHE_PATH_SIZE];
+	int n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+	if (n < 0 || n >= sizeof(tmp_path)) return 2;
+
+	FILE *f_cache = fopen(tmp_path, "wb");
+	if (f_cache == NULL) return 2;
+
+	__cache_header header = {
+		.magic = CACHE_MAGIC,
+		.version = CACHE_VERSION,
+		.struct_size = sizeof(ANA_DiskInfo),
+		.flags = key.flags,
+		.disk_hash = key.disk_hash,
+		.recon_hash = key.recon_hash,
+	};
+
+	size_t w = fwrite(&header, sizeof(__cache_header), 1, f_cache);
+	w += fwrite(analysis, sizeof(ANA_DiskInfo), 1, f_cache);
+	int err = fclose(f_cache);
+	if (w != 2 || err != 0) {
+		remove(tmp_path);
+		return 2;
+	}
+
+	if (rename(tmp_path, path) != 0) {
+		remove(tmp_path);
+		return 2;
+	}
+
+	return 0;
+}
@@ -0,0 +1,808 @@
+#include "../../include/cli.h"
+#include <unistd.h>
+#include <time.h>
+
+bool g_verbose_log = false;
+bool g_ignore_error_invalid_bam = false;
+bool g_ignore_error_image_write = false;
+bool g_use_analysis_cache = true;
+
+int __run_merge(CLI_Arguments args) {
+	if (args.num_inputs < 1 || args.output_filename == NULL) {
+		printf("Error: --merge requires at least one recon file and an output image (-o)\n\n");
+		CLI_Usage();
+	}
+	if (args.num_inputs > MAX_MERGE_INPUTS) {
+		printf("Error: Can't merge more than %i recon files at once\n", MAX_MERGE_INPUTS);
+		return EXIT_FAILURE;
+	}
+
+	// Keep a record of where each sector came from next to the image
+	char report_filename[4096];
+	snprintf(report_filename, sizeof(report_filename), "%s.merge", args.output_filename);
+	FILE *f_report = fopen(report_filename, "w");
+	if (f_report == NULL) {
+		printf("Error: Failed to open merge report '%s' for writing\n", report_filename);
+		return EXIT_FAILURE;
+	}
+
+	int err = MRG_MergeRecons(args.input_filenames, args.num_inputs, args.output_filename, args.recon_filename, f_report);
+	fclose(f_report);
+	if (err == 2) {
+		for (int i=0; i<args.num_inputs; i++) {
+			if (access(args.input_filenames[i], R_OK) != 0) printf("Error: Failed to open merge input '%s'\n", args.input_filenames[i]);
+		}
+	}
+	if (err == 6) {
+		remove(report_filename);
+		for (int i=0; i<args.num_inputs; i++) {
+			int check = MRG_CheckCompanionImage(args.input_filenames[i]);
+			if (check == 3) printf("Error: Merge input '%s' is sparse, but its disk image is missing\n", args.input_filenames[i]);
+			if (check == 4) printf("Error: Merge input '%s' is sparse, but its disk image is a different one\n", args.input_filenames[i]);
+		}
+		printf("Sparse recon files keep their good sectors in the image they were created with,\n");
+		printf("which has to be next to them, named like the recon file but ending in '.d64'\n");
+		return EXIT_FAILURE;
+	}
+	if (err != 0) {
+		printf("Error: Failed to merge recon files; Error-code: %i\n", err);
+		return EXIT_FAILURE;
+	}
+
+	if (g_verbose_log) printf("Merged %i recon files into '%s'; see '%s' for the source of each sector\n",
+		args.num_inputs, args.output_filename, report_filename
+	);
+
+	return EXIT_SUCCESS;
+}
+
+int __run_pack(CLI_Arguments args) {
+	if (args.num_inputs != 1 || args.output_filename == NULL) {
+		printf("Error: --pack requires a single log file and an output file (-o)\n\n");
+		CLI_Usage();
+	}
+
+	long records = NYB_Bin_Convert(args.input_filenames[0], args.output_filename);
+	if (records < 0) {
+		printf("Error: Failed to convert log file '%s' into '%s'\n", args.input_filenames[0], args.output_filename);
+		return EXIT_FAILURE;
+	}
+
+	if (g_verbose_log) printf("Packed %li records from '%s' into '%s'\n",
+		records, args.input_filenames[0], args.output_filename
+	);
+
+	return EXIT_SUCCESS;
+}
+
+int __run_ingest(CLI_Arguments args) {
+	if (args.output_filename == NULL) {
+		printf("Error: --ingest requires an output image (-o)\n\n");
+		CLI_Usage();
+	}
+
+	ING_Stats stats;
+	FILE *f_report = isatty(STDOUT_FILENO) || g_verbose_log ? stdout : NULL;
+	int err = ING_Ingest(args.ingest_source, args.output_filename, args.recon_filename, g_ignore_error_image_write, f_report, g_verbose_log ? stdout : NULL, &stats);
+	if (err == 6) {
+		printf("Error: Recon file '%s' belongs to a different disk image than '%s'\n", args.recon_filename, args.output_filename);
+		return EXIT_FAILURE;
+	}
+	if (err != 0) {
+		printf("Error: Failed to ingest '%s'; Error-code: %i\n", args.ingest_source, err);
+		if (err != 4) return EXIT_FAILURE;
+	}
+
+	printf("Ingested %i blocks (%i written, %i disk errors, %i checksum errors, %i parse errors) in %.1f s; %.1f KB/s\n",
+		stats.blocks, stats.blocks_written, stats.count_disk_errors, stats.count_checksum_errors,
+		stats.count_parse_errors, stats.seconds, (stats.seconds > 0.0) ? stats.bytes / 1024.0 / stats.seconds : 0.0
+	);
+
+	return (err == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int __run_extract(CLI_Arguments args) {
+	if (args.num_inputs < 1 || args.export_directory == NULL) {
+		printf("Error: --extract-all requires at least one disk image and an export directory (-e)\n\n");
+		CLI_Usage();
+	}
+
+	EXT_Stats stats;
+	uint32_t flags = args.export_flags | (g_verbose_log ? EXT_FLAG_LIST_FILES : 0);
+	int err = EXT_ExtractImages(args.input_filenames, args.num_inputs, args.export_directory, flags, 0, stdout, &stats);
+	if (err == 1 || err == 2) {
+		printf("Error: Failed to extract into '%s'; Error-code: %i\n", args.export_directory, err);
+		return EXIT_FAILURE;
+	}
+
+	printf("Extracted %i files (%llu bytes) from %i disk images; %i files with broken chains, %i skipped, %i images failed\n",
+		stats.files_written, (unsigned long long) stats.bytes, args.num_inputs,
+		stats.files_broken, stats.files_skipped, stats.images_failed
+	);
+
+	return (err == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int __run_diff(CLI_Arguments args) {
+	if (args.num_inputs < 2 || args.num_inputs % 2 != 0) {
+		printf("Error: --diff requires pairs of disk images\n\n");
+		CLI_Usage();
+	}
+
+	// Both images of a pair are read into the same arena, so no pair allocates anything
+	ARN_Arena arena;
+	if (ARN_Init(&arena, DIF_ARENA_SIZE) != 0) exit(EXIT_FAILURE);
+
+	int num_pairs = args.num_inputs / 2;
+	int num_differ = 0;
+	int num_failed = 0;
+	for (int i=0; i<num_pairs; i++) {
+		const char *filename_a = args.input_filenames[i * 2];
+		const char *filename_b = args.input_filenames[i * 2 + 1];
+		if (i > 0) printf("\n");
+
+		DIF_Diff diff;
+		DIF_FileStats stats;
+		int err = DIF_DiffFiles(filename_a, filename_b, &arena, stdout, &diff, &stats);
+		if (err != 0) {
+			printf("Error: Failed to read disk image '%s'\n", (err == 3) ? filename_b : filename_a);
+			num_failed++;
+			continue;
+		}
+		if (diff.num_changed > 0) num_differ++;
+	}
+	ARN_Free(&arena);
+
+	if (num_pairs > 1) printf("\nCompared %i pairs of disk images; %i differ, %i failed\n", num_pairs, num_differ, num_failed);
+
+	return (num_failed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int __run_search(CLI_Arguments args) {
+	if (args.num_inputs < 1) {
+		printf("Error: --search requires at least one disk image\n\n");
+		CLI_Usage();
+	}
+
+	SCH_Pattern pattern;
+	int err = SCH_ParsePattern(args.search_pattern, args.search_is_hex, &pattern);
+	if (err != 0) {
+		printf("Error: Invalid search pattern '%s'; Error-code: %i\n", args.search_pattern, err);
+		return EXIT_FAILURE;
+	}
+
+	SCH_Stats stats;
+	err = SCH_SearchImages(args.input_filenames, args.num_inputs, &pattern, 0, stdout, &stats);
+	if (err == 1) return EXIT_FAILURE;
+
+	if (g_verbose_log || args.num_inputs > 1) printf("Found %llu hits in %i of %i disk images; %i images failed\n",
+		(unsigned long long) stats.hits, stats.images_matched, args.num_inputs, stats.images_failed
+	);
+
+	return (err == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int __run_index(CLI_Arguments args) {
+	// Without a query the index is brought up to date
+	if (args.index_query == NULL) {
+		IDX_Stats stats;
+		int err = IDX_Update(args.index_directory, g_verbose_log ? stdout : NULL, &stats);
+		if (err != 0) {
+			printf("Error: Failed to %s the index of '%s'; Error-code: %i\n", (err == 2) ? "read the directory for" : "write", args.index_directory, err);
+			return EXIT_FAILURE;
+		}
+
+		printf("Indexed %i files in %i disk images (%i read, %i unchanged); %i words, %i images failed\n",
+			stats.num_files, stats.disks_read + stats.disks_unchanged, stats.disks_read, stats.disks_unchanged,
+			stats.num_tokens, stats.disks_failed
+		);
+		return EXIT_SUCCESS;
+	}
+
+	IDX_Index index;
+	int err = IDX_Open(args.index_directory, &index);
+	if (err != 0) {
+		const char *reason = (err == 2) ? "there's no index; create it with --index first"
+			: (err == 3) ? "it's from another version; update it with --index"
+			: "it's truncated or damaged; update it with --index";
+		printf("Error: Failed to open the index of '%s': %s\n", args.index_directory, reason);
+		return EXIT_FAILURE;
+	}
+
+	int max_results = index.header->num_files;
+	uint32_t *results = malloc(sizeof(uint32_t) * (max_results + 1));
+	if (results == NULL) {
+		IDX_Close(&index);
+		return EXIT_FAILURE;
+	}
+
+	struct timespec start, end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	int num_results = 0;
+	err = IDX_Query(&index, args.index_query, results, max_results, &num_results);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	double elapsed_ms = (end.tv_sec - start.tv_sec) * 1000.0 + (end.tv_nsec - start.tv_nsec) / 1000000.0;
+	if (err != 0) {
+		printf("Error: Invalid query '%s'; Error-code: %i\n", args.index_query, err);
+	} else {
+		for (int i=0; i<num_results; i++) IDX_WriteMatch(stdout, &index, results[i]);
+		printf("Found %i files in %u disk images", num_results, index.header->num_disks);
+		if (g_verbose_log) printf(" in %.3f ms", elapsed_ms);
+		printf("\n");
+	}
+
+	free(results);
+	IDX_Close(&index);
+	return (err == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int __run_check_bam(CLI_Arguments args) {
+	if (args.num_inputs < 1) {
+		printf("Error: --check-bam requires at least one disk image\n\n");
+		CLI_Usage();
+	}
+	if (args.output_filename != NULL && args.num_inputs > 1) {
+		printf("Error: --check-bam can only write (-o) the corrected image of a single disk image\n\n");
+		CLI_Usage();
+	}
+
+	BAM_Stats stats;
+	int err = BAM_CheckImages(args.input_filenames, args.num_inputs, args.output_filename, stdout, &stats);
+	if (err == 1) return EXIT_FAILURE;
+	if (err == 3) printf("Error: Failed to write the corrected image '%s'\n", args.output_filename);
+	else if (err == 4) printf("Error: Not writing '%s'; the BAM is invalid and a file chain is broken, so it's unknown which sectors the rest of that file uses\n", args.output_filename);
+	else if (args.output_filename != NULL && stats.images_failed == 0) printf("Wrote the image with a rebuilt BAM to '%s'\n", args.output_filename);
+
+	if (g_verbose_log || args.num_inputs > 1) printf("Checked %i disk images; %i consistent, %i sectors allocated but unused, %i used but free, %i images failed\n",
+		args.num_inputs, stats.images_consistent, stats.sectors_allocated_unused, stats.sectors_used_free, stats.images_failed
+	);
+
+	return (err == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int __run_heatmap(CLI_Arguments args) {
+	HMP_Heatmap *heatmap = malloc(sizeof(HMP_Heatmap));
+	if (heatmap == NULL) return EXIT_FAILURE;
+
+	// Recons that couldn't be read are left out of the counts
+	int status = CLI_BuildHeatmap(args, heatmap);
+	if (status == EXIT_SUCCESS) HMP_WriteReport(stdout, heatmap, 20);
+	if (heatmap->num_failed > 0) status = EXIT_FAILURE;
+	free(heatmap);
+
+	return status;
+}
+
+int CLI_RunBatchMode(CLI_Arguments args) {
+	switch (args.mode) {
+		case RUNMODE_VIEW: return -1;
+		case RUNMODE_MERGE: return __run_merge(args);
+		case RUNMODE_PACK: return __run_pack(args);
+		case RUNMODE_INGEST: return __run_ingest(args);
+		case RUNMODE_EXTRACT: return __run_extract(args);
+		case RUNMODE_DIFF: return __run_diff(args);
+		case RUNMODE_SEARCH: return __run_search(args);
+		case RUNMODE_INDEX: return __run_index(args);
+		case RUNMODE_CHECK_BAM: return __run_check_bam(args);
+		case RUNMODE_HEATMAP: return __run_heatmap(args);
+	}
+	return -1;
+}
+
+int CLI_GetSessionOptions(CLI_Arguments args, SES_Options *options) {
+	char *disk_filename = args.disk_filename;
+	char *log_filename = args.log_filename;
+	char *hexdump_filename = args.hexdump_filename;
+	char *recon_filename = args.recon_filename;
+	if (disk_filename == NULL) {
+		printf("Error: you must specify a disk file argument\n\n");
+		CLI_Usage();
+	}
+	if (log_filename != NULL && hexdump_filename != NULL) {
+		printf("Error: Only one of -l and --import-hexdump can be given\n\n");
+		CLI_Usage();
+	}
+
+	if (g_verbose_log) {
+		printf("Arguments:\n");
+		printf("   Disk File: %s\n", disk_filename);
+		printf("    Log File: %s\n", (log_filename == NULL) ? "Not Specified" : log_filename);
+		if (hexdump_filename != NULL) printf("    Hex Dump: %s\n", hexdump_filename);
+		printf("  Recon File: %s\n\n", (recon_filename == NULL) ? "Not Specified" : recon_filename);
+	}
+
+	*options = (SES_Options){
+		.disk_filename = disk_filename,
+		.recon_filename = recon_filename,
+		.import_filename = (hexdump_filename != NULL) ? hexdump_filename : log_filename,
+		.import_is_hexdump = (hexdump_filename != NULL),
+		.ignore_invalid_bam = g_ignore_error_invalid_bam,
+		.ignore_image_write = g_ignore_error_image_write,
+		.use_cache = g_use_analysis_cache,
+		.f_log = g_verbose_log ? stdout : NULL,
+	};
+	return EXIT_SUCCESS;
+}
+
+int CLI_ReportLoadError(CLI_Arguments args, int err, int err_detail) {
+	char *disk_filename = args.disk_filename;
+	char *recon_filename = args.recon_filename;
+	char *import_filename = (args.hexdump_filename != NULL) ? args.hexdump_filename : args.log_filename;
+
+	switch (err) {
+		case 0: return EXIT_SUCCESS;
+		case 2: printf("Error: Failed to read log file '%s'\n", import_filename); break;
+		case 3: printf("Error: Failed to read disk image '%s'\n", disk_filename); break;
+		case 4: printf("Error: Failed to open import journal for '%s'\n", disk_filename); break;
+		case 5: printf("Error: Failed to write import journal '%s" NYBLOG_JOURNAL_EXTENSION "'\n", disk_filename); break;
+		case 6: printf("Error: Failed to write to disk image '%s'\n", disk_filename); break;
+		case 7: printf("Error: Failed to write recon file '%s'\n", recon_filename); break;
+		case 8: printf("Error: Failed to read input file '%s'\n", disk_filename); break;
+		case 9: printf("Error: Failed to read input metadata file '%s'\n", recon_filename); break;
+		case 14: {
+			printf("Error: Recon file '%s' belongs to a different disk image than '%s'\n", recon_filename, disk_filename);
+			printf("Its good sectors are only stored in the image it was created with\n");
+		} return EXIT_FAILURE;
+		case 10: {
+			printf("Error: Failed to parse track 18; Error-code: %i\n", err_detail);
+			if (err_detail == 4) {
+				printf("The directory of '%s' loops back on itself or has too many entries\n", disk_filename);
+				return EXIT_FAILURE;
+			}
+			if (err_detail == 2 || err_detail == 3) {
+				printf(" ---------------------------------------------------------------\n");
+				printf("  The BAM is invalid! You can try rerunning with -b or --bam to\n");
+				printf("  use a blank BAM instead so you can see the rest of the data.\n");
+				printf(" ---------------------------------------------------------------\n");
+			}
+		} break;
+
+		// The disk itself could be read, so there's nothing wrong with the arguments
+		case 11: printf("Failed to analyse disk: Err-code %i\n", err_detail); return EXIT_FAILURE;
+		case 12: printf("Failed to gather disk stats: Err-code %i\n", err_detail); return EXIT_FAILURE;
+		case 13: printf("Cancelled loading '%s'\n", disk_filename); return EXIT_FAILURE;
+		default: return EXIT_FAILURE;
+	}
+
+	CLI_Usage();
+	return EXIT_FAILURE;
+}
+
+int CLI_LoadDisk(CLI_Arguments args, SES_Session *session) {
+	SES_Options options;
+	CLI_GetSessionOptions(args, &options);
+	if (SES_Init(session, options) != 0) exit(EXIT_FAILURE);
+
+	int err = SES_Load(session);
+	int status = CLI_ReportLoadError(args, err, session->progress.err_detail);
+	if (status != EXIT_SUCCESS) SES_Close(session);
+	return status;
+}
+
+int CLI_WritePlan(CLI_Arguments args, ANA_DiskInfo *analysis) {
+	PLN_Plan plan;
+	PLN_CreatePlan(analysis, PLN_DEFAULT_MODEL, &plan);
+
+	FILE *f_plan = fopen(args.plan_filename, "w");
+	if (f_plan == NULL) {
+		printf("Error: Failed to open plan file '%s' for writing\n", args.plan_filename);
+		return EXIT_FAILURE;
+	}
+	PLN_WritePlan(f_plan, &plan, args.disk_filename);
+	fclose(f_plan);
+
+	printf("Wrote re-transfer plan for %i sectors to '%s' (est. %.1f s instead of %.1f s for a full transfer)\n",
+		plan.num_entries, args.plan_filename, plan.total_ms / 1000.0, plan.full_dump_ms / 1000.0
+	);
+	return EXIT_SUCCESS;
+}
+
+int CLI_WriteQuery(CLI_Arguments args, ANA_DiskInfo *analysis) {
+	QRY_Query query;
+	int err_pos = 0;
+	int err = QRY_Parse(args.sector_query, &query, &err_pos);
+	if (err != 0) {
+		printf("Error: Invalid query; %s\n", QRY_GetErrorName(err));
+		if (err == 2 || err == 3) printf("  %s\n  %*s^\n", args.sector_query, err_pos, "");
+		return EXIT_FAILURE;
+	}
+
+	ANA_Bitset matches;
+	QRY_Evaluate(&query, analysis, &matches);
+	printf("%s: %i sectors match '%s'", args.disk_filename, ANA_Bitset_Count(&matches), query.text);
+
+	// Eight to a line; finding the next one wraps around to the first after the last
+	int first = ANA_Bitset_Next(&matches, -1);
+	int index = first;
+	for (int count=0; index >= 0; count++) {
+		DSK_Position pos = DSK_IndexToPosition(index);
+		printf("%s[% 3i/% 3i]", (count % 8 == 0) ? "\n  " : " ", pos.track, pos.sector);
+
+		index = ANA_Bitset_Next(&matches, index);
+		if (index == first) break;
+	}
+	printf("\n");
+
+	return EXIT_SUCCESS;
+}
+
+int CLI_BuildHeatmap(CLI_Arguments args, HMP_Heatmap *heatmap) {
+	if (args.num_inputs < 1) {
+		printf("Error: --heatmap requires at least one recon file\n\n");
+		CLI_Usage();
+	}
+
+	HMP_Init(heatmap);
+	int err = HMP_AddRecons(heatmap, args.input_filenames, args.num_inputs, 0);
+	if (err == 1) return EXIT_FAILURE;
+
+	printf("Counted %u transfers of %u recon files; %u failed to read, %u without their disk image\n",
+		heatmap->total.transfers, heatmap->num_recons, heatmap->num_failed, heatmap->num_without_image
+	);
+
+	if (args.output_filename == NULL) return EXIT_SUCCESS;
+
+	FILE *f_csv = fopen(args.output_filename, "w");
+	err = (f_csv == NULL) ? 2 : HMP_WriteCSV(f_csv, heatmap);
+	if (f_csv != NULL && fclose(f_csv) != 0) err = 2;
+	if (err != 0) {
+		printf("Error: Failed to write heatmap '%s'\n", args.output_filename);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
+
+void CLI_ParseArgs(int argc, char *argv[], CLI_Arguments *args) {
+	if (argc < 2) {
+		printf("Error: at least one argument (disk filename) is required\n\n");
+		CLI_Usage();
+		exit(EXIT_FAILURE);
+	}
+
+	args->input_filenames = malloc(argc * sizeof(char *));
+	args->num_inputs = 0;
+	if (args->input_filenames == NULL) exit(EXIT_FAILURE);
+
+	for (int i=1; i<argc; i++) {
+		char *curr_arg = argv[i];
+
+		if (curr_arg[0] != '-') {
+			// Batch modes take any number of input files
+			if (args->mode != RUNMODE_VIEW) {
+				args->input_filenames[args->num_inputs++] = curr_arg;
+				continue;
+			}
+
+			// End of options; this is the disk filename
+			args->disk_filename = curr_arg;
+			return;
+		}
+		curr_arg++;
+
+		// Long option; search full word
+		int len = strlen(curr_arg);
+		if (len <= 0) continue;
+		if (curr_arg[0] == '-') {
+			curr_arg++;
+			len--;
+			if (len <= 0) continue;
+			
+			if (len >= 4 && strncmp(curr_arg, "help", len * sizeof(char)) == 0) CLI_Usage();
+			if (len >= 7 && strncmp(curr_arg, "version", len * sizeof(char)) == 0) CLI_Version();
+			if (len >= 5 && strncmp(curr_arg, "debug", len * sizeof(char)) == 0) { g_verbose_log = true; continue; };
+			if (len >= 3 && strncmp(curr_arg, "bam", len * sizeof(char)) == 0) { g_ignore_error_invalid_bam = true; continue; };
+			if (len >= 5 && strncmp(curr_arg, "force", len * sizeof(char)) == 0) { g_ignore_error_image_write = true; continue; };
+			if (len >= 8 && strncmp(curr_arg, "no-cache", len * sizeof(char)) == 0) { g_use_analysis_cache = false; continue; };
+			if (len >= 5 && strncmp(curr_arg, "merge", len * sizeof(char)) == 0) { args->mode = RUNMODE_MERGE; continue; };
+			if (len >= 4 && strncmp(curr_arg, "pack", len * sizeof(char)) == 0) { args->mode = RUNMODE_PACK; continue; };
+			if (len >= 6 && strncmp(curr_arg, "ingest", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Ingest option (--ingest) requires a device, FIFO or '-' argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->mode = RUNMODE_INGEST;
+				args->ingest_source = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 11 && strncmp(curr_arg, "extract-all", len * sizeof(char)) == 0) { args->mode = RUNMODE_EXTRACT; continue; };
+			if (len >= 4 && strncmp(curr_arg, "diff", len * sizeof(char)) == 0) { args->mode = RUNMODE_DIFF; continue; };
+			if (len >= 9 && strncmp(curr_arg, "check-bam", len * sizeof(char)) == 0) { args->mode = RUNMODE_CHECK_BAM; continue; };
+			if (len >= 7 && strncmp(curr_arg, "heatmap", len * sizeof(char)) == 0) { args->mode = RUNMODE_HEATMAP; continue; };
+			if (len >= 3 && strncmp(curr_arg, "p00", len * sizeof(char)) == 0) { args->export_flags |= EXT_FLAG_P00; continue; };
+			if (len >= 14 && strncmp(curr_arg, "import-hexdump", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Hex dump option (--import-hexdump) requires a file argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->hexdump_filename = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 6 && (strncmp(curr_arg, "search", len * sizeof(char)) == 0 || strncmp(curr_arg, "search-hex", len * sizeof(char)) == 0)) {
+				if (i >= argc-1) {
+					printf("Error: Search option (--%s) requires a pattern argument\n\n", curr_arg);
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->mode = RUNMODE_SEARCH;
+				args->search_is_hex = (len > 6);
+				args->search_pattern = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 5 && strncmp(curr_arg, "index", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Index option (--index) requires a directory argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->mode = RUNMODE_INDEX;
+				args->index_directory = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 4 && strncmp(curr_arg, "find", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Find option (--find) requires a query argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->index_query = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 5 && strncmp(curr_arg, "query", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Query option (--query) requires an expression argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->sector_query = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 5 && strncmp(curr_arg, "trace", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Trace option (--trace) requires a file argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->trace_filename = argv[i+1];
+				i++;
+				continue;
+			};
+			if (len >= 4 && strncmp(curr_arg, "plan", len * sizeof(char)) == 0) {
+				if (i >= argc-1) {
+					printf("Error: Plan option (--plan) requires a file argument\n\n");
+					CLI_Usage();
+					exit(EXIT_FAILURE);
+				}
+
+				args->plan_filename = argv[i+1];
+				i++;
+				continue;
+			};
+
+			printf("Error: Unrecognised option '%s'; Skipping\n", curr_arg);
+
+			continue;
+		}
+
+		// Short options
+		char o = curr_arg[0];
+		switch (o) {
+			case 'h': CLI_Usage(); break;
+			case 'v': CLI_Version(); break;
+			case 'd': { g_verbose_log = true; } continue;
+			case 'b': { g_ignore_error_invalid_bam = true; } continue;
+			case 'f': { g_ignore_error_image_write = true; } continue;
+
+			case 'l': {
+				if (len > 1) {
+					args->log_filename = curr_arg + 1;
+				} else {
+					if (i >= argc-1) {
+						printf("Error: Log-File option (-l) requires a file argument\n\n");
+						CLI_Usage();
+						exit(EXIT_FAILURE);
+					}
+
+					args->log_filename = argv[i+1];
+					i++;
+				}
+			} continue;
+
+			case 'r': {
+				if (len > 1) {
+					args->recon_filename = curr_arg + 1;
+				} else {
+					if (i >= argc-1) {
+						printf("Error: Recon-File option (-r) requires a file argument\n\n");
+						CLI_Usage();
+						exit(EXIT_FAILURE);
+					}
+
+					args->recon_filename = argv[i+1];
+					i++;
+				}
+			} continue;
+
+			case 'e': {
+				if (len > 1) {
+					args->export_directory = curr_arg + 1;
+				} else {
+					if (i >= argc-1) {
+						printf("Error: Export-Directory option (-e) requires a path argument\n\n");
+						CLI_Usage();
+						exit(EXIT_FAILURE);
+					}
+
+					args->export_directory = argv[i+1];
+					i++;
+				}
+			} continue;
+
+			case 'o': {
+				if (len > 1) {
+					args->output_filename = curr_arg + 1;
+				} else {
+					if (i >= argc-1) {
+						printf("Error: Output-File option (-o) requires a file argument\n\n");
+						CLI_Usage();
+						exit(EXIT_FAILURE);
+					}
+
+					args->output_filename = argv[i+1];
+					i++;
+				}
+			} continue;
+
+			default: printf("Error: Unrecognised option '%c'; Skipping\n", o); continue;
+		}
+
+	}
+}
+
+void CLI_StartTrace(CLI_Arguments args) {
+	if (args.trace_filename == NULL) return;
+
+	switch (TRC_Open(args.trace_filename)) {
+		case 0: return;
+		case 3: printf("Error: This build of disekt has no trace spans; rebuild it with 'make TRACE=1'\n"); break;
+		default: printf("Error: Failed to open trace file '%s' for writing\n", args.trace_filename); break;
+	}
+	exit(EXIT_FAILURE);
+}
+
+void CLI_Version() {
+	puts("disekt version " CLI_VERSION);
+
+	exit(EXIT_SUCCESS);
+}
+
+void CLI_Usage() {
+	printf("Usage: disekt [OPTIONS] <disk path>\n");
+	printf("\n");
+	printf("Args:\n");
+	printf("  disk path			The path to a Commodore 64 disk file to read\n");
+	printf("\n");
+	printf("Options:\n");
+	printf("  -h, --help		Print this usage text and exit\n");
+	printf("  -v, --version		Print the current version number and exit\n");
+	printf("  -d, --debug		Enable more verbose logging for debugging\n");
+	printf("  -f, --force		Ignore transfer errors when writing disk image\n");
+	printf("  -l <filename>		Parse the text log file provided and write its\n");
+	printf("					contents to the given disk file; an interrupted\n");
+	printf("					import carries on from '<disk path>.jnl'\n");
+	printf("  --import-hexdump <filename>\n");
+	printf("					Like -l, but reads a raw hex dump of the transfer\n");
+	printf("					(blocks starting with 'FF 00') instead of a text log\n");
+	printf("  -r <filename>		Include information from an external reconciliation\n");
+	printf("					file. If provided with -l, the log writes the recon\n");
+	printf("					data to this file before loading\n");
+	printf("  -e <directory>	Specify the export directory to use; any files that\n");
+	printf("					are extracted will be written to the provided location\n");
+	printf("  --p00				Export files with PC64 headers (.P00, .S00, .U00)\n");
+	printf("  -b, --bam			Rebuild the BAM from the file chains if the disk's BAM\n");
+	printf("					is invalid; bypasses the \"Invalid BAM\" Fatal Error.\n");
+	printf("  --merge <recons>	Merge several recon files of the same disk into the\n");
+	printf("					image given by -o, picking verified copies of each\n");
+	printf("					sector or voting on every byte. The source of each\n");
+	printf("					sector is written to '<image>.merge'; with -r the\n");
+	printf("					merged transfer info is also written to a recon file.\n");
+	printf("					Recons written with an image only hold the sectors\n");
+	printf("					that differ from it; that image must be next to the\n");
+	printf("					recon, named '<recon name>.d64' (a.r64 -> a.d64)\n");
+	printf("  --pack <log>		Convert a text log file into the indexed binary log\n");
+	printf("					given by -o; binary logs can be used with -l and\n");
+	printf("					import much faster than text logs\n");
+	printf("  --ingest <source>	Read the log straight from a serial device, FIFO or '-'\n");
+	printf("					for stdin, and write its blocks to the image given by\n");
+	printf("					-o (and -r) as they arrive; stops at the end of the\n");
+	printf("					stream or on Ctrl-C. Set the port's speed with stty\n");
+	printf("  --extract-all <images>\n");
+	printf("					Write every PRG, SEQ & USR file of the disk images to\n");
+	printf("					the directory given by -e (one directory per image if\n");
+	printf("					there are several); files with broken chains are\n");
+	printf("					reported instead of written\n");
+	printf("  --diff <images>	Compare pairs of disk images block by block and list\n");
+	printf("					the changed sectors, their changed bytes and the\n");
+	printf("					files they belong to; the viewer opens the first\n");
+	printf("					image of a pair with its changes shown (F2)\n");
+	printf("  --search <text> <images>\n");
+	printf("					List where PETSCII text is in the disk images, in\n");
+	printf("					either case and across the blocks of a file\n");
+	printf("  --search-hex <bytes> <images>\n");
+	printf("					Like --search, but for hex bytes with '?\?' for any\n");
+	printf("					byte (e.g. \"A9 ?? 8D 20 D0\"); in the viewer, start\n");
+	printf("					the search box (F4) with '$' for the same\n");
+	printf("  --check-bam <images>\n");
+	printf("					Work out which sectors the directory & file chains use\n");
+	printf("					and list those the BAM gets wrong; with -o and a\n");
+	printf("					single image, write it there with a rebuilt BAM.\n");
+	printf("					If a chain is broken, sectors the old BAM allocates\n");
+	printf("					stay allocated\n");
+	printf("  --heatmap <recons>	Count the disk errors, parse errors & checksum\n");
+	printf("					mismatches of every sector over any number of recon\n");
+	printf("					files (with their .d64 images next to them) and list\n");
+	printf("					them by speed zone, with the sectors failing most;\n");
+	printf("					the viewer shows them on the disk. With -o, the\n");
+	printf("					counts of every sector are written there as CSV\n");
+	printf("  --index <directory>\n");
+	printf("					Index the files of every .d64 image in the directory\n");
+	printf("					and its sub-directories; only new or changed images\n");
+	printf("					are read again when the index is updated\n");
+	printf("  --find <query>	With --index, list the files matching every term of\n");
+	printf("					the query: words of file & disk names ('word*' for a\n");
+	printf("					prefix), type:prg, health:ok|broken, id:2a and\n");
+	printf("					blocks>N, blocks<N or blocks=N\n");
+	printf("  --query <expr>	List the sectors matching an expression of their\n");
+	printf("					attributes, e.g. \"!free && !checksum_match\"; names\n");
+	printf("					are free, data, blank, transfer_info, directory_info,\n");
+	printf("					checksum_match, transfer_error, status:<status>,\n");
+	printf("					type:<type>, file:N & track:N. The viewer highlights\n");
+	printf("					them instead (F6 to edit, Tab for the next one)\n");
+	printf("  -o <filename>		Output file for batch modes\n");
+	printf("  --plan <filename>	Write a plan of which sectors to transfer again (missing,\n");
+	printf("					corrupted or bad ones) in a drive-friendly order, with\n");
+	printf("					an estimate of how long it takes, and exit\n");
+	printf("  --trace <filename>\n");
+	printf("					Record how long parsing, reading & writing files and\n");
+	printf("					each analysis pass take, on every thread, and write\n");
+	printf("					it to the file as a Chrome trace (chrome://tracing)\n");
+	printf("  --no-cache		Always re-analyse the disk instead of loading a cached\n");
+	printf("					analysis; cache files are kept next to the disk image\n");
+	printf("					or in $XDG_CACHE_HOME/disekt if it's set\n");
+	printf("\n");
+	printf("NOTE: All write operations will completely overwrite the provided file!\n");
+	printf("\n");
+	printf("Examples:\n");
+	printf("  disekt test_disk.d64\n");
+	printf("  disekt -l dump_log.txt -r test_disk.r64 test_disk.d64\n");
+	printf("  disekt -r test_disk.r64 test_disk.d64\n");
+	printf("  disekt --import-hexdump dump.hex -r test_disk.r64 test_disk.d64\n");
+	printf("  disekt --merge pass1.r64 pass2.r64 pass3.r64 -o best.d64 -r best.r64\n");
+	printf("  disekt --pack dump_log.txt -o dump_log.nbx\n");
+	printf("  disekt --ingest /dev/ttyACM0 -o test_disk.d64 -r test_disk.r64\n");
+	printf("  disekt --extract-all -e exported/ archive/*.d64\n");
+	printf("  disekt --diff recovered.d64 reference.d64\n");
+	printf("  disekt --search-hex \"20 D2 FF\" archive/*.d64\n");
+	printf("  disekt --query \"!free && (status:missing || transfer_error)\" test_disk.d64\n");
+	printf("  disekt --check-bam broken.d64 -o fixed.d64\n");
+	printf("  disekt --heatmap -o heatmap.csv archive/*.r64\n");
+	printf("  disekt --index archive/ --find \"boulder* type:prg health:broken\"\n");
+	printf("  disekt --trace trace.json --extract-all -e exported/ archive/*.d64\n");
+
+	exit(EXIT_SUCCESS);
+}
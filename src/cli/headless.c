@@ -0,0 +1,54 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "../../include/debug.h"
+#include "../../include/disk.h"
+#include "../../include/analysis.h"
+#include "../../include/cli.h"
+
+//	disekt without the viewer; takes the same arguments, but prints a summary
+//	of the disk instead of opening a window, so it runs without a display
+
+int main(int argc, char *argv[]) {
+
+	// Read Input Parameters
+
+	CLI_Arguments args = { .mode = RUNMODE_VIEW };
+	CLI_ParseArgs(argc, argv, &args);
+	CLI_StartTrace(args);
+	int status = CLI_RunBatchMode(args);
+	if (status >= 0) return status;
+
+	// Import, read & analyse the disk
+	SES_Session session;
+	status = CLI_LoadDisk(args, &session);
+	if (status != EXIT_SUCCESS) return status;
+	ANA_DiskInfo *analysis = session.analysis;
+
+	if (args.plan_filename != NULL) {
+		status = CLI_WritePlan(args, analysis);
+		SES_Close(&session);
+		return status;
+	}
+
+	if (args.sector_query != NULL) {
+		status = CLI_WriteQuery(args, analysis);
+		SES_Close(&session);
+		return status;
+	}
+
+	// Verbose runs have already printed the full statistics
+	if (!g_verbose_log) {
+		char name[DSK_NAME_SIZE] = "<INVALID BAM>";
+		if (!g_ignore_error_invalid_bam) DSK_GetName(*session.dir, name, sizeof(name));
+		printf("%s: \"%s\"; %i blocks in use, %i completed, %i missing, %i with issues\n",
+			args.disk_filename, name,
+			analysis->count_in_use, analysis->count_healthy, analysis->count_missing, analysis->count_bad
+		);
+	}
+
+	SES_Close(&session);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,235 @@
+#include "../include/diff.h"
+#include "../include/trace.h"
+
+#define __BYTE_LSBS 0x0101010101010101ULL
+
+
+//	Counts the bytes that differ between two blocks, 8 at a time
+int __count_changed_bytes(const uint8_t *block_a, const uint8_t *block_b) {
+	int count = 0;
+	for (int i=0; i<BLOCK_SIZE; i+=sizeof(uint64_t)) {
+		uint64_t a, b;
+		memcpy(&a, block_a + i, sizeof(uint64_t));
+		memcpy(&b, block_b + i, sizeof(uint64_t));
+
+		// Folds every byte's bits into its lowest one, so each differing byte counts once
+		uint64_t x = a ^ b;
+		x |= x >> 4;
+		x |= x >> 2;
+		x |= x >> 1;
+		count += __builtin_popcountll(x & __BYTE_LSBS);
+	}
+	return count;
+}
+
+//	Follows a file's chain through an image, counting the blocks that changed;
+//	a broken chain is followed as far as it goes
+int __count_changed_blocks(const uint8_t *image, DSK_Position head, const DIF_Diff *diff, int *num_blocks) {
+	uint32_t visited[DIF_BITSET_WORDS];
+	memset(visited, 0, sizeof(visited));
+
+	int count = 0;
+	*num_blocks = 0;
+	DSK_Position pos = head;
+	while (DSK_IsPositionValid(pos)) {
+		int index = DSK_PositionToIndex(pos);
+		if (visited[index / 32] & (1u << (index % 32))) break;
+		visited[index / 32] |= 1u << (index % 32);
+
+		(*num_blocks)++;
+		if (DIF_IsChanged(diff, index)) count++;
+
+		const uint8_t *block = image + (size_t) index * BLOCK_SIZE;
+		pos = (DSK_Position){ block[0], block[1] };
+	}
+	return count;
+}
+
+bool __is_file(DSK_DirEntry entry) {
+	return entry.type == SECTYPE_SEQ || entry.type == SECTYPE_PRG
+		|| entry.type == SECTYPE_USR || entry.type == SECTYPE_REL;
+}
+
+const char *__type_name(uint8_t type) {
+	switch (type) {
+		case SECTYPE_SEQ: return "SEQ";
+		case SECTYPE_PRG: return "PRG";
+		case SECTYPE_USR: return "USR";
+		case SECTYPE_REL: return "REL";
+	}
+	return "DEL";
+}
+
+int DIF_LoadImage(const char *filename, uint8_t *image, DSK_Directory *dir) {
+	if (filename == NULL || image == NULL || dir == NULL) return 1;
+
+	FILE *f_disk = fopen(filename, "rb");
+	if (f_disk == NULL) return 2;
+
+	size_t num_read = fread(image, BLOCK_SIZE, NYBLOG_SECTOR_COUNT, f_disk);
+	if (ferror(f_disk)) {
+		fclose(f_disk);
+		return 2;
+	}
+	memset(image + num_read * BLOCK_SIZE, 0, (NYBLOG_SECTOR_COUNT - num_read) * BLOCK_SIZE);
+
+	rewind(f_disk);
+	int err = DSK_File_ParseDirectory(f_disk, dir, true);
+	fclose(f_disk);
+	if (err != 0) {
+		dir->num_entries = 0;
+		return 3;
+	}
+
+	return 0;
+}
+
+int DIF_DiffImages(const uint8_t *image_a, const uint8_t *image_b, DIF_Diff *diff) {
+	if (image_a == NULL || image_b == NULL || diff == NULL) return 1;
+
+	memset(diff, 0, sizeof(DIF_Diff));
+
+	// Most pairs are mostly the same; memcmp skips equal blocks with the widest compares there are
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) {
+		const uint8_t *block_a = image_a + (size_t) i * BLOCK_SIZE;
+		const uint8_t *block_b = image_b + (size_t) i * BLOCK_SIZE;
+		if (memcmp(block_a, block_b, BLOCK_SIZE) == 0) continue;
+
+		int count = __count_changed_bytes(block_a, block_b);
+		diff->changed[i / 32] |= 1u << (i % 32);
+		diff->bytes_changed[i] = count;
+		diff->num_changed++;
+		diff->num_bytes_changed += count;
+	}
+
+	return 0;
+}
+
+bool DIF_IsChanged(const DIF_Diff *diff, int index) {
+	if (diff == NULL || index < 0 || index >= NYBLOG_SECTOR_COUNT) return false;
+	return (diff->changed[index / 32] >> (index % 32)) & 1;
+}
+
+int DIF_GetRanges(const uint8_t *block_a, const uint8_t *block_b, DIF_Range *ranges, int max_ranges) {
+	if (block_a == NULL || block_b == NULL || (ranges == NULL && max_ranges > 0)) return -1;
+
+	int num_ranges = 0;
+	int i = 0;
+	while (i < BLOCK_SIZE) {
+		if (block_a[i] == block_b[i]) {
+			i++;
+			continue;
+		}
+
+		int start = i;
+		while (i < BLOCK_SIZE && block_a[i] != block_b[i]) i++;
+		if (num_ranges < max_ranges) ranges[num_ranges] = (DIF_Range){ start, i - 1 };
+		num_ranges++;
+	}
+
+	return num_ranges;
+}
+
+int DIF_WriteReport(FILE *f_report, const uint8_t *image_a, const DSK_Directory *dir_a, const uint8_t *image_b, const DSK_Directory *dir_b, const DIF_Diff *diff, DIF_FileStats *stats) {
+	if (f_report == NULL || image_a == NULL || dir_a == NULL || image_b == NULL || dir_b == NULL || diff == NULL || stats == NULL) return 1;
+
+	memset(stats, 0, sizeof(DIF_FileStats));
+
+	fprintf(f_report, "Sectors: %i of %i changed (%i bytes)\n", diff->num_changed, NYBLOG_SECTOR_COUNT, diff->num_bytes_changed);
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int secs = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<secs; s++) {
+			DSK_Position pos = { t, s };
+			int index = DSK_PositionToIndex(pos);
+			if (!DIF_IsChanged(diff, index)) continue;
+
+			DIF_Range ranges[DIF_MAX_RANGES];
+			int num_ranges = DIF_GetRanges(image_a + (size_t) index * BLOCK_SIZE, image_b + (size_t) index * BLOCK_SIZE, ranges, DIF_MAX_RANGES);
+			fprintf(f_report, "  [% 3i/% 3i] %3i bytes:", pos.track, pos.sector, diff->bytes_changed[index]);
+			for (int r=0; r<num_ranges && r<DIF_MAX_RANGES; r++) {
+				if (ranges[r].start == ranges[r].end) fprintf(f_report, " 0x%02X", ranges[r].start);
+				else fprintf(f_report, " 0x%02X-0x%02X", ranges[r].start, ranges[r].end);
+			}
+			if (num_ranges > DIF_MAX_RANGES) fprintf(f_report, " (+%i more)", num_ranges - DIF_MAX_RANGES);
+			fprintf(f_report, "\n");
+		}
+	}
+
+	// Files are matched by name & type; each file of the second image can only be matched once
+	bool matched[MAX_DIR_ENTRIES];
+	memset(matched, 0, sizeof(matched));
+	char lines[MAX_DIR_ENTRIES * 2][96];
+	int num_lines = 0;
+
+	for (int i=0; i<dir_a->num_entries; i++) {
+		DSK_DirEntry entry_a = dir_a->entries[i];
+		if (!__is_file(entry_a)) continue;
+
+		int j = 0;
+		for (; j<dir_b->num_entries; j++) {
+			DSK_DirEntry entry_b = dir_b->entries[j];
+			if (matched[j] || entry_b.type != entry_a.type) continue;
+			if (strncmp(entry_a.filename, entry_b.filename, sizeof(entry_a.filename)) == 0) break;
+		}
+
+		if (j >= dir_b->num_entries) {
+			stats->files_removed++;
+			snprintf(lines[num_lines++], sizeof(lines[0]), "Removed: \"%s\" (%s, %i blocks)", entry_a.filename, __type_name(entry_a.type), entry_a.block_count);
+			continue;
+		}
+		matched[j] = true;
+		DSK_DirEntry entry_b = dir_b->entries[j];
+
+		int num_blocks_a, num_blocks_b;
+		int changed_a = __count_changed_blocks(image_a, entry_a.head_pos, diff, &num_blocks_a);
+		int changed_b = __count_changed_blocks(image_b, entry_b.head_pos, diff, &num_blocks_b);
+		if (changed_a == 0 && changed_b == 0 && DSK_PositionsEqual(entry_a.head_pos, entry_b.head_pos)) continue;
+
+		// Blocks can only be new to the second image's chain, so report the larger count
+		stats->files_changed++;
+		snprintf(lines[num_lines++], sizeof(lines[0]), "Changed: \"%s\" (%s, %i of %i blocks)", entry_a.filename, __type_name(entry_a.type),
+			(changed_b > changed_a) ? changed_b : changed_a, (num_blocks_b > num_blocks_a) ? num_blocks_b : num_blocks_a
+		);
+	}
+
+	for (int j=0; j<dir_b->num_entries; j++) {
+		DSK_DirEntry entry_b = dir_b->entries[j];
+		if (matched[j] || !__is_file(entry_b)) continue;
+
+		stats->files_added++;
+		snprintf(lines[num_lines++], sizeof(lines[0]), "Added: \"%s\" (%s, %i blocks)", entry_b.filename, __type_name(entry_b.type), entry_b.block_count);
+	}
+
+	fprintf(f_report, "Files: %i changed, %i added, %i removed\n", stats->files_changed, stats->files_added, stats->files_removed);
+	for (int i=0; i<num_lines; i++) fprintf(f_report, "  %s\n", lines[i]);
+
+	return 0;
+}
+
+int DIF_DiffFiles(const char *filename_a, const char *filename_b, ARN_Arena *arena, FILE *f_report, DIF_Diff *diff, DIF_FileStats *stats) {
+	TRC_SCOPE_DETAIL("DIF_DiffFiles", filename_a);
+	if (filename_a == NULL || filename_b == NULL || arena == NULL || diff == NULL || stats == NULL) return 1;
+
+	ARN_Reset(arena);
+	uint8_t *image_a = ARN_Alloc(arena, NYBLOG_IMAGE_SIZE);
+	uint8_t *image_b = ARN_Alloc(arena, NYBLOG_IMAGE_SIZE);
+	DSK_Directory *dir_a = ARN_Alloc(arena, sizeof(DSK_Directory));
+	DSK_Directory *dir_b = ARN_Alloc(arena, sizeof(DSK_Directory));
+	if (image_a == NULL || image_b == NULL || dir_a == NULL || dir_b == NULL) return 4;
+
+	// An unreadable directory only means no files can be compared
+	int err = DIF_LoadImage(filename_a, image_a, dir_a);
+	if (err != 0 && err != 3) return 2;
+	err = DIF_LoadImage(filename_b, image_b, dir_b);
+	if (err != 0 && err != 3) return 3;
+
+	DIF_DiffImages(image_a, image_b, diff);
+
+	memset(stats, 0, sizeof(DIF_FileStats));
+	if (f_report == NULL) return 0;
+
+	fprintf(f_report, "--- %s\n+++ %s\n", filename_a, filename_b);
+	DIF_WriteReport(f_report, image_a, dir_a, image_b, dir_b, diff, stats);
+
+	return 0;
+}
@@ -1,5 +1,6 @@
 #include "../include/disk.h"
-#include <raylib.h>
+#include "../include/trace.h"
+#include <string.h>
 
 
 //	---- Sector Utilities
@@ -52,6 +53,18 @@ int DSK_PositionToIndex(DSK_Position pos) {
 	return index;
 }
 
+DSK_Position DSK_IndexToPosition(int index) {
+	if (index < 0) return (DSK_Position){ 0, 0 };
+
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int secs = DSK_Track_GetSectorCount(t);
+		if (index < secs) return (DSK_Position){ t, index };
+		index -= secs;
+	}
+
+	return (DSK_Position){ 0, 0 };
+}
+
 int DSK_File_SeekPosition(FILE *f_disk, DSK_Position pos) {
 	if (f_disk == NULL) return 1;
 
@@ -62,41 +75,6 @@ int DSK_File_SeekPosition(FILE *f_disk, DSK_Position pos) {
 	return fseek(f_disk, offset, SEEK_SET);
 }
 
-DSK_Position DSK_GetHoveredSector() {
-	int mouse_x = GetMouseX();
-	int mouse_y = GetMouseY();
-	double len_x = (double) mouse_x - DISK_CENTRE_X;
-	double len_y = (double) mouse_y - DISK_CENTRE_Y;
-
-	// Calculate track-number from mouse pos
-	double hyp = sqrt((len_x * len_x) + (len_y * len_y));
-	double track_width = (((double) DISK_RADIUS - SPINDLE_RADIUS) / (MAX_TRACKS + MIN_TRACKS));
-	int tracknum = MIN_TRACKS + MAX_TRACKS - (hyp - SPINDLE_RADIUS) / track_width;
-
-	// Calculate angle from mouse pos
-	float oa = len_y / len_x;
-	float mouse_angle;
-	if (mouse_x - DISK_CENTRE_X < 0) {
-		mouse_angle = 180.0f + atanf(oa) * (360.0f / TAU);
-	} else {
-		if (mouse_y - DISK_CENTRE_Y < 0) {
-			mouse_angle = 360.0f + atanf(oa) * (360.0f / TAU);
-		} else {
-			mouse_angle = 0.0f + atanf(oa) * (360.0f / TAU);
-		}
-	}
-	mouse_angle += 90.0f;
-	if (mouse_angle > 360.0f) mouse_angle -= 360.0f;
-
-	int trklen = DSK_Track_GetSectorCount(tracknum);
-	int sec = mouse_angle / (360.0f / trklen);
-
-	return (DSK_Position){
-		.track = tracknum,
-		.sector = sec,
-	};
-}
-
 
 //	---- Retrieving Data
 
@@ -112,6 +90,7 @@ int DSK_File_GetData(FILE *f_disk, DSK_Position pos, void *buf, size_t bufsz) {
 }
 
 int DSK_File_ParseDirectory(FILE *f_disk, DSK_Directory *dir, bool ignore_bam) {
+	TRC_SCOPE("DSK_File_ParseDirectory");
 	if (f_disk == NULL || dir == NULL) return 1;
 
 	// Seek to track 18
@@ -136,25 +115,25 @@ int DSK_File_ParseDirectory(FILE *f_disk, DSK_Directory *dir, bool ignore_bam) {
 		} else {
 			next_pos = (DSK_Position){ 18, 1 };
 
-			// If the BAM bitmap is invalid; replace it with an empty one
-			//for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
-			//	if (t == 18) {
-			//		dir->bam[t-1] = (uint32_t) 0x07FFFC11;
-			//		continue;
-			//	}
-
-			//	dir->bam[t-1] = (uint32_t) 0x1FFFFF00 | DSK_Track_GetSectorCount(t);
-			//}
-
+			// The BAM can't be trusted; every sector counts as used until
+			// it's rebuilt from the file chains (see BAM_Verify)
+			memset(dir->bam, 0, sizeof(dir->bam));
+			fseek(f_disk, sizeof(uint32_t) * MAX_TRACKS, SEEK_CUR);
 		}
 	}
 
 	// Read the rest into the header string
 	fread(dir->header, sizeof(char), DIR_HEADER_SIZE-1, f_disk);
 
-	// Parse the directory blocks
+	// Parse the directory blocks; a chain that loops back or holds more
+	// entries than a directory can is damaged, and stops there
 	dir->num_entries = 0;
+	uint32_t visited[MAX_TRACKS] = { 0 };
 	while (DSK_IsPositionValid(next_pos)) {
+		uint32_t bit = 1u << next_pos.sector;
+		if (visited[next_pos.track - 1] & bit) return 4;
+		visited[next_pos.track - 1] |= bit;
+
 		DSK_File_SeekPosition(f_disk, next_pos);
 		fread(&next_pos, sizeof(DSK_Position), 1, f_disk);
 
@@ -169,6 +148,7 @@ int DSK_File_ParseDirectory(FILE *f_disk, DSK_Directory *dir, bool ignore_bam) {
 			fread(&pos, sizeof(DSK_Position), 1, f_disk);
 			index += sizeof(DSK_Position);
 			if (!DSK_IsPositionValid(pos)) break;
+			if (dir->num_entries >= MAX_DIR_ENTRIES) return 4;
 
 			uint8_t namebuf[16];
 			fread(&namebuf, sizeof(uint8_t), 16, f_disk);
@@ -219,28 +199,32 @@ int DSK_File_ParseDirectory(FILE *f_disk, DSK_Directory *dir, bool ignore_bam) {
 
 //	---- Debug Printing
 
-void DSK_PrintBAM(uint32_t bam[MAX_TRACKS]) {
-	printf("\n BAM Contents:\n");
-	printf("---------------------------------\n");
+void DSK_PrintBAM(FILE *f_out, uint32_t bam[MAX_TRACKS]) {
+	if (f_out == NULL) return;
+
+	fprintf(f_out, "\n BAM Contents:\n");
+	fprintf(f_out, "---------------------------------\n");
 	for (int i=0; i<MAX_TRACKS; i++) {
 		uint8_t sec_free = bam[i] & 0xFF;
 		int sec_total = DSK_Track_GetSectorCount(i+1);
-		printf(" Track % 3i: (% 3i/% 3i free) - ", i+1, sec_free, sec_total);
+		fprintf(f_out, " Track % 3i: (% 3i/% 3i free) - ", i+1, sec_free, sec_total);
 
 		for (int s=0; s<sec_total; s++) {
 			int is_free = (bam[i] >> (8 + s)) & 1;
-			printf("%c", is_free ? '_' : '#');
+			fputc(is_free ? '_' : '#', f_out);
 		}
 
-		putchar('\n');
+		fputc('\n', f_out);
 	}
 }
 
-void DSK_PrintDirectory(DSK_Directory dir) {
-	printf("\n Disk directory contents:\n--------------------------\n");
+void DSK_PrintDirectory(FILE *f_out, DSK_Directory dir) {
+	if (f_out == NULL) return;
+
+	fprintf(f_out, "\n Disk directory contents:\n--------------------------\n");
 	for (int i=0; i<dir.num_entries; i++) {
 		DSK_DirEntry e = dir.entries[i];
-		printf(" % 4i: [% 3i/% 3i] (%s) \"%s\" contains %i blocks\n", i,
+		fprintf(f_out, " % 4i: [% 3i/% 3i] (%s) \"%s\" contains %i blocks\n", i,
 			e.head_pos.track, e.head_pos.sector,
 			DSK_Sector_GetTypeName((DSK_SectorType) e.type), e.filename,
 			e.block_count
@@ -249,12 +233,12 @@ void DSK_PrintDirectory(DSK_Directory dir) {
 }
 
 
-//	---- Getting Strings & Colours
+//	---- Getting Strings
 
-char *DSK_GetDescription(DSK_Directory dir) {
-	static char buffer[128];
-	buffer[0] = '\0';
+int DSK_GetDescription(DSK_Directory dir, char *buf, size_t bufsz) {
+	if (buf == NULL || bufsz < 1) return 1;
 
+	char full[DSK_DESCRIPTION_SIZE];
 	int bi = 0;
 	int last_space = -1;
 	for (int i=0; i<DIR_HEADER_SIZE && dir.header[i] != '\0'; i++) {
@@ -265,31 +249,34 @@ char *DSK_GetDescription(DSK_Directory dir) {
 			last_space = bi;
 		}
 		last_space = -1;
-		buffer[bi++] = c;
+		full[bi++] = c;
 	}
-	if (last_space > 0) buffer[last_space] = '\0';
-	else buffer[bi] = '\0';
+	if (last_space > 0) full[last_space] = '\0';
+	else full[bi] = '\0';
 
-	return buffer;
+	int n = snprintf(buf, bufsz, "%s", full);
+	return (n >= (int) bufsz) ? 2 : 0;
 }
 
-char *DSK_GetName(DSK_Directory dir) {
-	static char buffer[18];
-	buffer[0] = '\0';
+int DSK_GetName(DSK_Directory dir, char *buf, size_t bufsz) {
+	if (buf == NULL || bufsz < 1) return 1;
 
-	char *full = DSK_GetDescription(dir);
+	char full[DSK_DESCRIPTION_SIZE];
+	char name[DSK_NAME_SIZE];
+	DSK_GetDescription(dir, full, sizeof(full));
 	int i = 0;
 	int last_space = 0;
-	while (i < 17 && full[i] != '\0') {
-		buffer[i] = full[i];
+	while (i < DSK_NAME_SIZE - 1 && full[i] != '\0') {
+		name[i] = full[i];
 		if (isspace(full[i])) last_space = i;
 		else last_space = 0;
 		i++;
 	}
 	if (last_space == 0) last_space = i;
-	buffer[last_space] = '\0';
+	name[last_space] = '\0';
 
-	return buffer;
+	int n = snprintf(buf, bufsz, "%s", name);
+	return (n >= (int) bufsz) ? 2 : 0;
 }
 
 const char *DSK_Sector_GetTypeName(DSK_SectorType type) {
@@ -307,146 +294,3 @@ const char *DSK_Sector_GetTypeName(DSK_SectorType type) {
 	}
 	return "";
 }
-
-Color DSK_Sector_GetTypeColour(DSK_SectorType type) {
-	switch(type) {
-		case SECTYPE_DEL: return BLACK;
-		case SECTYPE_SEQ: return GREEN;
-		case SECTYPE_PRG: return BLUE;
-		case SECTYPE_USR: return RED;
-		case SECTYPE_REL: return PURPLE;
-		case SECTYPE_EMPTY: return LIGHTGRAY;
-		case SECTYPE_BAM: return GOLD;
-		case SECTYPE_DIR: return GOLD;
-		case SECTYPE_UNKNOWN: return DARKGRAY;
-		case SECTYPE_INVALID: return MAGENTA;
-	}
-	return GRAY;
-}
-
-
-//	---- Drawing Functions
-
-void DSK_Sector_Draw(DSK_Directory dir, DSK_Position pos, DSK_DrawMode mode, Color clr) {
-	if (!DSK_IsPositionValid(pos)) return;
-
-	int track_index = MAX_TRACKS - pos.track;
-	int track_width = (DISK_RADIUS - SPINDLE_RADIUS)/MAX_TRACKS;
-	float r_inner = SPINDLE_RADIUS + track_width * track_index;
-	float r_outer = r_inner + track_width - TRACK_GAPS;
-	double sector_angle = 360.0f / (double)(DSK_Track_GetSectorCount(pos.track));
-	double start_angle = sector_angle * pos.sector - 90.0f;
-	double end_angle = start_angle + sector_angle - (1.0f/(float)(track_index+5) * SECTOR_GAPS);
-
-	DrawRing(
-		(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y },
-		r_inner, r_outer,
-		start_angle, end_angle,
-		ARC_RESOLUTION, clr
-	);
-
-	switch (mode) {
-		case DSK_DRAW_NORMAL: break;
-
-		case DSK_DRAW_HIGHLIGHT: {
-			DrawRing(
-				(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y },
-				r_inner, r_outer,
-				start_angle, end_angle,
-				ARC_RESOLUTION,
-				(Color){ 0xFF, 0xFF, 0xFF, 0x80 }
-			);
-		} return;
-
-		case DSK_DRAW_SELECTED: {
-			DrawRing(
-				(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y },
-				r_inner + 3.0f, r_outer - 3.0f,
-				start_angle + 0.8f, end_angle - 0.8f,
-				ARC_RESOLUTION,
-				WHITE
-			);
-		} return;
-
-	}
-}
-
-void __drawhexbyte(Font font, int x, int y, uint8_t byte, Color clr) {
-	for (int i=0; i<2; i++) {
-		uint8_t n = byte & 0x0F;
-
-		int o = ((1 - i) * 14);
-		if (n == 1) o += 6;
-
-		char c = '0';
-		if (n > 9) { n -= 10; c = 'A'; }
-		c += n;
-
-		DrawTextCodepoint(font, c,
-			(Vector2){ x + o, y },
-			20, clr
-		);
-
-		byte >>= 4;
-	}
-}
-
-void DSK_DrawData(int x, int y, void *buf, size_t bufsz, bool hex_mode, bool show_offset) {
-	if (buf == NULL) return;
-
-	Font font = GetFontDefault();
-	int line_num = 0;
-
-	int nx = x;
-	if (show_offset) nx += 40;
-	int cw = 32;
-	if (hex_mode) cw = 32;
-
-	for (int i=0; i<bufsz; i++) {
-		int bi = i & 0b1111;
-
-		int c = ((uint8_t *) buf)[i];
-		Color clr = BLACK;
-
-		if (isspace(c) || !isprint(c)) {
-			clr = LIGHTGRAY;
-			if (!hex_mode && isspace(c)) c = '.';
-		}
-
-		if (bi == 0) {
-			if (show_offset) {
-				__drawhexbyte(font, x, y + (line_num * 20), i, GRAY);
-			}
-
-			DrawTextCodepoint(font, '|',
-				(Vector2){ nx, y + (line_num * 20) },
-				20, BLACK
-			);
-		}
-
-		if (hex_mode) {
-			__drawhexbyte(font, nx + 10 + (bi * cw), y + (line_num * 20), c, clr);
-		} else {
-			DrawTextCodepoint(font, c,
-				(Vector2){ nx + 10 + (bi * cw), y + (line_num * 20) },
-				20, clr
-			);
-		}
-
-		if (bi == 15) {
-			DrawTextCodepoint(font, '|',
-				(Vector2){ nx + 10 + (16 * cw), y + (line_num++ * 20) },
-				20, BLACK
-			);
-		}
-	}
-
-	if ((bufsz & 0b111) != 0) {
-		DrawTextCodepoint(font, '|',
-			(Vector2){ nx + 10 + (16 * cw), y + (line_num++ * 20) },
-			20, BLACK
-		);
-	}
-
-}
-
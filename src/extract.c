@@ -0,0 +1,368 @@
+#include "../include/extract.h"
+#include "../include/trace.h"
+#include "../include/arena.h"
+#include <errno.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define __NAME_SIZE 64		// Host names of C64 files; 16 chars, a number & the extension
+
+//	Everything a worker needs for one image, taken afresh from its arena for every image
+#define __WORKER_ARENA_SIZE (ARN_SIZE(NYBLOG_SECTOR_COUNT * BLOCK_SIZE) + ARN_SIZE(sizeof(DSK_Directory)))
+
+//	One disk image of EXT_ExtractImages, with everything it produced
+typedef struct {
+	const char *filename;
+	char directory[EXT_PATH_SIZE];
+	int err;				// 2 = Unreadable, 3 = Failed to write a file, 4 = Directory path too long
+	EXT_Stats stats;
+	char *report;		// Written through a memory stream, so threads don't mix their reports
+	size_t report_size;
+} __image_job;
+
+typedef struct {
+	__image_job *jobs;
+	int num_jobs;
+	int next_job;
+	uint32_t flags;
+	pthread_mutex_t lock;
+} __image_queue;
+
+
+int EXT_FollowChain(const uint8_t *image, DSK_Position head, EXT_Chain *chain) {
+	if (image == NULL || chain == NULL) return 1;
+
+	memset(chain, 0, sizeof(EXT_Chain));
+
+	// Every block can be part of the chain once; seeing one again means it loops
+	uint32_t visited[(NYBLOG_SECTOR_COUNT + 31) / 32];
+	memset(visited, 0, sizeof(visited));
+
+	DSK_Position pos = head;
+	DSK_Position prev = head;
+	while (true) {
+		int index = DSK_PositionToIndex(pos);
+		if (index < 0) {
+			chain->status = EXTCHAIN_INVALID_LINK;
+			chain->broken_pos = prev;
+			return 2;
+		}
+		if (visited[index / 32] & (1u << (index % 32))) {
+			chain->status = EXTCHAIN_LOOP;
+			chain->broken_pos = prev;
+			return 2;
+		}
+		visited[index / 32] |= 1u << (index % 32);
+		chain->num_blocks++;
+
+		// The last block has no next track; its sector byte points at the last used byte instead
+		const uint8_t *block = image + (size_t) index * BLOCK_SIZE;
+		if (block[0] == 0x00) {
+			if (block[1] < 1) {
+				bool is_blank = true;
+				for (int i=2; i<BLOCK_SIZE && is_blank; i++) is_blank = (block[i] == 0x00);
+				chain->status = is_blank ? EXTCHAIN_BLANK_BLOCK : EXTCHAIN_INVALID_END;
+				chain->broken_pos = pos;
+				return 2;
+			}
+			chain->size += block[1] - 1;
+			return 0;
+		}
+
+		chain->size += BLOCK_SIZE - 2;
+		prev = pos;
+		pos = (DSK_Position){ block[0], block[1] };
+	}
+}
+
+int __host_filename(DSK_DirEntry entry, uint32_t flags, int copy, char *buf, size_t bufsz) {
+	char name[17];
+	int len = 0;
+	for (int i=0; i<16 && entry.filename[i] != '\0'; i++) {
+		char c = entry.filename[i];
+		if (!isprint((unsigned char) c) || strchr("/\\:*?\"<>|", c) != NULL) c = '_';
+		if (len == 0 && c == '.') c = '_';
+		name[len++] = c;
+	}
+	if (len == 0) name[len++] = '_';
+	name[len] = '\0';
+
+	char type = 'p';
+	switch (entry.type) {
+		case SECTYPE_SEQ: type = 's'; break;
+		case SECTYPE_USR: type = 'u'; break;
+		default: break;
+	}
+
+	// PC64 files are numbered by their extension; plain ones get a suffix
+	int n;
+	if (flags & EXT_FLAG_P00) {
+		n = snprintf(buf, bufsz, "%s.%c%02i", name, type, copy);
+	} else {
+		const char *ext = (type == 's') ? "seq" : (type == 'u') ? "usr" : "prg";
+		if (copy == 0) n = snprintf(buf, bufsz, "%s.%s", name, ext);
+		else n = snprintf(buf, bufsz, "%s_%i.%s", name, copy, ext);
+	}
+	if (n < 0 || n >= (int) bufsz) return 2;
+
+	return 0;
+}
+
+int EXT_GetHostFilename(DSK_DirEntry entry, uint32_t flags, char *buf, size_t bufsz) {
+	if (buf == NULL) return 1;
+	return __host_filename(entry, flags, 0, buf, bufsz);
+}
+
+const char *EXT_GetChainStatusName(EXT_ChainStatus status) {
+	switch (status) {
+		case EXTCHAIN_OK: return "OK";
+		case EXTCHAIN_INVALID_LINK: return "Links to a block that isn't on the disk";
+		case EXTCHAIN_LOOP: return "Links back to an earlier block of the file";
+		case EXTCHAIN_INVALID_END: return "Last block has no used bytes";
+		case EXTCHAIN_BLANK_BLOCK: return "Block is blank; it's most likely missing";
+	}
+	return "";
+}
+
+int EXT_ExtractFile(const uint8_t *image, DSK_DirEntry entry, const char *filename, uint32_t flags, EXT_Chain *chain) {
+	if (image == NULL || filename == NULL || chain == NULL) return 1;
+
+	// Nothing is written for a broken file, so check the whole chain first
+	if (EXT_FollowChain(image, entry.head_pos, chain) != 0) return 2;
+
+	FILE *f_out = fopen(filename, "wb");
+	if (f_out == NULL) return 3;
+
+	bool failed = false;
+	if (flags & EXT_FLAG_P00) {
+		uint8_t header[EXT_P00_HEADER_SIZE];
+		memset(header, 0, sizeof(header));
+		memcpy(header, EXT_P00_MAGIC, strlen(EXT_P00_MAGIC));
+		memcpy(header + 8, entry.filename, strnlen(entry.filename, 16));
+		failed = fwrite(header, sizeof(header), 1, f_out) != 1;
+	}
+
+	DSK_Position pos = entry.head_pos;
+	size_t remaining = chain->size;
+	while (!failed && remaining > 0) {
+		const uint8_t *block = image + (size_t) DSK_PositionToIndex(pos) * BLOCK_SIZE;
+		size_t len = (remaining < BLOCK_SIZE - 2) ? remaining : BLOCK_SIZE - 2;
+		failed = fwrite(block + 2, sizeof(uint8_t), len, f_out) != len;
+
+		remaining -= len;
+		pos = (DSK_Position){ block[0], block[1] };
+	}
+
+	if (fclose(f_out) != 0) failed = true;
+	if (failed) {
+		remove(filename);
+		return 3;
+	}
+
+	return 0;
+}
+
+int EXT_ExtractDirectory(const uint8_t *image, DSK_Directory *dir, const char *directory, uint32_t flags, FILE *f_report, EXT_Stats *stats) {
+	if (image == NULL || dir == NULL || directory == NULL || stats == NULL) return 1;
+
+	if (mkdir(directory, 0777) != 0 && errno != EEXIST) return 2;
+
+	char names[MAX_DIR_ENTRIES][__NAME_SIZE];
+	int err = 0;
+	for (int i=0; i<dir->num_entries; i++) {
+		DSK_DirEntry entry = dir->entries[i];
+		names[i][0] = '\0';
+		if (entry.type != SECTYPE_PRG && entry.type != SECTYPE_SEQ && entry.type != SECTYPE_USR) {
+			stats->files_skipped++;
+			continue;
+		}
+
+		// Earlier files of the same name keep theirs
+		int copy = 0;
+		int name_err = __host_filename(entry, flags, copy, names[i], __NAME_SIZE);
+		for (int j=0; j<i && name_err == 0; j++) {
+			if (strcmp(names[i], names[j]) != 0) continue;
+			name_err = __host_filename(entry, flags, ++copy, names[i], __NAME_SIZE);
+			j = -1;
+		}
+		if (name_err != 0) {
+			err = 3;
+			continue;
+		}
+
+		char path[EXT_PATH_SIZE];
+		int n = snprintf(path, sizeof(path), "%s/%s", directory, names[i]);
+		if (n < 0 || n >= (int) sizeof(path)) {
+			err = 3;
+			continue;
+		}
+
+		EXT_Chain chain;
+		switch (EXT_ExtractFile(image, entry, path, flags, &chain)) {
+			case 0: {
+				stats->files_written++;
+				stats->bytes += chain.size;
+				if (f_report != NULL && (flags & EXT_FLAG_LIST_FILES)) fprintf(f_report, "Extracted \"%s\" (%i blocks, %zu bytes) to '%s'\n", entry.filename, chain.num_blocks, chain.size, path);
+			} break;
+
+			case 2: {
+				stats->files_broken++;
+				if (f_report != NULL) fprintf(f_report, "Broken: \"%s\" at [% 3i/% 3i]: %s\n",
+					entry.filename, chain.broken_pos.track, chain.broken_pos.sector,
+					EXT_GetChainStatusName(chain.status)
+				);
+			} break;
+
+			default: err = 3; break;
+		}
+	}
+
+	return err;
+}
+
+void __extract_image(__image_job *job, uint32_t flags, ARN_Arena *arena) {
+	TRC_SCOPE_DETAIL("EXT_ExtractImage", job->filename);
+	FILE *f_report = open_memstream(&job->report, &job->report_size);
+
+	// The whole image is kept in memory; any error bytes at the end are ignored
+	ARN_Reset(arena);
+	FILE *f_disk = (job->err == 0) ? fopen(job->filename, "rb") : NULL;
+	DSK_Directory *dir = ARN_Alloc(arena, sizeof(DSK_Directory));
+	uint8_t *image = ARN_Calloc(arena, NYBLOG_SECTOR_COUNT * BLOCK_SIZE);
+	if (job->err != 0) {
+		// Its directory's path didn't fit
+	} else if (f_disk == NULL || dir == NULL || image == NULL || DSK_File_ParseDirectory(f_disk, dir, false) != 0) {
+		job->err = 2;
+	} else {
+		rewind(f_disk);
+		fread(image, BLOCK_SIZE, NYBLOG_SECTOR_COUNT, f_disk);
+		if (EXT_ExtractDirectory(image, dir, job->directory, flags, f_report, &job->stats) != 0) job->err = 3;
+	}
+
+	if (f_report != NULL) {
+		if (job->err == 2) fprintf(f_report, "Failed: Couldn't read the directory of the image\n");
+		if (job->err == 3) fprintf(f_report, "Failed: Couldn't write every file to '%s'\n", job->directory);
+		if (job->err == 4) fprintf(f_report, "Failed: The path of its export directory is too long\n");
+		fclose(f_report);
+	}
+	if (f_disk != NULL) fclose(f_disk);
+}
+
+void *__extract_images(void *arg) {
+	__image_queue *queue = arg;
+
+	// Allocated once per worker, however many images it gets through
+	ARN_Arena arena;
+	ARN_Init(&arena, __WORKER_ARENA_SIZE);
+
+	while (true) {
+		pthread_mutex_lock(&queue->lock);
+		int i = queue->next_job++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->num_jobs) break;
+
+		__extract_image(&queue->jobs[i], queue->flags, &arena);
+	}
+
+	ARN_Free(&arena);
+	return NULL;
+}
+
+//	Gets the name of an image without its path or extension
+const char *__image_name(const char *filename, int *len) {
+	const char *base = strrchr(filename, '/');
+	base = (base != NULL) ? base + 1 : filename;
+	const char *ext = strrchr(base, '.');
+	*len = (ext != NULL && ext != base) ? ext - base : (int) strlen(base);
+	return base;
+}
+
+int EXT_ExtractImages(char **filenames, int num_images, const char *directory, uint32_t flags, int num_threads, FILE *f_report, EXT_Stats *stats) {
+	if (filenames == NULL || directory == NULL || stats == NULL) return 1;
+
+	memset(stats, 0, sizeof(EXT_Stats));
+	if (mkdir(directory, 0777) != 0 && errno != EEXIST) return 2;
+
+	__image_job *jobs = calloc(num_images, sizeof(__image_job));
+	if (jobs == NULL) return 1;
+
+	// A single image goes straight into the directory; several get one each,
+	// with a number added to images of the same name like files of the same name
+	for (int i=0; i<num_images; i++) {
+		__image_job *job = &jobs[i];
+		job->filename = filenames[i];
+		int n;
+		if (num_images == 1) {
+			n = snprintf(job->directory, EXT_PATH_SIZE, "%s", directory);
+		} else {
+			int len;
+			const char *base = __image_name(filenames[i], &len);
+
+			// Numbering starts after the earlier images of the same name, and
+			// goes on while that's taken by an image that happens to be named like it
+			int copy = 0;
+			for (int j=0; j<i; j++) {
+				int other_len;
+				const char *other = __image_name(filenames[j], &other_len);
+				if (other_len == len && memcmp(other, base, len) == 0) copy++;
+			}
+			while (true) {
+				if (copy == 0) n = snprintf(job->directory, EXT_PATH_SIZE, "%s/%.*s", directory, len, base);
+				else n = snprintf(job->directory, EXT_PATH_SIZE, "%s/%.*s~%i", directory, len, base, copy);
+				if (n < 0 || n >= EXT_PATH_SIZE) break;
+
+				bool taken = false;
+				for (int j=0; j<i && !taken; j++) taken = (strcmp(job->directory, jobs[j].directory) == 0);
+				if (!taken) break;
+				copy++;
+			}
+		}
+		if (n < 0 || n >= EXT_PATH_SIZE) job->err = 4;
+	}
+
+	if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads > EXT_MAX_THREADS) num_threads = EXT_MAX_THREADS;
+	if (num_threads > num_images) num_threads = num_images;
+	if (num_threads < 1) num_threads = 1;
+
+	__image_queue queue = {
+		.jobs = jobs,
+		.num_jobs = num_images,
+		.flags = flags,
+	};
+	pthread_mutex_init(&queue.lock, NULL);
+
+	// Whatever threads can't be started, the calling one makes up for
+	pthread_t threads[EXT_MAX_THREADS];
+	int num_started = 0;
+	while (num_started < num_threads - 1) {
+		if (pthread_create(&threads[num_started], NULL, __extract_images, &queue) != 0) break;
+		num_started++;
+	}
+	__extract_images(&queue);
+	for (int i=0; i<num_started; i++) pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+
+	int err = 0;
+	for (int i=0; i<num_images; i++) {
+		__image_job *job = &jobs[i];
+		if (f_report != NULL && job->report_size > 0) {
+			fprintf(f_report, "%s:\n", job->filename);
+			fwrite(job->report, sizeof(char), job->report_size, f_report);
+		}
+		free(job->report);
+
+		if (job->err != 0) {
+			stats->images_failed++;
+			err = 3;
+		}
+		stats->files_written += job->stats.files_written;
+		stats->files_broken += job->stats.files_broken;
+		stats->files_skipped += job->stats.files_skipped;
+		stats->bytes += job->stats.bytes;
+	}
+	free(jobs);
+
+	return err;
+}
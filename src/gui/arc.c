@@ -1,4 +1,4 @@
-#include "../include/arc.h"
+#include "../../include/arc.h"
 
 
 //void Draw_Arc(int x, int y, int r_inner, int r_outer, double start_angle, double end_angle, Color clr) {
@@ -0,0 +1,405 @@
+#include "../../include/gui.h"
+
+int g_debug_int = 0;
+double g_debug_prog = 1.0;
+static int __debug_prog_speed = 0;
+bool g_show_debug_view = false;
+
+static int __last_key = 0;
+
+
+//	---- Colours
+
+Color DSK_Sector_GetTypeColour(DSK_SectorType type) {
+	switch(type) {
+		case SECTYPE_DEL: return BLACK;
+		case SECTYPE_SEQ: return GREEN;
+		case SECTYPE_PRG: return BLUE;
+		case SECTYPE_USR: return RED;
+		case SECTYPE_REL: return PURPLE;
+		case SECTYPE_EMPTY: return LIGHTGRAY;
+		case SECTYPE_BAM: return GOLD;
+		case SECTYPE_DIR: return GOLD;
+		case SECTYPE_UNKNOWN: return DARKGRAY;
+		case SECTYPE_INVALID: return MAGENTA;
+	}
+	return GRAY;
+}
+
+Color ANA_GetStatusColour(ANA_Status status) {
+	switch (status) {
+		case SECSTAT_EMPTY: return LIGHTGRAY;
+		case SECSTAT_UNEXPECTED: return SKYBLUE;
+
+		case SECSTAT_MISSING: return BLACK;
+		case SECSTAT_BAD: return RED;
+		case SECSTAT_CORRUPTED: return MAROON;
+
+		case SECSTAT_PRESENT: return GOLD;
+
+		case SECSTAT_GOOD: return GREEN;
+		case SECSTAT_CONFIRMED: return LIME;
+
+		case SECSTAT_UNKNOWN: return DARKGRAY;
+
+		case SECSTAT_INVALID: return MAGENTA;
+	}
+
+	return BLACK;
+}
+
+double __normalise(double x) {
+	if (x < 0.0) x = fabs(x);
+	if (x > 1.0) x -= (int) x;
+	return x;
+}
+
+double __clamp(double x) {
+	if (x < 0.0) return 0.0;
+	if (x > 1.0) return 1.0;
+	return x;
+}
+
+double __trapezoid_wave(double x) {
+	x = __normalise(x);
+
+	double m = x * 6;
+	int seg = m;
+	switch (seg) {
+		case 0: return m;
+		case 1: return 1.0;
+		case 2: return 1.0;
+		case 3: return 1.0 - (m - 3.0);
+		case 4: return 0.0;
+		case 5: return 0.0;
+	}
+	return x;
+}
+
+Color __hsv_to_rgb(double h, double s, double v) {
+	h = __normalise(h);
+	s = __normalise(s);
+	v = __normalise(v);
+
+	double c = v * s;
+	double m = v - c;
+
+	double r = c * __trapezoid_wave(h + 0.6666);
+	double g = c * __trapezoid_wave(h + 0.0001);
+	double b = c * __trapezoid_wave(h + 0.3333);
+
+	return (Color){
+		0xFF * (r + m),
+		0xFF * (g + m),
+		0xFF * (b + m),
+		0xFF
+	};
+}
+
+Color ANA_GetFileColour(DSK_Directory dir, ANA_SectorInfo entry, bool is_hovered, bool is_selected) {
+	if (entry.dir_index < 0) return LIGHTGRAY;
+
+	Color clr = __hsv_to_rgb(
+		(double) entry.dir_index / (double) dir.num_entries,
+		//(double) entry.dir_entry.pos.track / (double) 15,
+		0.5 + (is_selected ? 0.5 : 0.0),
+		0.7 + (!is_selected && is_hovered ? 0.1 : 0.0) + (is_selected ? 0.3 : 0.0)
+	);
+
+	return clr;
+}
+
+Color ANA_GetParseErrorColour(int err_code) {
+	if (err_code == 0) return GREEN;
+	return RED;
+}
+
+Color ANA_GetDiskErrorColour(uint8_t  err_code) {
+	uint8_t e = err_code & ~0x80;
+	if (e == 0) return GREEN;
+	if (e == 1) return BLUE;
+	if (e >= 20 && e <= 74) return RED;
+	return MAGENTA;
+}
+
+Color HMP_GetHeatColour(float heat) {
+	if (heat <= 0.0f) return GREEN;
+	if (heat > 1.0f) heat = 1.0f;
+
+	// Green to gold over the first half, gold to red over the second
+	Color a = (heat < 0.5f) ? GREEN : GOLD;
+	Color b = (heat < 0.5f) ? GOLD : RED;
+	float f = (heat < 0.5f) ? heat * 2.0f : (heat - 0.5f) * 2.0f;
+	return (Color){
+		a.r + (b.r - a.r) * f,
+		a.g + (b.g - a.g) * f,
+		a.b + (b.b - a.b) * f,
+		0xFF
+	};
+}
+
+
+//	---- Drawing Functions
+
+void DSK_Sector_Draw(DSK_Directory dir, DSK_Position pos, DSK_DrawMode mode, Color clr) {
+	if (!DSK_IsPositionValid(pos)) return;
+
+	int track_index = MAX_TRACKS - pos.track;
+	int track_width = (DISK_RADIUS - SPINDLE_RADIUS)/MAX_TRACKS;
+	float r_inner = SPINDLE_RADIUS + track_width * track_index;
+	float r_outer = r_inner + track_width - TRACK_GAPS;
+	double sector_angle = 360.0f / (double)(DSK_Track_GetSectorCount(pos.track));
+	double start_angle = sector_angle * pos.sector - 90.0f;
+	double end_angle = start_angle + sector_angle - (1.0f/(float)(track_index+5) * SECTOR_GAPS);
+
+	DrawRing(
+		(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y },
+		r_inner, r_outer,
+		start_angle, end_angle,
+		ARC_RESOLUTION, clr
+	);
+
+	switch (mode) {
+		case DSK_DRAW_NORMAL: break;
+
+		case DSK_DRAW_HIGHLIGHT: {
+			DrawRing(
+				(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y },
+				r_inner, r_outer,
+				start_angle, end_angle,
+				ARC_RESOLUTION,
+				(Color){ 0xFF, 0xFF, 0xFF, 0x80 }
+			);
+		} return;
+
+		case DSK_DRAW_SELECTED: {
+			DrawRing(
+				(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y },
+				r_inner + 3.0f, r_outer - 3.0f,
+				start_angle + 0.8f, end_angle - 0.8f,
+				ARC_RESOLUTION,
+				WHITE
+			);
+		} return;
+
+	}
+}
+
+void __drawhexbyte(Font font, int x, int y, uint8_t byte, Color clr) {
+	for (int i=0; i<2; i++) {
+		uint8_t n = byte & 0x0F;
+
+		int o = ((1 - i) * 14);
+		if (n == 1) o += 6;
+
+		char c = '0';
+		if (n > 9) { n -= 10; c = 'A'; }
+		c += n;
+
+		DrawTextCodepoint(font, c,
+			(Vector2){ x + o, y },
+			20, clr
+		);
+
+		byte >>= 4;
+	}
+}
+
+void DSK_DrawData(int x, int y, void *buf, size_t bufsz, bool hex_mode, bool show_offset) {
+	if (buf == NULL) return;
+
+	Font font = GetFontDefault();
+	int line_num = 0;
+
+	int nx = x;
+	if (show_offset) nx += 40;
+	int cw = 32;
+	if (hex_mode) cw = 32;
+
+	for (int i=0; i<bufsz; i++) {
+		int bi = i & 0b1111;
+
+		int c = ((uint8_t *) buf)[i];
+		Color clr = BLACK;
+
+		if (isspace(c) || !isprint(c)) {
+			clr = LIGHTGRAY;
+			if (!hex_mode && isspace(c)) c = '.';
+		}
+
+		if (bi == 0) {
+			if (show_offset) {
+				__drawhexbyte(font, x, y + (line_num * 20), i, GRAY);
+			}
+
+			DrawTextCodepoint(font, '|',
+				(Vector2){ nx, y + (line_num * 20) },
+				20, BLACK
+			);
+		}
+
+		if (hex_mode) {
+			__drawhexbyte(font, nx + 10 + (bi * cw), y + (line_num * 20), c, clr);
+		} else {
+			DrawTextCodepoint(font, c,
+				(Vector2){ nx + 10 + (bi * cw), y + (line_num * 20) },
+				20, clr
+			);
+		}
+
+		if (bi == 15) {
+			DrawTextCodepoint(font, '|',
+				(Vector2){ nx + 10 + (16 * cw), y + (line_num++ * 20) },
+				20, BLACK
+			);
+		}
+	}
+
+	if ((bufsz & 0b111) != 0) {
+		DrawTextCodepoint(font, '|',
+			(Vector2){ nx + 10 + (16 * cw), y + (line_num++ * 20) },
+			20, BLACK
+		);
+	}
+
+}
+
+DSK_Position DSK_GetHoveredSector() {
+	int mouse_x = GetMouseX();
+	int mouse_y = GetMouseY();
+	double len_x = (double) mouse_x - DISK_CENTRE_X;
+	double len_y = (double) mouse_y - DISK_CENTRE_Y;
+
+	// Calculate track-number from mouse pos
+	double hyp = sqrt((len_x * len_x) + (len_y * len_y));
+	double track_width = (((double) DISK_RADIUS - SPINDLE_RADIUS) / (MAX_TRACKS + MIN_TRACKS));
+	int tracknum = MIN_TRACKS + MAX_TRACKS - (hyp - SPINDLE_RADIUS) / track_width;
+
+	// Calculate angle from mouse pos
+	float oa = len_y / len_x;
+	float mouse_angle;
+	if (mouse_x - DISK_CENTRE_X < 0) {
+		mouse_angle = 180.0f + atanf(oa) * (360.0f / TAU);
+	} else {
+		if (mouse_y - DISK_CENTRE_Y < 0) {
+			mouse_angle = 360.0f + atanf(oa) * (360.0f / TAU);
+		} else {
+			mouse_angle = 0.0f + atanf(oa) * (360.0f / TAU);
+		}
+	}
+	mouse_angle += 90.0f;
+	if (mouse_angle > 360.0f) mouse_angle -= 360.0f;
+
+	int trklen = DSK_Track_GetSectorCount(tracknum);
+	int sec = mouse_angle / (360.0f / trklen);
+
+	return (DSK_Position){
+		.track = tracknum,
+		.sector = sec,
+	};
+}
+
+
+//	---- Debug View
+
+bool DEBUG_HandleEvents(int pressed) {
+	//printf("---> Pressed char: '%c'\n", pressed);
+	if (pressed != 0) __last_key = pressed;
+
+	static double t_last = 0;
+	double t_now = GetTime();
+	if (t_now - t_last > (50 - __debug_prog_speed) * (0.010)) {
+		//printf("---> Tick took %4.4f ms\n", elapsed * 1000.0);
+		g_debug_prog += 0.1;
+		if (g_debug_prog > 1.0) g_debug_prog -= 1.0;
+		if (g_debug_prog < 0.0) g_debug_prog += 1.0;
+		t_last = t_now;
+	}
+
+	if (IsKeyDown(KEYCODE_SHIFT)) {
+		if (pressed == KEYCODE_DEBUG_INT_INC && __debug_prog_speed < 100) { __debug_prog_speed++; return true; }
+		if (pressed == KEYCODE_DEBUG_INT_DEC && __debug_prog_speed > 0) { __debug_prog_speed--; return true; }
+	} else {
+		if (pressed == KEYCODE_DEBUG_INT_INC && g_debug_int < 100) { g_debug_int++; return true; }
+		if (pressed == KEYCODE_DEBUG_INT_DEC && g_debug_int > 0) { g_debug_int--; return true; }
+	}
+	if (pressed == KEYCODE_DEBUG_VIEW_TOGGLE) { g_show_debug_view = !g_show_debug_view; return true; }
+
+	return false;
+}
+
+void DEBUG_DrawDevInfo() {
+	if (!g_show_debug_view) return;
+
+	int mouse_x = GetMouseX();
+	int mouse_y = GetMouseY();
+	double len_x = mouse_x - DISK_CENTRE_Y;
+	double len_y = mouse_y - DISK_CENTRE_X;
+
+	double hyp = sqrt((len_x * len_x) + (len_y * len_y));
+
+	//	Draw line to cursor
+	DrawLineEx(
+		(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y }, 
+		(Vector2){ mouse_x, DISK_CENTRE_Y },
+		4, RED
+	);
+	DrawLineEx(
+		(Vector2){ mouse_x, DISK_CENTRE_Y }, 
+		(Vector2){ mouse_x, mouse_y },
+		4, GREEN
+	);
+	DrawLineEx(
+		(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y }, 
+		(Vector2){ mouse_x, mouse_y },
+		4, BLUE
+	);
+
+	// Calculate angle from mouse pos
+	float oa = len_y / len_x;
+	float mouse_angle;
+	if (len_x < 0) {
+		mouse_angle = 180.0f + atanf(oa) * (360.0f / (2*M_PI));
+	} else {
+		if (len_y < 0) {
+			mouse_angle = 360.0f + atanf(oa) * (360.0f / (2*M_PI));
+		} else {
+			mouse_angle = 0.0f + atanf(oa) * (360.0f / (2*M_PI));
+		}
+	}
+
+	// Draw mouse angle & radius
+	DrawRing(
+		(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y }, 
+		0.0f, 20.0f,
+		0.0f, mouse_angle,
+		64, RED
+	);
+	DrawRing(
+		(Vector2){ DISK_CENTRE_X, DISK_CENTRE_Y }, 
+		hyp, hyp + 10.0f,
+		0.0f, 360.0f,
+		64, PURPLE
+	);
+
+	// Draw cursor info
+	char buf[256];
+	sprintf(buf, "Mouse Position: %i/%i\n", mouse_x, mouse_y);
+	DrawText(buf, 10, 10,  20, BLACK);
+	sprintf(buf, "Relative Position: %4.2f/%4.2f\n", len_x, len_y);
+	DrawText(buf, 10, 30,  20, BLACK);
+	sprintf(buf, "Cursor Angle: %4.4f°\n", mouse_angle);
+	DrawText(buf, 10, 50,  20, BLACK);
+	sprintf(buf, "Cursor Radius: %4.4f\n", hyp);
+	DrawText(buf, 10, 70,  20, BLACK);
+
+	// Print last pressed key
+	sprintf(buf, "Last Keycode: %i\n", __last_key);
+	DrawText(buf, 10, 100,  20, MAROON);
+
+	sprintf(buf, "Debug int value: %i\n", g_debug_int);
+	DrawText(buf, 10, 120,  20, MAROON);
+	sprintf(buf, "Debug int prog speed: %i\n", __debug_prog_speed);
+	DrawText(buf, 10, 140,  20, MAROON);
+
+}
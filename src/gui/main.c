@@ -0,0 +1,1206 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <raylib.h>
+
+#include "../../include/debug.h"
+#include "../../include/disk.h"
+#include "../../include/analysis.h"
+#include "../../include/cli.h"
+#include "../../include/extract.h"
+#include "../../include/session.h"
+#include "../../include/diff.h"
+#include "../../include/search.h"
+#include "../../include/query.h"
+#include "../../include/heatmap.h"
+#include "../../include/gui.h"
+
+
+#define FRAMERATE 30		// FPS
+#define SCREEN_WIDTH 1600
+#define SCREEN_HEIGHT 1000
+
+#define KEY_TOGGLE_HEX_MODE 290
+#define KEY_TOGGLE_VIEW_MODE 291
+#define KEY_CANCEL_LOAD 292
+#define KEY_TOGGLE_SEARCH 293
+#define KEY_SEARCH_NEXT 257
+#define KEY_SEARCH_ERASE 259
+#define KEY_TOGGLE_QUERY 295
+#define KEY_QUERY_NEXT 258
+#define KEY_ARROW_RIGHT 262
+#define KEY_ARROW_LEFT 263
+#define KEY_ARROW_DOWN 264
+#define KEY_ARROW_UP 265
+
+#define CLR_ACCENT BLUE
+
+// Function Declarations
+void draw_text(const char *text, int x, int y, int align, Color clr);
+bool is_key_held(int keycode);
+void draw_progress(SES_Progress progress, Rectangle btnrect_cancel);
+int view_heatmap(CLI_Arguments args);
+
+int main(int argc, char *argv[]) {
+
+	// Read Input Parameters
+
+	CLI_Arguments args = { .mode = RUNMODE_VIEW };
+	CLI_ParseArgs(argc, argv, &args);
+	CLI_StartTrace(args);
+
+	// A single pair is shown in the viewer instead; the first image with what changed in the second
+	char *diff_filename = NULL;
+	if (args.mode == RUNMODE_DIFF && args.num_inputs == 2) {
+		args.mode = RUNMODE_VIEW;
+		args.disk_filename = args.input_filenames[0];
+		diff_filename = args.input_filenames[1];
+	}
+	// The counts of an archive of recon files are shown on the disk instead
+	if (args.mode == RUNMODE_HEATMAP) return view_heatmap(args);
+	int status = CLI_RunBatchMode(args);
+	if (status >= 0) return status;
+
+	char *disk_filename = args.disk_filename;
+	char *export_directory = args.export_directory;
+	if (!g_verbose_log) SetTraceLogLevel(LOG_WARNING);
+
+	// Only write the re-transfer plan if one was requested; there's no window to wait in
+	SES_Session session;
+	if (args.plan_filename != NULL) {
+		status = CLI_LoadDisk(args, &session);
+		if (status != EXIT_SUCCESS) return status;
+		status = CLI_WritePlan(args, session.analysis);
+		SES_Close(&session);
+		return status;
+	}
+
+	// Import, read & analyse the disk on a worker thread, so the window opens right away
+	SES_Options options;
+	CLI_GetSessionOptions(args, &options);
+	if (SES_Init(&session, options) != 0) exit(EXIT_FAILURE);
+	if (SES_Start(&session) != 0) {
+		printf("Error: Failed to start loading '%s'\n", disk_filename);
+		return EXIT_FAILURE;
+	}
+
+	//	Initialisation
+	InitWindow(
+		SCREEN_WIDTH, SCREEN_HEIGHT,
+		"Disekt"
+	);
+	SetTargetFPS(FRAMERATE);
+
+	const Rectangle btnrect_cancel = {
+		10 + 200 + 10, 10 + 90,
+		130, 30,
+	};
+
+	// Wait for the BAM to be read; that's enough to show the disk
+	int generation = 0;
+	SES_Progress progress;
+	bool should_close = false;
+	while (!SES_Poll(&session, &generation, &progress)) {
+		if (progress.stage == SESSTAGE_FAILED || progress.stage == SESSTAGE_CANCELLED) break;
+
+		if (!should_close) should_close = WindowShouldClose();
+		if (should_close
+			|| IsKeyPressed(KEY_CANCEL_LOAD)
+			|| (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && CheckCollisionPointRec(GetMousePosition(), btnrect_cancel))
+		) SES_Cancel(&session);
+
+		BeginDrawing();
+		ClearBackground(RAYWHITE);
+		draw_text("Loading...", 10, 10, -1, GRAY);
+		draw_text(TextFormat("\"%s\"", disk_filename),
+			10, 10 + 30, -1, BLACK
+		);
+		draw_progress(progress, btnrect_cancel);
+		EndDrawing();
+	}
+	if (generation == 0) {
+		CloseWindow();
+		status = CLI_ReportLoadError(args, SES_Finish(&session), progress.err_detail);
+		SES_Close(&session);
+		return status;
+	}
+
+	// The image is only compared once any import has written it
+	DIF_Diff diff;
+	memset(&diff, 0, sizeof(DIF_Diff));
+	bool has_diff = false;
+	if (diff_filename != NULL) {
+		ARN_Arena diff_arena;
+		if (ARN_Init(&diff_arena, DIF_ARENA_SIZE) != 0) exit(EXIT_FAILURE);
+		DIF_FileStats diff_stats;
+		int diff_err = DIF_DiffFiles(disk_filename, diff_filename, &diff_arena, g_verbose_log ? stdout : NULL, &diff, &diff_stats);
+		ARN_Free(&diff_arena);
+		if (diff_err != 0) printf("Error: Failed to read disk image '%s'\n", (diff_err == 3) ? diff_filename : disk_filename);
+		has_diff = (diff_err == 0);
+	}
+
+	//	Main Drawing Loop
+
+	// The latest snapshot of the session; only this thread touches it
+	DSK_Directory *dir = session.view_dir;
+	ANA_DiskInfo *analysis = session.view;
+
+	DSK_Position curr_pos = DSK_POSITION_BAM;
+	ANA_SectorInfo curr_sector;
+	uint16_t curr_checksum = 0x0000;
+	int err = ANA_GetInfo(*analysis, curr_pos, &curr_sector);
+	if (err != 0) {
+		printf("Failed to get info for current sector (% 3i/% 3i): Err-code %i\n", curr_pos.track, curr_pos.sector, err);
+		return EXIT_FAILURE;
+	} else {
+		curr_checksum = DSK_Checksum(curr_sector.data);
+	}
+	char name[DSK_NAME_SIZE];
+	DSK_GetName(*dir, name, sizeof(name));
+
+	const int info_x = DISK_CENTRE_X * 2;
+	const int info_tab_x = info_x + (16 * 12);
+
+	// Button Rectangles
+	const Rectangle btnrect_previous = {
+		info_x + 10, 10 + (28 * 20),
+		80, 40,
+	};
+	const Rectangle btnrect_next = {
+		info_x + 20 + 80, 10 + (28 * 20),
+		80, 40,
+	};
+	const Rectangle btnrect_export = {
+		info_x + 10, 10 + (26 * 20) - 5,
+		170, 40,
+	};
+
+	enum {
+		VIEW_SECSTAT, 
+		VIEW_BAM, 
+		VIEW_TRANSFER, 
+		VIEW_SECTYPE, 
+		VIEW_FILES, 
+		VIEW_DIFF,
+		VIEW_QUERY,
+		VIEW_INVALID,
+	} view_mode = has_diff ? VIEW_DIFF : VIEW_SECSTAT;
+	bool hex_mode = false;
+
+	// Text typed into the search box; a leading '$' makes it hex bytes
+	char search_text[SCH_MAX_PATTERN * 3 + 2] = "";
+	int search_len = 0;
+	bool is_search_typing = false;
+	bool has_search = false;
+	static SCH_Result search_result;
+
+	// Expression of the sectors to highlight; its matches are worked out again as the analysis changes
+	char query_text[QRY_MAX_TEXT] = "";
+	int query_len = 0;
+	bool is_query_typing = false;
+	bool has_query = false;
+	QRY_Query query;
+	ANA_Bitset query_matches;
+	memset(&query_matches, 0, sizeof(ANA_Bitset));
+	if (args.sector_query != NULL) {
+		query_len = snprintf(query_text, sizeof(query_text), "%s", args.sector_query);
+		if (query_len >= (int) sizeof(query_text)) query_len = sizeof(query_text) - 1;
+		has_query = (QRY_Parse(query_text, &query, NULL) == 0);
+		if (has_query) {
+			QRY_Evaluate(&query, analysis, &query_matches);
+			view_mode = VIEW_QUERY;
+		}
+	}
+	while (!should_close && !WindowShouldClose()) {
+
+		// Pick up the analysis as the worker refines it
+		bool sector_changed = false;
+		if (SES_Poll(&session, &generation, &progress)) {
+			DSK_GetName(*dir, name, sizeof(name));
+			sector_changed = true;
+			if (has_query) QRY_Evaluate(&query, analysis, &query_matches);
+		}
+		if (progress.stage == SESSTAGE_FAILED) break;
+
+		// Handle inputs
+		DSK_Position hov = DSK_GetHoveredSector();
+
+		if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON)) {
+			if (DSK_IsPositionValid(hov)) {
+				curr_pos = hov;
+				sector_changed = true;
+			}
+
+			if (curr_sector.type == SECTYPE_DIR) {
+				for (int i=0; i<8; i++) {
+					DSK_DirEntry entry = dir->entries[ curr_sector.dir_index + i ];
+					Rectangle rect = {
+						info_x + 30, 10 + ((15+i) * 20),
+						50 + MeasureText(entry.filename, 20), 20,
+					};
+
+					if (DSK_IsPositionValid(entry.head_pos)
+						&& !DSK_PositionsEqual(entry.head_pos, DSK_POSITION_BAM)
+						&& CheckCollisionPointRec(GetMousePosition(), rect)
+					) {
+						curr_pos = entry.head_pos;
+						sector_changed = true;
+					}
+				}
+			}
+
+			// Previous Button
+			if (curr_sector.prev_block_index >= 0) {
+				if (CheckCollisionPointRec(GetMousePosition(), btnrect_previous)) {
+					curr_pos = analysis->sectors[curr_sector.prev_block_index].pos;
+					sector_changed = true;
+				}
+			}
+
+			// Next Button
+			if (curr_sector.next_block_index >= 0) {
+				if (CheckCollisionPointRec(GetMousePosition(), btnrect_next)) {
+					curr_pos = analysis->sectors[curr_sector.next_block_index].pos;
+					sector_changed = true;
+				}
+			}
+
+			// Export Button
+			if (export_directory != NULL && (
+					curr_sector.type == SECTYPE_PRG
+					|| curr_sector.type == SECTYPE_SEQ
+					|| curr_sector.type == SECTYPE_USR
+				)
+			) {
+				if (CheckCollisionPointRec(GetMousePosition(), btnrect_export)) {
+					// The analysis has the best copy of every sector, recon data included
+					static uint8_t image[MAX_ANALYSIS_ENTRIES * BLOCK_SIZE];
+					for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) memcpy(image + i * BLOCK_SIZE, analysis->sectors[i].data, BLOCK_SIZE);
+
+					DSK_DirEntry entry = curr_sector.dir_entry;
+					char filename[64];
+					char path[EXT_PATH_SIZE];
+					EXT_GetHostFilename(entry, args.export_flags, filename, sizeof(filename));
+					snprintf(path, sizeof(path), "%s/%s", export_directory, filename);
+					mkdir(export_directory, 0777);
+
+					EXT_Chain chain;
+					err = EXT_ExtractFile(image, entry, path, args.export_flags, &chain);
+					switch (err) {
+						case 0: printf("Exported file '%s' (%zu bytes) to '%s'\n", entry.filename, chain.size, path); break;
+						case 2: printf("Error: Can't export file '%s'; its chain is broken at [% 3i/% 3i]: %s\n",
+							entry.filename, chain.broken_pos.track, chain.broken_pos.sector, EXT_GetChainStatusName(chain.status)
+						); break;
+						default: printf("Error: Failed to export file '%s' to '%s'\n", entry.filename, path); break;
+					}
+				}
+			}
+
+		}
+
+		// Arrow navigation
+		if (is_key_held(KEY_ARROW_UP) && curr_pos.track < 35) { curr_pos.track++; sector_changed = true; }
+		if (is_key_held(KEY_ARROW_DOWN) && curr_pos.track > 1) { curr_pos.track--; sector_changed = true; }
+		if (is_key_held(KEY_ARROW_LEFT)) { curr_pos.sector--; sector_changed = true; }
+		if (is_key_held(KEY_ARROW_RIGHT)) { curr_pos.sector++; sector_changed = true; }
+
+		int secs = DSK_Track_GetSectorCount(curr_pos.track);
+		if (curr_pos.sector > 0x80) curr_pos.sector = secs - 1;
+		if (curr_pos.sector >= secs) curr_pos.sector = 0;
+
+		int key = GetKeyPressed();
+		if (DEBUG_HandleEvents(key)) key = 0;
+		if (key != 0) {
+			switch (key) {
+				case KEY_TOGGLE_HEX_MODE: { hex_mode = !hex_mode; } break;
+				case KEY_TOGGLE_SEARCH: { is_search_typing = !is_search_typing; is_query_typing = false; } break;
+				case KEY_TOGGLE_QUERY: { is_query_typing = !is_query_typing; is_search_typing = false; } break;
+				case KEY_SEARCH_ERASE: {
+					if (is_search_typing && search_len > 0) search_text[--search_len] = '\0';
+					if (is_query_typing && query_len > 0) query_text[--query_len] = '\0';
+				} break;
+				case KEY_QUERY_NEXT: {
+					if (!has_query) break;
+
+					int next_index = ANA_Bitset_Next(&query_matches, DSK_PositionToIndex(curr_pos));
+					if (next_index < 0) break;
+					curr_pos = DSK_IndexToPosition(next_index);
+					sector_changed = true;
+				} break;
+				case KEY_SEARCH_NEXT: {
+					// The query box shows its matches & jumps to the first one
+					if (is_query_typing) {
+						is_query_typing = false;
+						has_query = (QRY_Parse(query_text, &query, NULL) == 0);
+						if (!has_query) break;
+
+						QRY_Evaluate(&query, analysis, &query_matches);
+						view_mode = VIEW_QUERY;
+						int next_index = ANA_Bitset_Next(&query_matches, -1);
+						if (next_index < 0) break;
+						curr_pos = DSK_IndexToPosition(next_index);
+						sector_changed = true;
+						break;
+					}
+
+					bool is_new_search = is_search_typing;
+					if (is_search_typing) {
+						is_search_typing = false;
+
+						// Searches what the analysis has for each sector, recon data included
+						static uint8_t image[MAX_ANALYSIS_ENTRIES * BLOCK_SIZE];
+						for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) memcpy(image + i * BLOCK_SIZE, analysis->sectors[i].data, BLOCK_SIZE);
+
+						SCH_Pattern pattern;
+						bool is_hex = (search_text[0] == '$');
+						has_search = (SCH_ParsePattern(search_text + (is_hex ? 1 : 0), is_hex, &pattern) == 0);
+						if (has_search) SCH_SearchImage(image, dir, &pattern, &search_result);
+					}
+					if (!has_search || search_result.num_hits == 0) break;
+
+					// Jumps to the next hit after the selected sector, wrapping around; a new search starts at the first
+					int curr_index = is_new_search ? -1 : DSK_PositionToIndex(curr_pos);
+					int num_stored = (search_result.num_hits < SCH_MAX_HITS) ? search_result.num_hits : SCH_MAX_HITS;
+					DSK_Position next_pos = search_result.hits[0].pos;
+					for (int i=0; i<num_stored; i++) {
+						if (DSK_PositionToIndex(search_result.hits[i].pos) <= curr_index) continue;
+						next_pos = search_result.hits[i].pos;
+						break;
+					}
+					curr_pos = next_pos;
+					sector_changed = true;
+				} break;
+				case KEY_TOGGLE_VIEW_MODE: {
+					view_mode++;
+					if (view_mode == VIEW_DIFF && !has_diff) view_mode++;
+					if (view_mode == VIEW_QUERY && !has_query) view_mode++;
+					if (view_mode >= VIEW_INVALID) view_mode = 0;
+				} break;
+			}
+		}
+
+		// Typing goes into the search or query box while it's open
+		if (is_search_typing || is_query_typing) {
+			char *text = is_search_typing ? search_text : query_text;
+			int *len = is_search_typing ? &search_len : &query_len;
+			int size = is_search_typing ? (int) sizeof(search_text) : (int) sizeof(query_text);
+			int c = GetCharPressed();
+			while (c > 0) {
+				if (c >= 0x20 && c < 0x7F && *len < size - 1) {
+					text[(*len)++] = c;
+					text[*len] = '\0';
+				}
+				c = GetCharPressed();
+			}
+		}
+
+		// Stops the analysis where it is; what's been found so far stays
+		if (progress.stage == SESSTAGE_ANALYSIS && (
+				IsKeyPressed(KEY_CANCEL_LOAD)
+				|| (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && CheckCollisionPointRec(GetMousePosition(), btnrect_cancel))
+			)
+		) SES_Cancel(&session);
+
+		if (sector_changed) {
+			err = ANA_GetInfo(*analysis, curr_pos, &curr_sector);
+			if (err != 0) {
+				printf("Failed to get info for current sector (% 3i/% 3i): Err-code %i\n", curr_pos.track, curr_pos.sector, err);
+				return EXIT_FAILURE;
+			} else {
+				curr_checksum = DSK_Checksum(curr_sector.data);
+			}
+		}
+
+		////	Drawing
+
+		BeginDrawing();
+
+		// Clear Background
+		ClearBackground(RAYWHITE);
+
+		int hov_dir_index = -1;
+		ANA_SectorInfo hov_info;
+		err = ANA_GetInfo(*analysis, hov, &hov_info);
+		if (err == 0) hov_dir_index = hov_info.dir_index;
+
+		// Draw Disk-Sectors
+		for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+			int sc = DSK_Track_GetSectorCount(t);
+			for (int s=0; s<sc; s++) {
+				DSK_Position pos = { t, s };
+				DSK_DrawMode dm = DSK_DRAW_NORMAL;
+
+				ANA_SectorInfo info;
+				err = ANA_GetInfo(*analysis, pos, &info);
+				if (err != 0) {
+					DSK_Sector_Draw(*dir, pos, dm, MAGENTA);
+					continue;
+				}
+
+				if (DSK_PositionsEqual(pos, hov)) {
+					dm = DSK_DRAW_HIGHLIGHT;
+				}
+				if (DSK_PositionsEqual(pos, curr_pos)) {
+					dm = DSK_DRAW_SELECTED;
+				}
+
+				Color clr = GRAY;
+				switch (view_mode) {
+					case VIEW_INVALID: view_mode = VIEW_SECSTAT; // Fall-through
+					case VIEW_SECSTAT: clr = ANA_GetStatusColour(info.status); break;
+
+					case VIEW_BAM: {
+						if (!info.is_free) {
+							if (info.has_data && !info.is_blank) clr = GREEN;
+							else clr = RED;
+						} else {
+							if (!info.has_data || info.is_blank) clr = LIGHTGRAY;
+							else clr = BLACK;
+						}
+					} break;
+
+					case VIEW_TRANSFER: {
+						if (info.has_transfer_info && info.has_data) {
+							if (info.parse_err == 0x00) {
+								if (info.disk_err == 0x80 && info.checksum_match) clr = GREEN;
+								else clr = RED;
+							} else {
+								clr = RED;
+							}
+						} else {
+							clr = LIGHTGRAY;
+						}
+					} break;
+
+					case VIEW_SECTYPE: clr = DSK_Sector_GetTypeColour(info.type); break;
+					case VIEW_FILES: {
+						if (info.type == SECTYPE_DIR) {
+							clr = GOLD;
+						} else {
+							clr = ANA_GetFileColour(*dir, info,
+								(hov_info.type != SECTYPE_DIR && hov_dir_index == info.dir_index),
+								(curr_sector.type != SECTYPE_DIR && curr_sector.dir_index == info.dir_index)
+							);
+						}
+					} break;
+
+					case VIEW_DIFF: {
+						int index = DSK_PositionToIndex(pos);
+						if (!DIF_IsChanged(&diff, index)) clr = LIGHTGRAY;
+						else if (diff.bytes_changed[index] >= BLOCK_SIZE / 2) clr = RED;
+						else clr = ORANGE;
+					} break;
+
+					case VIEW_QUERY: clr = ANA_Bitset_Test(&query_matches, DSK_PositionToIndex(pos)) ? SKYBLUE : LIGHTGRAY; break;
+				}
+				if (has_search && SCH_IsHit(&search_result, DSK_PositionToIndex(pos))) clr = VIOLET;
+
+				DSK_Sector_Draw(*dir, pos, dm, clr);
+			}
+		}
+
+		// Draw Title
+		if (g_ignore_error_invalid_bam) {
+			draw_text("<INVALID BAM>",
+				10, 10, -1, RED
+			);
+		} else {
+			if (strnlen(name, sizeof(char) * 16) <= 0) {
+				draw_text("<NAME BLANK>", 10, 10, -1, GRAY);
+			} else {
+				draw_text(name, 10, 10, -1, CLR_ACCENT);
+			}
+		}
+		draw_text(TextFormat("\"%s\"", disk_filename),
+			10, 10 + 30, -1, BLACK
+		);
+		if (has_diff) {
+			draw_text(TextFormat("%i sectors changed in \"%s\"", diff.num_changed, diff_filename),
+				10, 10 + 60, -1, (diff.num_changed > 0) ? ORANGE : GRAY
+			);
+		}
+		if (progress.stage != SESSTAGE_DONE) draw_progress(progress, btnrect_cancel);
+
+		// Draw full disk usage & analysis stats
+		const float kb_total = (float) BLOCK_SIZE * MAX_ANALYSIS_ENTRIES / 1024.0f;
+		const float kb_in_use = (float) BLOCK_SIZE * analysis->count_in_use / 1024.0f;
+		const float pc_in_use = (float) analysis->count_in_use / MAX_ANALYSIS_ENTRIES;
+		draw_text(TextFormat("%4.2f KiB / %4.2f KiB (%2.0f%%) in use", kb_in_use, kb_total, pc_in_use * 100.0f),
+			info_x - 10, 10, 1, CLR_ACCENT
+		);
+		float pc_healthy = (float) analysis->count_healthy / analysis->count_in_use;
+		const float pc_bad = (float) analysis->count_bad / (float) analysis->count_in_use;
+		const int used_width = 200.0f * pc_in_use;
+		DrawRectangle(
+			info_x - 10 - 200, 10 + 30, 200, 20, BLACK
+		);
+		DrawRectangle(
+			info_x - 10 - 200, 10 + 30, used_width, 20, GRAY
+		);
+		DrawRectangle(
+			info_x - 10 - 200, 10 + 30, used_width * pc_healthy, 20, GREEN
+		);
+		DrawRectangle(
+			info_x - 10 - 200 + (200.0f * pc_in_use) * pc_healthy, 10 + 30,
+			used_width * pc_bad, 20, RED
+		);
+		draw_text(TextFormat("%2.0f%% healthy", floorf(pc_healthy * 100.0f)),
+			info_x - 10, 10 + 60, 1, LIME
+		);
+
+		// Draw Currently selected sector pos & hovered sector pos
+		if (DSK_IsPositionValid(hov)) {
+			draw_text(TextFormat("[% 3i/% 3i]", hov.track, hov.sector),
+				10, SCREEN_HEIGHT - 30 - 30, -1, BLACK
+			);
+		} else {
+			draw_text("[---/---]",
+				10, SCREEN_HEIGHT - 30 - 30, -1, LIGHTGRAY
+			);
+		}
+		draw_text(TextFormat("[% 3i/% 3i]", curr_pos.track, curr_pos.sector),
+			10, SCREEN_HEIGHT - 30, -1, CLR_ACCENT
+		);
+		if (view_mode == VIEW_DIFF) {
+			int changed = diff.bytes_changed[DSK_PositionToIndex(curr_pos)];
+			draw_text((changed > 0) ? TextFormat("%i bytes changed", changed) : "Unchanged",
+				10 + 120, SCREEN_HEIGHT - 30, -1, (changed > 0) ? ORANGE : GRAY
+			);
+		}
+
+		// Draw the search box
+		if (is_search_typing) {
+			draw_text(TextFormat("Search [F4]: %s_", search_text),
+				10, SCREEN_HEIGHT - 30 - 90, -1, BLACK
+			);
+		} else if (has_search) {
+			draw_text(TextFormat("Search [F4]: %s (%i hits; Enter for next)", search_text, search_result.num_hits),
+				10, SCREEN_HEIGHT - 30 - 90, -1, (search_result.num_hits > 0) ? VIOLET : GRAY
+			);
+		} else {
+			draw_text("Search [F4]",
+				10, SCREEN_HEIGHT - 30 - 90, -1, LIGHTGRAY
+			);
+		}
+
+		// Draw the query box
+		if (is_query_typing) {
+			draw_text(TextFormat("Query [F6]: %s_", query_text),
+				10, SCREEN_HEIGHT - 30 - 120, -1, BLACK
+			);
+		} else if (has_query) {
+			int num_matches = ANA_Bitset_Count(&query_matches);
+			draw_text(TextFormat("Query [F6]: %s (%i sectors; Tab for next)", query_text, num_matches),
+				10, SCREEN_HEIGHT - 30 - 120, -1, (num_matches > 0) ? SKYBLUE : GRAY
+			);
+		} else {
+			draw_text((query_len > 0) ? TextFormat("Query [F6]: %s (invalid)", query_text) : "Query [F6]",
+				10, SCREEN_HEIGHT - 30 - 120, -1, (query_len > 0) ? RED : LIGHTGRAY
+			);
+		}
+
+		// Draw current view mode name
+		draw_text("View Mode [F2]",
+			info_x - 10, SCREEN_HEIGHT - 30 - 30, 1, BLACK
+		);
+		char *mode_name = "";
+		switch (view_mode) {
+			case VIEW_INVALID: view_mode = VIEW_SECSTAT; // Fall-through
+			case VIEW_SECSTAT: mode_name = "Sector Status"; break;
+			case VIEW_BAM: mode_name = "Missing Sectors"; break;
+			case VIEW_TRANSFER: mode_name = "Transfer Errors"; break;
+			case VIEW_SECTYPE: mode_name = "Sector Type"; break;
+			case VIEW_FILES: mode_name = "File Blocks"; break;
+			case VIEW_DIFF: mode_name = "Changed Sectors"; break;
+			case VIEW_QUERY: mode_name = "Query Matches"; break;
+		}
+		draw_text(mode_name,
+			info_x - 10, SCREEN_HEIGHT - 30, 1, CLR_ACCENT
+		);
+
+
+
+		// Draw Sector Info
+
+		DrawLineEx(
+			(Vector2){ info_x, 10 },
+			(Vector2){ info_x, SCREEN_HEIGHT - 10 },
+			2.0f, BLACK
+		);
+
+		int line_num = 0;
+		draw_text("Current Sector Info:",
+				info_x + 10, 10 + (line_num++ * 20), -1, BLACK
+		);
+
+		DrawLineEx(
+			(Vector2){ info_x + 10, 18 + (line_num * 20) },
+			(Vector2){ SCREEN_WIDTH - 10, 18 + (line_num * 20) },
+			2.0f, BLACK
+		); line_num++;
+
+		draw_text("Sector Type:",
+				info_tab_x - 5, 10 + (line_num * 20), 1, BLACK
+		);
+		draw_text(DSK_Sector_GetTypeName(curr_sector.type),
+				info_tab_x + 5, 10 + (line_num++ * 20), -1, DSK_Sector_GetTypeColour(curr_sector.type)
+		);
+
+		draw_text("Checksum:",
+				info_tab_x - 5, 10 + (line_num * 20), 1, BLACK
+		);
+		if (curr_sector.has_transfer_info) {
+			draw_text(TextFormat("0x%04X - 0x%04X [%s]",
+					curr_checksum, curr_sector.checksum,
+					(curr_checksum == curr_sector.checksum) ? "MATCH":"BREAK"
+				), info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				(curr_checksum == curr_sector.checksum) ? GREEN:RED
+			);
+		} else if (curr_sector.has_data) {
+			draw_text(TextFormat("0x%04X", curr_checksum),
+				info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				GRAY
+			);
+		} else {
+			draw_text("-",
+				info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				GRAY
+			);
+		}
+		line_num++;
+
+		if (curr_sector.has_transfer_info) {
+			draw_text("Disk Error:",
+					info_tab_x - 5, 10 + (line_num * 20), 1, BLACK
+			);
+
+			uint8_t e = curr_sector.disk_err & ~0x80;
+			draw_text(TextFormat("0x%02X (%i)", e, e),
+				info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				ANA_GetDiskErrorColour(curr_sector.disk_err)
+			);
+			draw_text(ANA_GetDiskErrorName(curr_sector.disk_err),
+				info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				ANA_GetDiskErrorColour(curr_sector.disk_err)
+			);
+			line_num++;
+
+			e = curr_sector.parse_err;
+			draw_text("Parse Error:",
+					info_tab_x - 5, 10 + (line_num * 20), 1, BLACK
+			);
+			draw_text(TextFormat("0x%02X (%i)", e, e),
+				info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				ANA_GetParseErrorColour(e)
+			);
+			draw_text(ANA_GetParseErrorName(e),
+				info_tab_x + 5, 10 + (line_num++ * 20), -1,
+				ANA_GetParseErrorColour(e)
+			);
+			line_num++;
+		}
+
+		draw_text("Sector Status:",
+			info_tab_x - 5, 10 + (line_num * 20), 1, BLACK
+		);
+		draw_text(ANA_GetStatusName(curr_sector.status),
+			info_tab_x + 5, 10 + (line_num++ * 20), -1,
+			ANA_GetStatusColour(curr_sector.status)
+		);
+
+		// Draw specific sector info
+		line_num = 12;
+		DrawLineEx(
+			(Vector2){ info_x + 10, 19 + (line_num * 20) },
+			(Vector2){ SCREEN_WIDTH - 10, 19 + (line_num * 20) },
+			2.0f, BLACK
+		); line_num++;
+		switch (curr_sector.type) {
+
+			case SECTYPE_BAM: {
+				draw_text("Full Header Text:",
+					info_x + 10, 10 + (line_num++ * 20), -1,
+					BLACK
+				);
+				line_num++;
+
+				char desc[DSK_DESCRIPTION_SIZE];
+				DSK_GetDescription(*dir, desc, sizeof(desc));
+				int desclen = strlen(desc);
+				char *str = desc;
+				int prev = 0;
+				for (int i=0; i<desclen; i++) {
+					if (i < desclen-1 && i-prev < 40 && desc[i] != '\n') continue;
+					if (i >= desclen-1 || desc[i] == '\n') i++;
+					int len = i - prev;
+
+					draw_text(TextFormat("%.*s", len, str),
+						info_x + 20, 10 + (line_num++ * 20), -1,
+						GRAY
+					);
+
+					prev = i;
+					str = desc + i;
+				}
+			} break;
+
+			case SECTYPE_DIR: {
+				draw_text("Directory Files:",
+					info_x + 10, 10 + (line_num * 20), -1,
+					BLACK
+				);
+				draw_text("File Health:",
+					SCREEN_WIDTH - 10, 10 + (line_num * 20), 1,
+					GRAY
+				);
+				line_num++;
+
+				for (int i=0; i<8; i++) {
+					line_num++;
+					DSK_DirEntry entry = dir->entries[ curr_sector.dir_index + i ];
+					Color clr = GRAY;
+					Rectangle rect = {
+						info_x + 30, 10 + (line_num * 20),
+						50 + MeasureText(entry.filename, 20), 20,
+					};
+
+					bool is_valid = DSK_IsPositionValid(entry.head_pos) && !DSK_PositionsEqual(entry.head_pos, DSK_POSITION_BAM);
+					if (is_valid) {
+						if (CheckCollisionPointRec(GetMousePosition(), rect)) clr = CLR_ACCENT;
+					} else {
+						clr = LIGHTGRAY;
+					}
+
+					// Draw File name
+					DrawPoly((Vector2){ info_x + 40, 19 + (line_num * 20) },
+						4, 5, 0, clr
+					);
+					draw_text(entry.filename,
+						info_x + 60, 10 + (line_num * 20), -1,
+						clr
+					);
+					if (!is_valid) continue;
+
+					// Visualise how many sectors per file are present and healthy
+					Rectangle block_rect = {
+						SCREEN_WIDTH - 10 - 220, 10 + (line_num * 20) + 4,
+						220, 12,
+					};
+					float bwidth = (float) block_rect.width / entry.block_count;
+					if (bwidth < 1.0f) bwidth = 1.0f;
+
+					ANA_SectorInfo binfo = analysis->sectors[DSK_PositionToIndex(entry.head_pos)];
+					int good_blocks = 0;
+					for (int b=0; b<entry.block_count; b++) {
+						DrawRectangle(
+							block_rect.x + (b * bwidth), block_rect.y,
+							ceilf(bwidth), 12, ANA_GetStatusColour(binfo.status)
+						);
+
+						if (binfo.status == SECSTAT_GOOD
+							|| binfo.status == SECSTAT_PRESENT
+							|| binfo.status == SECSTAT_CONFIRMED
+						) good_blocks++;
+						if (binfo.next_block_index != -1) binfo = analysis->sectors[binfo.next_block_index];
+						else binfo.status = SECSTAT_MISSING;
+					}
+					draw_text(TextFormat("%i/%i", good_blocks, entry.block_count),
+						block_rect.x - 10, 10 + (line_num * 20), 1,
+						(good_blocks < entry.block_count) ? RED:LIME
+					);
+
+				}
+			} break;
+
+			case SECTYPE_PRG:
+			case SECTYPE_REL:
+			case SECTYPE_USR:
+			case SECTYPE_SEQ: {
+				draw_text("File Information:",
+					info_x + 10, 10 + (line_num * 20), -1,
+					BLACK
+				);
+				draw_text("File Health:",
+					SCREEN_WIDTH - 10, 10 + (line_num * 20), 1,
+					GRAY
+				);
+				line_num++;
+
+				// Draw visualisation of all file sectors
+				DSK_DirEntry entry = curr_sector.dir_entry;
+				ANA_SectorInfo binfo = analysis->sectors[DSK_PositionToIndex(entry.head_pos)];
+				int good_blocks = 0;
+
+				int grid_w = 4;
+				if (entry.block_count > 16) grid_w = 8;
+				if (entry.block_count > 64) grid_w = 12;
+				if (entry.block_count > 144) grid_w = 16;
+				const int grid_screen_w = 250;
+				const int grid_screen_y = 10 + (line_num + 1) * 20;
+				const int grid_screen_x = SCREEN_WIDTH - 20 - grid_screen_w;
+				int block_s = grid_screen_w / grid_w;
+				for (int b=0; b<entry.block_count; b++) {
+					int grid_x = b % grid_w;
+					int grid_y = b / grid_w;
+
+					if (b == curr_sector.file_index) {
+						DrawRectangle(
+							grid_screen_x + block_s * grid_x - 2, grid_screen_y + (grid_y * block_s) - 2 + 20,
+							block_s + 2, block_s + 2,
+							GOLD
+						);
+					}
+					DrawRectangle(
+						grid_screen_x + block_s * grid_x, grid_screen_y + (grid_y * block_s) + 20,
+						block_s - 2, block_s - 2,
+						ANA_GetStatusColour(binfo.status)
+					);
+
+					if (binfo.status == SECSTAT_GOOD
+						|| binfo.status == SECSTAT_PRESENT
+						|| binfo.status == SECSTAT_CONFIRMED
+					) good_blocks++;
+					if (binfo.next_block_index != -1) binfo = analysis->sectors[binfo.next_block_index];
+					else binfo.status = SECSTAT_MISSING;
+				}
+				draw_text(TextFormat("%i/%i good", good_blocks, entry.block_count),
+					SCREEN_WIDTH - 20 - 250, grid_screen_y - 10, -1,
+					(good_blocks < entry.block_count) ? RED : LIME
+				);
+
+				// Write file info
+				line_num++;
+				draw_text(curr_sector.dir_entry.filename,
+					info_x + 20, 10 + (line_num++ * 20), -1,
+					DSK_Sector_GetTypeColour(curr_sector.dir_entry.type)
+				);
+				draw_text(TextFormat("Block %i / %i", curr_sector.file_index+1, curr_sector.dir_entry.block_count),
+					info_x + 20, 10 + (line_num++ * 20), -1,
+					BLACK
+				);
+			} break;
+
+			default: break;
+		}
+
+		// Previous Button
+		Color clr = GRAY;
+		if (curr_sector.prev_block_index >= 0) {
+			if (CheckCollisionPointRec(GetMousePosition(), btnrect_previous)) clr = CLR_ACCENT;
+			DrawPoly((Vector2){
+				btnrect_previous.x + btnrect_previous.width/2,
+				btnrect_previous.y + btnrect_previous.height/2
+			}, 3, btnrect_previous.height/2 - 8, 60.0f, clr);
+			DrawRectangleLinesEx(btnrect_previous, 2, clr);
+		}
+
+		// Next Button
+		if (curr_sector.next_block_index >= 0) {
+			Color clr = GRAY;
+			if (CheckCollisionPointRec(GetMousePosition(), btnrect_next)) clr = CLR_ACCENT;
+			DrawPoly((Vector2){
+				btnrect_next.x + btnrect_next.width/2,
+				btnrect_next.y + btnrect_next.height/2
+			}, 3, btnrect_next.height/2 - 8, 0.0f, clr);
+			DrawRectangleLinesEx(btnrect_next, 2, clr);
+		}
+
+		// Export Button
+		if (export_directory != NULL && (
+				curr_sector.type == SECTYPE_PRG
+				|| curr_sector.type == SECTYPE_SEQ
+				|| curr_sector.type == SECTYPE_USR
+			)
+		) {
+			Color clr = GRAY;
+			if (CheckCollisionPointRec(GetMousePosition(), btnrect_export)) clr = CLR_ACCENT;
+			draw_text("Export", btnrect_export.x + btnrect_export.width / 2, btnrect_export.y + 10, 0, clr);
+			DrawRectangleLinesEx(btnrect_export, 2, clr);
+		}
+
+		// Display Sector contents
+		line_num = 30;
+		DrawLineEx(
+			(Vector2){ info_x + 10, 20 + (line_num * 20) },
+			(Vector2){ SCREEN_WIDTH - 10, 20 + (line_num * 20) },
+			2.0f, BLACK
+		); line_num++;
+
+		draw_text("Sector Contents:",
+			info_x + 10, 10 + (line_num * 20), -1,
+			BLACK
+		);
+		draw_text(hex_mode ? "HEX [F1]":"ASCII [F1]",
+			SCREEN_WIDTH - 10, 10 + (line_num++ * 20), 1,
+			CLR_ACCENT
+		);
+
+		DrawLineEx(
+			(Vector2){ info_x + 10, 18 + (line_num * 20) },
+			(Vector2){ SCREEN_WIDTH - 10, 18 + (line_num * 20) },
+			2.0f, BLACK
+		); line_num++;
+
+		DSK_DrawData(
+			info_x + 20, 10 + (line_num * 20),
+			curr_sector.data, BLOCK_SIZE,
+			hex_mode, true
+		);
+
+		DEBUG_DrawDevInfo();
+
+		EndDrawing();
+	}
+
+	// Terminate Raylib
+	CloseWindow();
+
+	// Anything still loading is abandoned; a cancelled import keeps its journal
+	SES_Cancel(&session);
+	status = SES_Finish(&session);
+	SES_Close(&session);
+	if (progress.stage == SESSTAGE_FAILED) return CLI_ReportLoadError(args, status, progress.err_detail);
+	return 0;
+}
+
+
+void draw_text(const char *text, int x, int y, int align, Color clr) {
+	int len = MeasureText(text, 20);
+
+	if (align != 0) align = align / abs(align);
+	switch (align) {
+		case -1: DrawText(text, x, y, 20, clr); return;
+		case  0: DrawText(text, x - (len/2), y, 20, clr); return;
+		case +1: DrawText(text, x - len, y, 20, clr); return;
+	}
+
+}
+
+bool is_key_held(int keycode) {
+	static int key_held = 0;
+	static int frames_held = 0;
+
+	if (IsKeyDown(keycode)) {
+
+		// Key changed
+		if (key_held != keycode) {
+			key_held = keycode;
+			frames_held = 0;
+			return true;
+		}
+
+		frames_held++;
+
+		if (frames_held > (FRAMERATE/2)) {
+			frames_held -= FRAMERATE/8;
+			return true;
+		} else {
+			return false;
+		}
+	} 
+
+	// Key Released
+	if (key_held == keycode) {
+		key_held = 0;
+		frames_held = 0;
+	}
+
+	return false;
+}
+
+void draw_progress(SES_Progress progress, Rectangle btnrect_cancel) {
+	if (progress.stage == SESSTAGE_CANCELLED) {
+		draw_text("Analysis cancelled; results are incomplete", 10, 10 + 60, -1, RED);
+		return;
+	}
+
+	const char *text = SES_GetStageName(progress.stage);
+	if (progress.stage == SESSTAGE_IMPORT) text = TextFormat("%s (%i blocks)", text, progress.blocks_imported);
+	if (progress.stage == SESSTAGE_ANALYSIS) text = ANA_GetPassName(progress.pass);
+	draw_text(text, 10, 10 + 60, -1, GRAY);
+
+	DrawRectangle(10, btnrect_cancel.y + 5, 200, 20, LIGHTGRAY);
+	DrawRectangle(10, btnrect_cancel.y + 5, 200.0f * progress.progress, 20, CLR_ACCENT);
+
+	Color clr = GRAY;
+	if (CheckCollisionPointRec(GetMousePosition(), btnrect_cancel)) clr = CLR_ACCENT;
+	draw_text("Cancel [F3]", btnrect_cancel.x + btnrect_cancel.width / 2, btnrect_cancel.y + 5, 0, clr);
+	DrawRectangleLinesEx(btnrect_cancel, 2, clr);
+}
+
+int view_heatmap(CLI_Arguments args) {
+	static HMP_Heatmap heatmap;
+	int status = CLI_BuildHeatmap(args, &heatmap);
+	if (status != EXIT_SUCCESS) return status;
+	if (heatmap.total.transfers == 0) {
+		printf("Error: None of the recon files have any transfers to show\n");
+		return EXIT_FAILURE;
+	}
+	if (!g_verbose_log) SetTraceLogLevel(LOG_WARNING);
+
+	InitWindow(
+		SCREEN_WIDTH, SCREEN_HEIGHT,
+		"Disekt - Heatmap"
+	);
+	SetTargetFPS(FRAMERATE);
+
+	const int info_x = DISK_CENTRE_X * 2;
+	const char *zone_names[HMP_NUM_ZONES] = { "Tracks 1-17", "Tracks 18-24", "Tracks 25-30", "Tracks 31-35" };
+
+	// Sectors are coloured by how often a transfer of them had the shown kind of failure
+	enum {
+		HEAT_FAILURES,
+		HEAT_DISK_ERRORS,
+		HEAT_PARSE_ERRORS,
+		HEAT_CHECKSUMS,
+		HEAT_INVALID,
+	} heat_mode = HEAT_FAILURES;
+	const char *heat_names[HEAT_INVALID] = { "Failures", "Disk Errors", "Parse Errors", "Checksum Mismatches" };
+
+	DSK_Directory dir;
+	memset(&dir, 0, sizeof(DSK_Directory));
+	DSK_Position curr_pos = DSK_POSITION_BAM;
+	while (!WindowShouldClose()) {
+
+		// Handle inputs
+		DSK_Position hov = DSK_GetHoveredSector();
+		if (IsMouseButtonPressed(MOUSE_LEFT_BUTTON) && DSK_IsPositionValid(hov)) curr_pos = hov;
+
+		if (is_key_held(KEY_ARROW_UP) && curr_pos.track < 35) curr_pos.track++;
+		if (is_key_held(KEY_ARROW_DOWN) && curr_pos.track > 1) curr_pos.track--;
+		if (is_key_held(KEY_ARROW_LEFT)) curr_pos.sector--;
+		if (is_key_held(KEY_ARROW_RIGHT)) curr_pos.sector++;
+
+		int secs = DSK_Track_GetSectorCount(curr_pos.track);
+		if (curr_pos.sector > 0x80) curr_pos.sector = secs - 1;
+		if (curr_pos.sector >= secs) curr_pos.sector = 0;
+
+		if (IsKeyPressed(KEY_TOGGLE_VIEW_MODE)) heat_mode = (heat_mode + 1) % HEAT_INVALID;
+
+		// The worst sector is the hottest, so a few bad ones don't wash out the rest
+		float rates[NYBLOG_SECTOR_COUNT];
+		float max_rate = 0.0f;
+		for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) {
+			const HMP_Cell *cell = &heatmap.sectors[i];
+			uint32_t count = cell->failures;
+			switch (heat_mode) {
+				case HEAT_INVALID: heat_mode = HEAT_FAILURES; // Fall-through
+				case HEAT_FAILURES: break;
+				case HEAT_DISK_ERRORS: {
+					count = 0;
+					for (int e=0; e<HMP_NUM_DISK_ERRORS; e++) count += cell->disk_errors[e];
+				} break;
+				case HEAT_PARSE_ERRORS: count = cell->parse_errors; break;
+				case HEAT_CHECKSUMS: count = cell->checksum_mismatches; break;
+			}
+			rates[i] = (cell->transfers > 0) ? (float) count / cell->transfers : 0.0f;
+			if (rates[i] > max_rate) max_rate = rates[i];
+		}
+
+		BeginDrawing();
+		ClearBackground(RAYWHITE);
+
+		// Draw Disk-Sectors
+		for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+			int sc = DSK_Track_GetSectorCount(t);
+			for (int s=0; s<sc; s++) {
+				DSK_Position pos = { t, s };
+				int index = DSK_PositionToIndex(pos);
+
+				DSK_DrawMode dm = DSK_DRAW_NORMAL;
+				if (DSK_PositionsEqual(pos, hov)) dm = DSK_DRAW_HIGHLIGHT;
+				if (DSK_PositionsEqual(pos, curr_pos)) dm = DSK_DRAW_SELECTED;
+
+				Color clr = LIGHTGRAY;
+				if (heatmap.sectors[index].transfers > 0) clr = HMP_GetHeatColour((max_rate > 0.0f) ? rates[index] / max_rate : 0.0f);
+				DSK_Sector_Draw(dir, pos, dm, clr);
+			}
+		}
+
+		// Draw Title
+		draw_text(TextFormat("Heatmap of %u recon files", heatmap.num_recons), 10, 10, -1, CLR_ACCENT);
+		draw_text(TextFormat("%u transfers; %u failed to read", heatmap.total.transfers, heatmap.num_failed),
+			10, 10 + 30, -1, BLACK
+		);
+		draw_text(TextFormat("%s [F2]; up to %.1f%%", heat_names[heat_mode], max_rate * 100.0f),
+			10, 10 + 60, -1, GRAY
+		);
+
+		// Draw Currently selected sector pos & hovered sector pos
+		if (DSK_IsPositionValid(hov)) {
+			draw_text(TextFormat("[% 3i/% 3i]", hov.track, hov.sector),
+				10, SCREEN_HEIGHT - 30 - 30, -1, BLACK
+			);
+		} else {
+			draw_text("[---/---]",
+				10, SCREEN_HEIGHT - 30 - 30, -1, LIGHTGRAY
+			);
+		}
+		draw_text(TextFormat("[% 3i/% 3i]", curr_pos.track, curr_pos.sector),
+			10, SCREEN_HEIGHT - 30, -1, CLR_ACCENT
+		);
+
+		// Draw the counts of the selected sector
+		const HMP_Cell *cell = &heatmap.sectors[DSK_PositionToIndex(curr_pos)];
+		int line_num = 0;
+		draw_text(TextFormat("Track %i, Sector %i (%s)", curr_pos.track, curr_pos.sector, zone_names[HMP_GetZone(curr_pos.track)]),
+			info_x + 10, 10 + (line_num++ * 20), -1, CLR_ACCENT
+		);
+		line_num++;
+		draw_text(TextFormat("Transfers: %u (%u attempts)", cell->transfers, cell->attempts),
+			info_x + 10, 10 + (line_num++ * 20), -1, BLACK
+		);
+		draw_text(TextFormat("Failures: %u (%.1f%%)", cell->failures, HMP_GetFailureRate(cell) * 100.0f),
+			info_x + 10, 10 + (line_num++ * 20), -1, (cell->failures > 0) ? RED : GREEN
+		);
+		draw_text(TextFormat("Parse errors: %u", cell->parse_errors),
+			info_x + 10, 10 + (line_num++ * 20), -1, (cell->parse_errors > 0) ? RED : GREEN
+		);
+		draw_text(TextFormat("Checksum mismatches: %u", cell->checksum_mismatches),
+			info_x + 10, 10 + (line_num++ * 20), -1, (cell->checksum_mismatches > 0) ? RED : GREEN
+		);
+		if (cell->unchecked > 0) {
+			draw_text(TextFormat("Unchecked (no image): %u", cell->unchecked),
+				info_x + 10, 10 + (line_num++ * 20), -1, GRAY
+			);
+		}
+		line_num++;
+		draw_text("Disk errors:", info_x + 10, 10 + (line_num++ * 20), -1, BLACK);
+		bool has_disk_errors = false;
+		for (int e=0; e<HMP_NUM_DISK_ERRORS; e++) {
+			if (cell->disk_errors[e] == 0) continue;
+			has_disk_errors = true;
+
+			if (e == HMP_DISK_ERROR_OTHER) {
+				draw_text(TextFormat("  Other: %u", cell->disk_errors[e]), info_x + 10, 10 + (line_num++ * 20), -1, MAGENTA);
+				continue;
+			}
+			draw_text(TextFormat("  %i: %u", e + 20, cell->disk_errors[e]), info_x + 10, 10 + (line_num * 20), -1, RED);
+			draw_text(ANA_GetDiskErrorName(e + 20), info_x + 10 + 120, 10 + (line_num++ * 20), -1, GRAY);
+		}
+		if (!has_disk_errors) draw_text("  None", info_x + 10, 10 + (line_num++ * 20), -1, GREEN);
+
+		// Draw the counts of every zone
+		line_num++;
+		draw_text("Zone", info_x + 10, 10 + (line_num * 20), -1, CLR_ACCENT);
+		draw_text("Transfers", info_x + 10 + 330, 10 + (line_num * 20), 1, CLR_ACCENT);
+		draw_text("Failed", info_x + 10 + 460, 10 + (line_num++ * 20), 1, CLR_ACCENT);
+		for (int z=0; z<=HMP_NUM_ZONES; z++) {
+			const HMP_Cell *zone = (z < HMP_NUM_ZONES) ? &heatmap.zones[z] : &heatmap.total;
+			Color clr = (z < HMP_NUM_ZONES) ? BLACK : CLR_ACCENT;
+			draw_text((z < HMP_NUM_ZONES) ? zone_names[z] : "Total", info_x + 10, 10 + (line_num * 20), -1, clr);
+			draw_text(TextFormat("%u", zone->transfers), info_x + 10 + 330, 10 + (line_num * 20), 1, clr);
+			draw_text(TextFormat("%.1f%%", HMP_GetFailureRate(zone) * 100.0f), info_x + 10 + 460, 10 + (line_num++ * 20), 1, clr);
+		}
+
+		DEBUG_DrawDevInfo();
+
+		EndDrawing();
+	}
+
+	// Terminate Raylib
+	CloseWindow();
+	return EXIT_SUCCESS;
+}
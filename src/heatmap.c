@@ -0,0 +1,282 @@
+#include <pthread.h>
+#include <unistd.h>
+#include "../include/heatmap.h"
+#include "../include/arena.h"
+#include "../include/merge.h"
+#include "../include/trace.h"
+
+//	A worker's recon & the image it belongs to, reused for every file it reads
+#define __HEATMAP_ARENA_SIZE (ARN_SIZE(sizeof(NYB_Recon)) + ARN_SIZE(NYBLOG_IMAGE_SIZE))
+
+typedef struct {
+	char **filenames;
+	int num_jobs;
+	int next_job;
+	pthread_mutex_t lock;
+} __heatmap_queue;
+
+//	One worker's share of HMP_AddRecons
+typedef struct {
+	__heatmap_queue *queue;
+	HMP_Heatmap heatmap;
+} __heatmap_worker;
+
+
+void HMP_Init(HMP_Heatmap *heatmap) {
+	if (heatmap == NULL) return;
+	memset(heatmap, 0, sizeof(HMP_Heatmap));
+}
+
+int HMP_GetZone(int track) {
+	if (track < MIN_TRACKS || track > MAX_TRACKS) return -1;
+	if (track <= 17) return 0;
+	if (track <= 24) return 1;
+	if (track <= 30) return 2;
+	return 3;
+}
+
+int HMP_GetDiskErrorBucket(uint8_t err_code) {
+	if (err_code == 0) return -1;
+	if (err_code >= 20 && err_code <= 29) return err_code - 20;
+	return HMP_DISK_ERROR_OTHER;
+}
+
+void __heatmap_add_cell(HMP_Cell *cell, const HMP_Cell *other) {
+	cell->transfers += other->transfers;
+	cell->attempts += other->attempts;
+	cell->failures += other->failures;
+	for (int e=0; e<HMP_NUM_DISK_ERRORS; e++) cell->disk_errors[e] += other->disk_errors[e];
+	cell->parse_errors += other->parse_errors;
+	cell->checksum_mismatches += other->checksum_mismatches;
+	cell->unchecked += other->unchecked;
+}
+
+int HMP_AddRecon(HMP_Heatmap *heatmap, const NYB_Recon *recon, const uint8_t *image) {
+	if (heatmap == NULL || recon == NULL) return 1;
+
+	bool is_missing_image = false;
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		HMP_Cell *zone = &heatmap->zones[HMP_GetZone(t)];
+		int first = DSK_PositionToIndex((DSK_Position){ t, 0 });
+		int sc = DSK_Track_GetSectorCount(t);
+		for (int i=first; i<first+sc; i++) {
+			const NYB_DataBlock *block = &recon->blocks[i];
+			if (block->block_status == 0x00) continue;
+
+			HMP_Cell counts = {
+				.transfers = 1,
+				.attempts = recon->attempts[i],
+				.parse_errors = (block->parse_error != 0x00),
+			};
+			int bucket = HMP_GetDiskErrorBucket(block->err_code);
+			if (bucket >= 0) counts.disk_errors[bucket] = 1;
+
+			// Sparse recons leave the data of a good transfer in the image
+			const uint8_t *data = block->data;
+			if (block->block_status & NYBLOG_STATUS_IN_IMAGE) data = (image != NULL) ? image + (i * BLOCK_SIZE) : NULL;
+			if (data != NULL) counts.checksum_mismatches = (block->checksum != DSK_Checksum((void *) data));
+			else counts.unchecked = 1;
+			is_missing_image |= (data == NULL);
+
+			counts.failures = (bucket >= 0 || counts.parse_errors || counts.checksum_mismatches);
+			__heatmap_add_cell(&heatmap->sectors[i], &counts);
+			__heatmap_add_cell(zone, &counts);
+			__heatmap_add_cell(&heatmap->total, &counts);
+		}
+	}
+
+	heatmap->num_recons++;
+	if (is_missing_image) heatmap->num_without_image++;
+
+	return 0;
+}
+
+int HMP_Merge(HMP_Heatmap *heatmap, const HMP_Heatmap *other) {
+	if (heatmap == NULL || other == NULL) return 1;
+
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) __heatmap_add_cell(&heatmap->sectors[i], &other->sectors[i]);
+	for (int z=0; z<HMP_NUM_ZONES; z++) __heatmap_add_cell(&heatmap->zones[z], &other->zones[z]);
+	__heatmap_add_cell(&heatmap->total, &other->total);
+	heatmap->num_recons += other->num_recons;
+	heatmap->num_failed += other->num_failed;
+	heatmap->num_without_image += other->num_without_image;
+
+	return 0;
+}
+
+//	Reads a recon file, & its image if it's sparse, into the worker's arena
+//
+//	Returns 0 on success or 2 if the recon can't be read
+int __heatmap_add_file(const char *filename, ARN_Arena *arena, HMP_Heatmap *heatmap) {
+	ARN_Reset(arena);
+	NYB_Recon *recon = ARN_Alloc(arena, sizeof(NYB_Recon));
+	uint8_t *image = ARN_Alloc(arena, NYBLOG_IMAGE_SIZE);
+
+	FILE *f_meta = fopen(filename, "rb");
+	if (f_meta == NULL) return 2;
+	int err = NYB_Recon_Load(recon, f_meta, NULL);
+	if (err != 0) {
+		fclose(f_meta);
+		return 2;
+	}
+
+	// The image is only needed for blocks the recon doesn't hold itself
+	bool is_sparse = false;
+	for (int i=0; i<NYBLOG_SECTOR_COUNT && !is_sparse; i++) is_sparse = (recon->blocks[i].block_status & NYBLOG_STATUS_IN_IMAGE) != 0;
+
+	// An image the recon wasn't saved with counts as missing
+	bool has_image = false;
+	FILE *f_disk = is_sparse ? MRG_OpenCompanionImage(filename) : NULL;
+	if (f_disk != NULL) {
+		size_t size = fread(image, sizeof(uint8_t), NYBLOG_IMAGE_SIZE, f_disk);
+		has_image = !ferror(f_disk);
+		if (size < NYBLOG_IMAGE_SIZE) memset(image + size, 0, NYBLOG_IMAGE_SIZE - size);
+		fclose(f_disk);
+	}
+	if (has_image) has_image = (NYB_Recon_CheckImage(f_meta, image) == 0);
+	fclose(f_meta);
+
+	return HMP_AddRecon(heatmap, recon, has_image ? image : NULL);
+}
+
+void *__heatmap_add_files(void *arg) {
+	__heatmap_worker *worker = arg;
+	__heatmap_queue *queue = worker->queue;
+
+	ARN_Arena arena;
+	if (ARN_Init(&arena, __HEATMAP_ARENA_SIZE) != 0) return NULL;
+
+	while (true) {
+		pthread_mutex_lock(&queue->lock);
+		int i = queue->next_job++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->num_jobs) break;
+
+		if (__heatmap_add_file(queue->filenames[i], &arena, &worker->heatmap) != 0) worker->heatmap.num_failed++;
+	}
+
+	ARN_Free(&arena);
+	return NULL;
+}
+
+int HMP_AddRecons(HMP_Heatmap *heatmap, char **filenames, int num_recons, int num_threads) {
+	TRC_SCOPE("HMP_AddRecons");
+	if (heatmap == NULL || filenames == NULL) return 1;
+
+	if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads > HMP_MAX_THREADS) num_threads = HMP_MAX_THREADS;
+	if (num_threads > num_recons) num_threads = num_recons;
+	if (num_threads < 1) num_threads = 1;
+
+	// Each worker counts into a heatmap of its own, so they never wait on each other
+	__heatmap_worker *workers = calloc(num_threads, sizeof(__heatmap_worker));
+	if (workers == NULL) return 1;
+
+	__heatmap_queue queue = {
+		.filenames = filenames,
+		.num_jobs = num_recons,
+	};
+	pthread_mutex_init(&queue.lock, NULL);
+	for (int i=0; i<num_threads; i++) workers[i].queue = &queue;
+
+	// Whatever threads can't be started, the calling one makes up for
+	pthread_t threads[HMP_MAX_THREADS];
+	int num_started = 0;
+	while (num_started < num_threads - 1) {
+		if (pthread_create(&threads[num_started], NULL, __heatmap_add_files, &workers[num_started + 1]) != 0) break;
+		num_started++;
+	}
+	__heatmap_add_files(&workers[0]);
+	for (int i=0; i<num_started; i++) pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+
+	uint32_t num_failed = heatmap->num_failed;
+	for (int i=0; i<num_threads; i++) HMP_Merge(heatmap, &workers[i].heatmap);
+	free(workers);
+
+	return (heatmap->num_failed > num_failed) ? 2 : 0;
+}
+
+float HMP_GetFailureRate(const HMP_Cell *cell) {
+	if (cell == NULL || cell->transfers == 0) return 0.0f;
+	return (float) cell->failures / cell->transfers;
+}
+
+uint32_t __heatmap_count_disk_errors(const HMP_Cell *cell) {
+	uint32_t count = 0;
+	for (int e=0; e<HMP_NUM_DISK_ERRORS; e++) count += cell->disk_errors[e];
+	return count;
+}
+
+void __heatmap_write_cell(FILE *f_report, const char *label, const HMP_Cell *cell) {
+	fprintf(f_report, "  %-12s %10u %10u %9u % 6.1f%% %12u %12u %10u\n",
+		label, cell->transfers, cell->attempts, cell->failures, HMP_GetFailureRate(cell) * 100.0f,
+		__heatmap_count_disk_errors(cell), cell->parse_errors, cell->checksum_mismatches
+	);
+}
+
+//	Orders sectors by how often they failed, then by their failure rate
+int __heatmap_compare_sectors(const void *a, const void *b) {
+	const HMP_Cell *ca = *(const HMP_Cell * const *) a;
+	const HMP_Cell *cb = *(const HMP_Cell * const *) b;
+	if (ca->failures != cb->failures) return (ca->failures < cb->failures) ? 1 : -1;
+
+	float ra = HMP_GetFailureRate(ca);
+	float rb = HMP_GetFailureRate(cb);
+	if (ra != rb) return (ra < rb) ? 1 : -1;
+	return (ca < cb) ? -1 : (ca > cb);
+}
+
+void HMP_WriteReport(FILE *f_report, const HMP_Heatmap *heatmap, int max_sectors) {
+	if (f_report == NULL || heatmap == NULL) return;
+
+	const char *zone_names[HMP_NUM_ZONES] = { "Tracks 1-17", "Tracks 18-24", "Tracks 25-30", "Tracks 31-35" };
+	fprintf(f_report, "  %-12s %10s %10s %9s %7s %12s %12s %10s\n",
+		"Zone", "Transfers", "Attempts", "Failures", "Rate", "Disk errors", "Parse errors", "Checksums"
+	);
+	for (int z=0; z<HMP_NUM_ZONES; z++) __heatmap_write_cell(f_report, zone_names[z], &heatmap->zones[z]);
+	__heatmap_write_cell(f_report, "Total", &heatmap->total);
+
+	if (max_sectors <= 0 || heatmap->total.failures == 0) return;
+	if (max_sectors > NYBLOG_SECTOR_COUNT) max_sectors = NYBLOG_SECTOR_COUNT;
+
+	const HMP_Cell *order[NYBLOG_SECTOR_COUNT];
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) order[i] = &heatmap->sectors[i];
+	qsort(order, NYBLOG_SECTOR_COUNT, sizeof(HMP_Cell *), __heatmap_compare_sectors);
+
+	fprintf(f_report, "\n  Track Sector  Transfers  Failures    Rate  Most common disk error\n");
+	for (int n=0; n<max_sectors; n++) {
+		const HMP_Cell *cell = order[n];
+		if (cell->failures == 0) break;
+
+		DSK_Position pos = DSK_IndexToPosition(cell - heatmap->sectors);
+
+		int worst = 0;
+		for (int e=1; e<HMP_NUM_DISK_ERRORS; e++) if (cell->disk_errors[e] > cell->disk_errors[worst]) worst = e;
+
+		fprintf(f_report, "  % 5i % 6i %10u %9u % 6.1f%%  ", pos.track, pos.sector, cell->transfers, cell->failures, HMP_GetFailureRate(cell) * 100.0f);
+		if (cell->disk_errors[worst] == 0) fprintf(f_report, "-\n");
+		else if (worst == HMP_DISK_ERROR_OTHER) fprintf(f_report, "Other (%u)\n", cell->disk_errors[worst]);
+		else fprintf(f_report, "%i (%u)\n", worst + 20, cell->disk_errors[worst]);
+	}
+}
+
+int HMP_WriteCSV(FILE *f_csv, const HMP_Heatmap *heatmap) {
+	if (f_csv == NULL || heatmap == NULL) return 1;
+
+	fprintf(f_csv, "track,sector,zone,transfers,attempts,failures");
+	for (int e=0; e<HMP_DISK_ERROR_OTHER; e++) fprintf(f_csv, ",error_%i", e + 20);
+	fprintf(f_csv, ",error_other,parse_errors,checksum_mismatches,unchecked\n");
+
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int sc = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<sc; s++) {
+			const HMP_Cell *cell = &heatmap->sectors[DSK_PositionToIndex((DSK_Position){ t, s })];
+			fprintf(f_csv, "%i,%i,%i,%u,%u,%u", t, s, HMP_GetZone(t), cell->transfers, cell->attempts, cell->failures);
+			for (int e=0; e<HMP_NUM_DISK_ERRORS; e++) fprintf(f_csv, ",%u", cell->disk_errors[e]);
+			fprintf(f_csv, ",%u,%u,%u\n", cell->parse_errors, cell->checksum_mismatches, cell->unchecked);
+		}
+	}
+
+	return ferror(f_csv) ? 2 : 0;
+}
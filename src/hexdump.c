@@ -0,0 +1,165 @@
+#include "../include/hexdump.h"
+#include "../include/nybbin.h"
+#include "../include/trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//	Which part of a block the next byte belongs to
+typedef enum {
+	HEXSTATE_SYNC_HI,
+	HEXSTATE_SYNC_LO,
+	HEXSTATE_TRACK,
+	HEXSTATE_SECTOR,
+	HEXSTATE_DATA,
+	HEXSTATE_CHECKSUM_LO,
+	HEXSTATE_CHECKSUM_HI,
+	HEXSTATE_ERROR,
+	HEXSTATE_PADDING,
+} __hex_state;
+
+typedef struct {
+	__hex_state state;
+	int data_pos;
+	NYB_DataBlock block;
+
+	NYB_BlockCallback callback;
+	NYB_InfoCallback info_callback;
+	void *user_data;
+	int count;
+	bool stopped;
+} __hex_parser;
+
+
+static inline int __hex_value(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+void __emit_block(__hex_parser *parser) {
+	parser->count++;
+	if (parser->callback(&parser->block, parser->user_data) != 0) parser->stopped = true;
+}
+
+//	Feeds a single byte of the dump into the current block
+void __feed_byte(__hex_parser *parser, uint8_t b) {
+	NYB_DataBlock *block = &parser->block;
+
+	switch (parser->state) {
+		case HEXSTATE_SYNC_HI: {
+			if (b == HEX_SYNC_HI) parser->state = HEXSTATE_SYNC_LO;
+		}; break;
+
+		case HEXSTATE_SYNC_LO: {
+			if (b == HEX_SYNC_LO) parser->state = HEXSTATE_TRACK;
+			else if (b != HEX_SYNC_HI) parser->state = HEXSTATE_SYNC_HI;
+		}; break;
+
+		case HEXSTATE_TRACK: {
+			memset(block, 0, sizeof(NYB_DataBlock));
+			block->track_num = b;
+			parser->state = HEXSTATE_SECTOR;
+		}; break;
+
+		case HEXSTATE_SECTOR: {
+			block->sector_index = b;
+			parser->data_pos = 0;
+			parser->state = HEXSTATE_DATA;
+		}; break;
+
+		case HEXSTATE_DATA: {
+			block->data[parser->data_pos++] = b;
+			if (parser->data_pos >= BLOCK_SIZE) parser->state = HEXSTATE_CHECKSUM_LO;
+		}; break;
+
+		case HEXSTATE_CHECKSUM_LO: {
+			block->checksum = b;
+			parser->state = HEXSTATE_CHECKSUM_HI;
+		}; break;
+
+		case HEXSTATE_CHECKSUM_HI: {
+			block->checksum |= b << 8;
+			parser->state = HEXSTATE_ERROR;
+		}; break;
+
+		case HEXSTATE_ERROR: {
+			block->err_code = b;
+			if (b != 0x00 && parser->info_callback != NULL) {
+				char message[NYBBIN_MAX_MESSAGE];
+				snprintf(message, sizeof(message), "Block [% 3i/% 3i] end doesn't match expected format (0x%02X)", block->track_num, block->sector_index, b);
+				parser->info_callback(message, parser->user_data);
+			}
+			__emit_block(parser);
+			parser->state = HEXSTATE_PADDING;
+		}; break;
+
+		// The byte after the error code isn't used
+		case HEXSTATE_PADDING: {
+			parser->state = HEXSTATE_SYNC_HI;
+		}; break;
+	}
+}
+
+int HEX_ParseHexDump(const char *filename, NYB_BlockCallback callback, NYB_InfoCallback info_callback, void *user_data) {
+	TRC_SCOPE_DETAIL("HEX_ParseHexDump", filename);
+	if (filename == NULL || callback == NULL) return -1;
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) return -1;
+
+	char *buf = malloc(HEX_READ_BUFFER_SIZE);
+	if (buf == NULL) {
+		close(fd);
+		return -1;
+	}
+
+	__hex_parser parser = {
+		.state = HEXSTATE_SYNC_HI,
+		.callback = callback,
+		.info_callback = info_callback,
+		.user_data = user_data,
+	};
+
+	// A byte is the last two hex digits of a run of them, followed by whitespace;
+	// the digits seen so far carry over from one buffer to the next
+	int digits = 0;
+	int hi = 0, lo = 0;
+	bool failed = false;
+	while (!parser.stopped) {
+		ssize_t n = read(fd, buf, HEX_READ_BUFFER_SIZE);
+		if (n < 0 && errno == EINTR) continue;
+		if (n < 0) failed = true;
+		if (n <= 0) break;
+
+		for (ssize_t i=0; i<n && !parser.stopped; i++) {
+			char c = buf[i];
+			int v = __hex_value(c);
+			if (v >= 0) {
+				hi = lo;
+				lo = v;
+				digits++;
+				continue;
+			}
+
+			if (digits >= 2 && (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f')) {
+				__feed_byte(&parser, (hi << 4) | lo);
+			}
+			digits = 0;
+		}
+	}
+
+	// The dump ended part of the way through a block
+	bool in_block = parser.state > HEXSTATE_TRACK && parser.state < HEXSTATE_PADDING;
+	if (!failed && !parser.stopped && in_block) {
+		parser.block.parse_error = NYBLOG_ERR_TRUNCATED;
+		__emit_block(&parser);
+	}
+
+	free(buf);
+	close(fd);
+
+	if (failed) return -1;
+	return parser.count;
+}
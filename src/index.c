@@ -0,0 +1,658 @@
+#include "../include/index.h"
+#include "../include/diff.h"
+#include "../include/trace.h"
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define __STRUCT_SIZES ((uint32_t) (sizeof(IDX_Disk) | sizeof(IDX_File) << 10 | sizeof(IDX_Token) << 20))
+
+//	Names of the file types, by DSK_SectorType
+static const char *__INDEX_TYPE_NAMES[] = { "DEL", "SEQ", "PRG", "USR", "REL" };
+
+//	A word & a file it's in, before they're grouped into tokens
+typedef struct {
+	char token[IDX_TOKEN_SIZE];
+	uint32_t file;
+} __index_posting;
+
+//	An index being built up in memory
+typedef struct {
+	char **paths;			// Images found in the directory, relative to it
+	int num_paths;
+	int max_paths;
+	IDX_Disk *disks;
+	int num_disks;
+	int max_disks;
+	IDX_File *files;
+	int num_files;
+	int max_files;
+	__index_posting *postings;
+	int num_postings;
+	int max_postings;
+	char *strings;
+	size_t strings_size;
+	size_t max_strings;
+} __index_builder;
+
+
+//	Makes room for one more element at the end of a growing array
+bool __index_grow(void **array, int *max, int count, size_t elem_size) {
+	if (count < *max) return true;
+
+	int max_new = (*max > 0) ? *max * 2 : 256;
+	void *grown = realloc(*array, max_new * elem_size);
+	if (grown == NULL) return false;
+
+	*array = grown;
+	*max = max_new;
+	return true;
+}
+
+//	Adds a string to the string table; returns its offset or -1 if there's no memory left
+long __index_add_string(__index_builder *builder, const char *str) {
+	size_t len = strlen(str) + 1;
+	if (builder->strings_size + len > builder->max_strings) {
+		size_t max_new = (builder->max_strings > 0) ? builder->max_strings * 2 : 0x10000;
+		while (max_new < builder->strings_size + len) max_new *= 2;
+		char *grown = realloc(builder->strings, max_new);
+		if (grown == NULL) return -1;
+		builder->strings = grown;
+		builder->max_strings = max_new;
+	}
+
+	long offset = builder->strings_size;
+	memcpy(builder->strings + offset, str, len);
+	builder->strings_size += len;
+	return offset;
+}
+
+//	Splits text into lower case words of letters & digits; PETSCII graphics split words too.
+//	Calls `fn` for each one and returns how many there were, or -1 if `fn` failed.
+int __index_tokenise(const char *text, int (*fn)(const char *token, void *user_data), void *user_data) {
+	char token[IDX_TOKEN_SIZE];
+	int len = 0;
+	int count = 0;
+	for (int i=0; ; i++) {
+		unsigned char c = text[i];
+		if (c != '\0' && c < 0x80 && isalnum(c)) {
+			if (len < IDX_TOKEN_SIZE - 1) token[len++] = tolower(c);
+			continue;
+		}
+
+		if (len > 0) {
+			token[len] = '\0';
+			if (fn(token, user_data) != 0) return -1;
+			count++;
+			len = 0;
+		}
+		if (c == '\0') break;
+	}
+	return count;
+}
+
+typedef struct {
+	__index_builder *builder;
+	uint32_t file;
+} __index_token_target;
+
+int __index_add_posting(const char *token, void *user_data) {
+	__index_token_target *target = user_data;
+	__index_builder *builder = target->builder;
+	if (!__index_grow((void **) &builder->postings, &builder->max_postings, builder->num_postings, sizeof(__index_posting))) return 1;
+
+	__index_posting *posting = &builder->postings[builder->num_postings++];
+	memset(posting->token, 0, IDX_TOKEN_SIZE);
+	strncpy(posting->token, token, IDX_TOKEN_SIZE - 1);
+	posting->file = target->file;
+	return 0;
+}
+
+int __index_compare_postings(const void *a, const void *b) {
+	const __index_posting *posting_a = a;
+	const __index_posting *posting_b = b;
+	int cmp = strcmp(posting_a->token, posting_b->token);
+	if (cmp != 0) return cmp;
+	return (posting_a->file > posting_b->file) - (posting_a->file < posting_b->file);
+}
+
+int __index_compare_paths(const void *a, const void *b) {
+	return strcmp(*(char * const *) a, *(char * const *) b);
+}
+
+//	Collects the images in a directory & its sub-directories; symlinks to
+//	images are followed, but not those to directories, so there are no loops
+int __index_scan(const char *directory, const char *relative, __index_builder *builder) {
+	char path[IDX_PATH_SIZE];
+	int n = (relative[0] != '\0')
+		? snprintf(path, sizeof(path), "%s/%s", directory, relative)
+		: snprintf(path, sizeof(path), "%s", directory);
+	if (n < 0 || n >= (int) sizeof(path)) return 2;
+
+	DIR *d = opendir(path);
+	if (d == NULL) return 2;
+
+	const size_t ext_len = strlen(IDX_EXTENSION);
+	struct dirent *ent;
+	while ((ent = readdir(d)) != NULL) {
+		if (ent->d_name[0] == '.') continue;
+
+		char entry_relative[IDX_PATH_SIZE];
+		char entry_path[IDX_PATH_SIZE];
+		n = (relative[0] != '\0')
+			? snprintf(entry_relative, sizeof(entry_relative), "%s/%s", relative, ent->d_name)
+			: snprintf(entry_relative, sizeof(entry_relative), "%s", ent->d_name);
+		if (n < 0 || n >= (int) sizeof(entry_relative)) continue;
+		n = snprintf(entry_path, sizeof(entry_path), "%s/%s", directory, entry_relative);
+		if (n < 0 || n >= (int) sizeof(entry_path)) continue;
+
+		struct stat st;
+		if (lstat(entry_path, &st) != 0) continue;
+		if (S_ISDIR(st.st_mode)) {
+			__index_scan(directory, entry_relative, builder);
+			continue;
+		}
+		if (S_ISLNK(st.st_mode) && stat(entry_path, &st) != 0) continue;
+		if (!S_ISREG(st.st_mode)) continue;
+
+		size_t len = strlen(ent->d_name);
+		if (len <= ext_len || strcasecmp(ent->d_name + len - ext_len, IDX_EXTENSION) != 0) continue;
+
+		if (!__index_grow((void **) &builder->paths, &builder->max_paths, builder->num_paths, sizeof(char *))) break;
+		char *copy = strdup(entry_relative);
+		if (copy == NULL) break;
+		builder->paths[builder->num_paths++] = copy;
+	}
+
+	closedir(d);
+	return 0;
+}
+
+//	Finds a disk in the previous index by its path; they're stored in order
+const IDX_Disk *__index_find_disk(const IDX_Index *index, const char *path) {
+	if (index == NULL) return NULL;
+
+	int lo = 0;
+	int hi = (int) index->header->num_disks - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = strcmp(IDX_GetDiskPath(index, mid), path);
+		if (cmp == 0) return &index->disks[mid];
+		if (cmp < 0) lo = mid + 1;
+		else hi = mid - 1;
+	}
+	return NULL;
+}
+
+//	Reads the directory of an image & follows the chain of every file
+int __index_read_disk(const char *path, IDX_Disk *disk, __index_builder *builder, uint8_t *image, DSK_Directory *dir) {
+	disk->err = DIF_LoadImage(path, image, dir);
+	if (disk->err != 0) return 0;
+
+	DSK_GetName(*dir, disk->name, sizeof(disk->name));
+	disk->id[0] = dir->header[18];
+	disk->id[1] = dir->header[19];
+	disk->id[2] = '\0';
+
+	for (int i=0; i<dir->num_entries; i++) {
+		DSK_DirEntry entry = dir->entries[i];
+		if (!__index_grow((void **) &builder->files, &builder->max_files, builder->num_files, sizeof(IDX_File))) return 1;
+
+		EXT_Chain chain;
+		EXT_FollowChain(image, entry.head_pos, &chain);
+
+		IDX_File *file = &builder->files[builder->num_files++];
+		memset(file, 0, sizeof(IDX_File));
+		file->disk = builder->num_disks;
+		memcpy(file->filename, entry.filename, sizeof(file->filename));
+		file->type = entry.type;
+		file->chain_status = chain.status;
+		file->block_count = entry.block_count;
+		file->chain_blocks = chain.num_blocks;
+		disk->num_files++;
+	}
+
+	return 0;
+}
+
+int __index_write(const char *filename, __index_builder *builder, int *num_tokens_written) {
+	char tmp_path[IDX_PATH_SIZE];
+	int n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", filename);
+	if (n < 0 || n >= (int) sizeof(tmp_path)) return 3;
+
+	// Postings of the same word are grouped into a token each, in order
+	qsort(builder->postings, builder->num_postings, sizeof(__index_posting), __index_compare_postings);
+	IDX_Token *tokens = malloc(sizeof(IDX_Token) * (builder->num_postings + 1));
+	uint32_t *postings = malloc(sizeof(uint32_t) * (builder->num_postings + 1));
+	if (tokens == NULL || postings == NULL) {
+		free(tokens);
+		free(postings);
+		return 3;
+	}
+
+	int num_tokens = 0;
+	int num_postings = 0;
+	for (int i=0; i<builder->num_postings; i++) {
+		__index_posting *posting = &builder->postings[i];
+		bool is_new_token = (num_tokens == 0 || strcmp(tokens[num_tokens-1].token, posting->token) != 0);
+		if (is_new_token) {
+			IDX_Token *token = &tokens[num_tokens++];
+			memcpy(token->token, posting->token, IDX_TOKEN_SIZE);
+			token->first_posting = num_postings;
+			token->num_postings = 0;
+		} else if (postings[num_postings-1] == posting->file) {
+			continue;
+		}
+		postings[num_postings++] = posting->file;
+		tokens[num_tokens-1].num_postings++;
+	}
+
+	IDX_Header header = {
+		.magic = IDX_MAGIC,
+		.version = IDX_VERSION,
+		.num_disks = builder->num_disks,
+		.num_files = builder->num_files,
+		.num_tokens = num_tokens,
+		.num_postings = num_postings,
+		.strings_size = builder->strings_size,
+		.struct_sizes = __STRUCT_SIZES,
+	};
+	*num_tokens_written = num_tokens;
+
+	int err = 0;
+	FILE *f_index = fopen(tmp_path, "wb");
+	if (f_index == NULL) err = 3;
+	if (err == 0) {
+		bool failed = fwrite(&header, sizeof(IDX_Header), 1, f_index) != 1;
+		failed |= fwrite(builder->disks, sizeof(IDX_Disk), builder->num_disks, f_index) != (size_t) builder->num_disks;
+		failed |= fwrite(builder->files, sizeof(IDX_File), builder->num_files, f_index) != (size_t) builder->num_files;
+		failed |= fwrite(tokens, sizeof(IDX_Token), num_tokens, f_index) != (size_t) num_tokens;
+		failed |= fwrite(postings, sizeof(uint32_t), num_postings, f_index) != (size_t) num_postings;
+		failed |= fwrite(builder->strings, sizeof(char), builder->strings_size, f_index) != builder->strings_size;
+		if (fclose(f_index) != 0 || failed) err = 3;
+	}
+	free(tokens);
+	free(postings);
+
+	if (err == 0 && rename(tmp_path, filename) != 0) err = 3;
+	if (err != 0) remove(tmp_path);
+	return err;
+}
+
+int IDX_GetPath(const char *directory, char *buf, size_t bufsz) {
+	if (directory == NULL || buf == NULL) return 1;
+
+	int n = snprintf(buf, bufsz, "%s/%s", directory, IDX_FILENAME);
+	if (n < 0 || n >= (int) bufsz) return 2;
+
+	return 0;
+}
+
+int IDX_Update(const char *directory, FILE *f_report, IDX_Stats *stats) {
+	TRC_SCOPE_DETAIL("IDX_Update", directory);
+	if (directory == NULL || stats == NULL) return 1;
+
+	memset(stats, 0, sizeof(IDX_Stats));
+
+	char index_path[IDX_PATH_SIZE];
+	if (IDX_GetPath(directory, index_path, sizeof(index_path)) != 0) return 2;
+
+	__index_builder builder;
+	memset(&builder, 0, sizeof(builder));
+	int err = __index_scan(directory, "", &builder);
+	if (err == 0) qsort(builder.paths, builder.num_paths, sizeof(char *), __index_compare_paths);
+
+	// Without a usable previous index, every image is read
+	IDX_Index previous;
+	bool has_previous = (IDX_Open(directory, &previous) == 0);
+
+	uint8_t *image = malloc(NYBLOG_IMAGE_SIZE);
+	DSK_Directory *dir = malloc(sizeof(DSK_Directory));
+	if (image == NULL || dir == NULL) err = 3;
+
+	for (int i=0; i<builder.num_paths && err == 0; i++) {
+		char path[IDX_PATH_SIZE];
+		int n = snprintf(path, sizeof(path), "%s/%s", directory, builder.paths[i]);
+		struct stat st;
+		if (n < 0 || n >= (int) sizeof(path) || stat(path, &st) != 0) continue;
+
+		if (!__index_grow((void **) &builder.disks, &builder.max_disks, builder.num_disks, sizeof(IDX_Disk))) {
+			err = 3;
+			break;
+		}
+		long path_offset = __index_add_string(&builder, builder.paths[i]);
+		if (path_offset < 0) {
+			err = 3;
+			break;
+		}
+
+		IDX_Disk disk = {
+			.path = path_offset,
+			.first_file = builder.num_files,
+			.mtime_ns = (int64_t) st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec,
+			.size = st.st_size,
+		};
+
+		const IDX_Disk *prev = has_previous ? __index_find_disk(&previous, builder.paths[i]) : NULL;
+		if (prev != NULL && prev->mtime_ns == disk.mtime_ns && prev->size == disk.size) {
+			// Unchanged; its files are copied over as they are
+			memcpy(disk.name, prev->name, sizeof(disk.name));
+			memcpy(disk.id, prev->id, sizeof(disk.id));
+			disk.err = prev->err;
+			for (uint32_t f=0; f<prev->num_files; f++) {
+				if (!__index_grow((void **) &builder.files, &builder.max_files, builder.num_files, sizeof(IDX_File))) {
+					err = 3;
+					break;
+				}
+				IDX_File *file = &builder.files[builder.num_files++];
+				*file = previous.files[prev->first_file + f];
+				file->disk = builder.num_disks;
+				disk.num_files++;
+			}
+			stats->disks_unchanged++;
+		} else {
+			if (__index_read_disk(path, &disk, &builder, image, dir) != 0) err = 3;
+			stats->disks_read++;
+			if (f_report != NULL) fprintf(f_report, "Indexed '%s': %i files\n", builder.paths[i], disk.num_files);
+		}
+		if (disk.err != 0) stats->disks_failed++;
+
+		builder.disks[builder.num_disks++] = disk;
+	}
+	if (has_previous) IDX_Close(&previous);
+	free(image);
+	free(dir);
+
+	// Every file is found by the words of its own name and of its disk's
+	for (int f=0; f<builder.num_files && err == 0; f++) {
+		IDX_File *file = &builder.files[f];
+		__index_token_target target = { .builder = &builder, .file = f };
+		if (__index_tokenise(file->filename, __index_add_posting, &target) < 0) err = 3;
+		if (__index_tokenise(builder.disks[file->disk].name, __index_add_posting, &target) < 0) err = 3;
+	}
+
+	if (err == 0) err = __index_write(index_path, &builder, &stats->num_tokens);
+	stats->num_files = builder.num_files;
+
+	for (int i=0; i<builder.num_paths; i++) free(builder.paths[i]);
+	free(builder.paths);
+	free(builder.disks);
+	free(builder.files);
+	free(builder.postings);
+	free(builder.strings);
+
+	return err;
+}
+
+//	Checks that everything an index refers to is inside it & every string ends
+bool __index_is_consistent(const IDX_Index *index) {
+	const IDX_Header *header = index->header;
+	if (header->strings_size > 0 && index->strings[header->strings_size - 1] != '\0') return false;
+
+	for (uint32_t d=0; d<header->num_disks; d++) {
+		const IDX_Disk *disk = &index->disks[d];
+		if (disk->first_file > header->num_files || disk->num_files > header->num_files - disk->first_file) return false;
+		if (disk->name[sizeof(disk->name) - 1] != '\0' || disk->id[sizeof(disk->id) - 1] != '\0') return false;
+	}
+	for (uint32_t f=0; f<header->num_files; f++) {
+		const IDX_File *file = &index->files[f];
+		if (file->disk >= header->num_disks) return false;
+		if (file->filename[sizeof(file->filename) - 1] != '\0') return false;
+	}
+	for (uint32_t t=0; t<header->num_tokens; t++) {
+		const IDX_Token *token = &index->tokens[t];
+		if (token->first_posting > header->num_postings || token->num_postings > header->num_postings - token->first_posting) return false;
+		if (token->token[IDX_TOKEN_SIZE - 1] != '\0') return false;
+	}
+
+	return true;
+}
+
+int IDX_Open(const char *directory, IDX_Index *index) {
+	if (directory == NULL || index == NULL) return 1;
+
+	memset(index, 0, sizeof(IDX_Index));
+
+	char path[IDX_PATH_SIZE];
+	if (IDX_GetPath(directory, path, sizeof(path)) != 0) return 2;
+
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) return 2;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(IDX_Header)) {
+		close(fd);
+		return 4;
+	}
+
+	// Mapped rather than read, so a query only touches the pages it needs
+	void *data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) return 2;
+
+	const IDX_Header *header = data;
+	if (header->magic != IDX_MAGIC || header->version != IDX_VERSION || header->struct_sizes != __STRUCT_SIZES) {
+		munmap(data, st.st_size);
+		return 3;
+	}
+
+	size_t expected = sizeof(IDX_Header)
+		+ (size_t) header->num_disks * sizeof(IDX_Disk)
+		+ (size_t) header->num_files * sizeof(IDX_File)
+		+ (size_t) header->num_tokens * sizeof(IDX_Token)
+		+ (size_t) header->num_postings * sizeof(uint32_t)
+		+ header->strings_size;
+	if ((size_t) st.st_size < expected) {
+		munmap(data, st.st_size);
+		return 4;
+	}
+
+	const uint8_t *ptr = (const uint8_t *) data + sizeof(IDX_Header);
+	index->data = data;
+	index->size = st.st_size;
+	index->header = header;
+	index->disks = (const IDX_Disk *) ptr;
+	ptr += header->num_disks * sizeof(IDX_Disk);
+	index->files = (const IDX_File *) ptr;
+	ptr += header->num_files * sizeof(IDX_File);
+	index->tokens = (const IDX_Token *) ptr;
+	ptr += header->num_tokens * sizeof(IDX_Token);
+	index->postings = (const uint32_t *) ptr;
+	ptr += header->num_postings * sizeof(uint32_t);
+	index->strings = (const char *) ptr;
+
+	// Every reference is checked once here, so queries can follow them as they are
+	if (!__index_is_consistent(index)) {
+		munmap(data, st.st_size);
+		memset(index, 0, sizeof(IDX_Index));
+		return 4;
+	}
+
+	return 0;
+}
+
+void IDX_Close(IDX_Index *index) {
+	if (index == NULL || index->data == NULL) return;
+
+	munmap(index->data, index->size);
+	index->data = NULL;
+}
+
+const char *IDX_GetDiskPath(const IDX_Index *index, uint32_t disk) {
+	if (index == NULL || index->data == NULL || disk >= index->header->num_disks) return "";
+
+	uint32_t offset = index->disks[disk].path;
+	if (offset >= index->header->strings_size) return "";
+	return index->strings + offset;
+}
+
+int __index_count_word(const char *word, void *user_data) {
+	(void) word;
+	(void) user_data;
+	return 0;
+}
+
+//	Narrows the matches down to the files containing a word, or a word starting with it
+typedef struct {
+	const IDX_Index *index;
+	uint32_t *keep;			// Bit per file that's still a match
+	uint32_t *hits;			// Scratch bits of the files this word is in
+	bool is_prefix;
+	int num_left;			// Words left in the term; only the last one can be a prefix
+} __index_word_filter;
+
+int __index_filter_word(const char *word, void *user_data) {
+	__index_word_filter *filter = user_data;
+	const IDX_Index *index = filter->index;
+	const int num_words = (index->header->num_files + 31) / 32;
+	bool is_prefix = filter->is_prefix && filter->num_left == 1;
+	size_t len = strlen(word);
+	filter->num_left--;
+
+	// The first token that isn't before the word
+	int lo = 0;
+	int hi = index->header->num_tokens;
+	while (lo < hi) {
+		int mid = (lo + hi) / 2;
+		if (strcmp(index->tokens[mid].token, word) < 0) lo = mid + 1;
+		else hi = mid;
+	}
+
+	memset(filter->hits, 0, num_words * sizeof(uint32_t));
+	for (uint32_t t=lo; t<index->header->num_tokens; t++) {
+		const IDX_Token *token = &index->tokens[t];
+		bool matches = is_prefix ? strncmp(token->token, word, len) == 0 : strcmp(token->token, word) == 0;
+		if (!matches) break;
+
+		for (uint32_t p=0; p<token->num_postings; p++) {
+			uint32_t file = index->postings[token->first_posting + p];
+			if (file < index->header->num_files) filter->hits[file / 32] |= 1u << (file % 32);
+		}
+	}
+
+	for (int w=0; w<num_words; w++) filter->keep[w] &= filter->hits[w];
+	return 0;
+}
+
+//	Whether a term is a "blocks>N" comparison rather than a word starting with "blocks"
+bool __index_is_blocks_term(const char *term) {
+	return strncmp(term, "blocks", 6) == 0 && (term[6] == '<' || term[6] == '>' || term[6] == '=');
+}
+
+//	Checks a file against a term that isn't a word; returns -1 if the term is invalid
+int __index_matches_term(const IDX_Index *index, const IDX_File *file, const char *term) {
+	if (strncmp(term, "type:", 5) == 0) {
+		for (int i=SECTYPE_DEL; i<=SECTYPE_REL; i++) {
+			if (strcasecmp(term + 5, __INDEX_TYPE_NAMES[i]) == 0) return file->type == i;
+		}
+		return -1;
+	}
+
+	if (strncmp(term, "health:", 7) == 0) {
+		if (strcasecmp(term + 7, "ok") == 0) return file->chain_status == EXTCHAIN_OK;
+		if (strcasecmp(term + 7, "broken") == 0) return file->chain_status != EXTCHAIN_OK;
+		return -1;
+	}
+
+	if (strncmp(term, "id:", 3) == 0) {
+		if (strlen(term + 3) != 2) return -1;
+		return strncasecmp(index->disks[file->disk].id, term + 3, 2) == 0;
+	}
+
+	if (__index_is_blocks_term(term)) {
+		char op = term[6];
+		char *end;
+		long count = strtol(term + 7, &end, 10);
+		if (end == term + 7 || *end != '\0') return -1;
+		if (op == '>') return file->block_count > count;
+		if (op == '<') return file->block_count < count;
+		if (op == '=') return file->block_count == count;
+		return -1;
+	}
+
+	return -1;
+}
+
+int IDX_Query(const IDX_Index *index, const char *query, uint32_t *results, int max_results, int *num_results) {
+	TRC_SCOPE_DETAIL("IDX_Query", query);
+	if (index == NULL || index->data == NULL || query == NULL || num_results == NULL || (results == NULL && max_results > 0)) return 1;
+
+	*num_results = 0;
+	const uint32_t num_files = index->header->num_files;
+	const int num_words = (num_files + 31) / 32;
+
+	// Every file matches until a term says otherwise
+	uint32_t *keep = malloc((num_words + 1) * sizeof(uint32_t));
+	uint32_t *hits = malloc((num_words + 1) * sizeof(uint32_t));
+	if (keep == NULL || hits == NULL) {
+		free(keep);
+		free(hits);
+		return 3;
+	}
+	memset(keep, 0xFF, num_words * sizeof(uint32_t));
+	if (num_files % 32 != 0) keep[num_words - 1] = (1u << (num_files % 32)) - 1;
+
+	// Words narrow the matches down through the tokens; the rest are checked per file afterwards
+	char terms[IDX_PATH_SIZE];
+	snprintf(terms, sizeof(terms), "%s", query);
+	const char *filters[64];
+	int num_filters = 0;
+	int err = 0;
+	char *save;
+	for (char *term = strtok_r(terms, " \t", &save); term != NULL && err == 0; term = strtok_r(NULL, " \t", &save)) {
+		if (strchr(term, ':') != NULL || __index_is_blocks_term(term)) {
+			if (num_filters >= 64) err = 2;
+			else filters[num_filters++] = term;
+			continue;
+		}
+
+		size_t len = strlen(term);
+		__index_word_filter filter = {
+			.index = index,
+			.keep = keep,
+			.hits = hits,
+			.is_prefix = (len > 0 && term[len-1] == '*'),
+		};
+		if (filter.is_prefix) term[len-1] = '\0';
+
+		// A term like "boulder-dash" is several words, all of which have to be there
+		filter.num_left = __index_tokenise(term, __index_count_word, NULL);
+		if (filter.num_left <= 0) {
+			err = 2;
+			break;
+		}
+		__index_tokenise(term, __index_filter_word, &filter);
+	}
+
+	for (uint32_t f=0; f<num_files && err == 0; f++) {
+		if (!((keep[f / 32] >> (f % 32)) & 1)) continue;
+
+		bool matches = true;
+		for (int i=0; i<num_filters && matches; i++) {
+			int m = __index_matches_term(index, &index->files[f], filters[i]);
+			if (m < 0) err = 2;
+			matches = (m == 1);
+		}
+		if (!matches) continue;
+
+		if (*num_results < max_results) results[*num_results] = f;
+		(*num_results)++;
+	}
+
+	free(keep);
+	free(hits);
+	return err;
+}
+
+void IDX_WriteMatch(FILE *f_report, const IDX_Index *index, uint32_t file) {
+	if (f_report == NULL || index == NULL || index->data == NULL || file >= index->header->num_files) return;
+
+	const IDX_File *match = &index->files[file];
+	const char *type_name = (match->type <= SECTYPE_REL) ? __INDEX_TYPE_NAMES[match->type] : "???";
+	fprintf(f_report, "%s: \"%s\" %s %i blocks", IDX_GetDiskPath(index, match->disk), match->filename, type_name, match->block_count);
+	if (match->chain_status == EXTCHAIN_OK) fprintf(f_report, " [OK]\n");
+	else fprintf(f_report, " [broken after %i blocks: %s]\n", match->chain_blocks, EXT_GetChainStatusName(match->chain_status));
+}
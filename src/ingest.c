@@ -0,0 +1,360 @@
+#include "../include/ingest.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+static volatile sig_atomic_t __stop_requested = 0;
+
+//	Bytes received from the source, waiting for the parser
+//
+//	A thread of its own keeps reading the source into it, so a slow disk
+//	write never leaves the serial port's buffer to overflow
+typedef struct {
+	uint8_t *data;
+	size_t head;		// Where the next received byte goes
+	size_t tail;		// Next byte for the parser
+	size_t used;
+	bool at_eof;
+	bool failed;
+
+	int fd;
+	bool is_tty;
+	bool paused;		// Whether the sender was sent an XOFF
+	uint64_t bytes;
+
+	pthread_mutex_t lock;
+	pthread_cond_t has_data;
+	pthread_cond_t has_space;
+} __ring;
+
+//	Everything the blocks of a stream are written to
+typedef struct {
+	__ring *ring;
+	NYB_DiskImage image;
+	NYB_Recon *recon;
+	const char *recon_filename;
+	NYB_Journal journal;
+	bool ignore_errors;
+	bool dirty;				// Blocks were added since the last flush
+	bool failed;
+
+	FILE *f_report;
+	FILE *f_log;
+	ING_Stats *stats;
+	double start_ms;
+	double last_flush_ms;
+	double last_report_ms;
+} __target;
+
+
+void __handle_interrupt(int sig) {
+	(void) sig;
+	__stop_requested = 1;
+}
+
+double __now_ms() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000.0 + ts.tv_nsec / 1000000.0;
+}
+
+void *__receive(void *arg) {
+	__ring *ring = arg;
+
+	while (true) {
+		// Wait for something to arrive, checking for interrupts now and then
+		struct pollfd pfd = { ring->fd, POLLIN, 0 };
+		int ready = poll(&pfd, 1, ING_POLL_MS);
+		if (__stop_requested) break;
+		if (ready < 0 && errno != EINTR) {
+			ring->failed = true;
+			break;
+		}
+		if (ready <= 0) continue;
+
+		// Only the free part of the ring is written to, so it's read without holding the lock
+		pthread_mutex_lock(&ring->lock);
+		while (ring->used == ING_RING_SIZE && !__stop_requested) pthread_cond_wait(&ring->has_space, &ring->lock);
+		size_t space = ING_RING_SIZE - ring->used;
+		size_t contiguous = ING_RING_SIZE - ring->head;
+		if (contiguous > space) contiguous = space;
+		pthread_mutex_unlock(&ring->lock);
+		if (__stop_requested) break;
+
+		ssize_t n = read(ring->fd, ring->data + ring->head, contiguous);
+		if (n < 0 && (errno == EINTR || errno == EAGAIN)) continue;
+		if (n <= 0) {
+			if (n < 0) ring->failed = true;
+			break;
+		}
+
+		pthread_mutex_lock(&ring->lock);
+		ring->head = (ring->head + n) % ING_RING_SIZE;
+		ring->used += n;
+		ring->bytes += n;
+		if (ring->is_tty && !ring->paused && ring->used >= ING_HIGH_WATER) {
+			tcflow(ring->fd, TCIOFF);
+			ring->paused = true;
+		}
+		pthread_cond_signal(&ring->has_data);
+		pthread_mutex_unlock(&ring->lock);
+	}
+
+	pthread_mutex_lock(&ring->lock);
+	ring->at_eof = true;
+	pthread_cond_signal(&ring->has_data);
+	pthread_mutex_unlock(&ring->lock);
+	return NULL;
+}
+
+//	Hands the parser whatever has been received; waits if there's nothing yet
+ssize_t __read_ring(void *source, void *buf, size_t len) {
+	__ring *ring = source;
+
+	pthread_mutex_lock(&ring->lock);
+	while (ring->used == 0 && !ring->at_eof) pthread_cond_wait(&ring->has_data, &ring->lock);
+	if (ring->used == 0) {
+		pthread_mutex_unlock(&ring->lock);
+		return ring->failed ? -1 : 0;
+	}
+
+	size_t n = (len < ring->used) ? len : ring->used;
+	size_t first = ING_RING_SIZE - ring->tail;
+	if (first > n) first = n;
+	memcpy(buf, ring->data + ring->tail, first);
+	memcpy((uint8_t *) buf + first, ring->data, n - first);
+	ring->tail = (ring->tail + n) % ING_RING_SIZE;
+	ring->used -= n;
+
+	if (ring->paused && ring->used <= ING_LOW_WATER) {
+		tcflow(ring->fd, TCION);
+		ring->paused = false;
+	}
+	pthread_cond_signal(&ring->has_space);
+	pthread_mutex_unlock(&ring->lock);
+
+	return n;
+}
+
+//	Writes the image & recon file, after which the journal can start over
+int __flush(__target *target) {
+	if (NYB_Image_Flush(&target->image) != 0) return 5;
+	if (target->recon != NULL) {
+		if (NYB_Recon_Save(target->recon, target->recon_filename, target->image.data) != 0) return 5;
+	}
+	if (NYB_Journal_Checkpoint(&target->journal) != 0) return 5;
+
+	target->dirty = false;
+	target->stats->flushes++;
+	return 0;
+}
+
+void __log_info(const char *message, void *user_data) {
+	__target *target = user_data;
+	fprintf(target->f_log, " - Info Message in log file: %s\n", message);
+}
+
+void __report(__target *target, double now_ms, bool final) {
+	ING_Stats *stats = target->stats;
+	stats->seconds = (now_ms - target->start_ms) / 1000.0;
+	if (target->f_report == NULL) return;
+
+	double rate = (stats->seconds > 0.0) ? stats->bytes / 1024.0 / stats->seconds : 0.0;
+	fprintf(target->f_report, "\r%6i blocks (%i written) | %i disk errors, %i checksum errors, %i parse errors | %.1f KB/s  ",
+		stats->blocks, stats->blocks_written, stats->count_disk_errors,
+		stats->count_checksum_errors, stats->count_parse_errors, rate
+	);
+	if (final) fprintf(target->f_report, "\n");
+	fflush(target->f_report);
+}
+
+int __apply_block(NYB_DataBlock *block, void *user_data) {
+	__target *target = user_data;
+	ING_Stats *stats = target->stats;
+
+	stats->blocks++;
+	if (block->err_code != 0) stats->count_disk_errors++;
+	if (block->checksum != DSK_Checksum(block->data)) stats->count_checksum_errors++;
+	if (block->parse_error != 0) stats->count_parse_errors++;
+
+	if (NYB_Image_WriteBlock(&target->image, block, target->ignore_errors) == 0) stats->blocks_written++;
+	if (target->recon != NULL) NYB_Recon_AddBlock(target->recon, block);
+	target->dirty = true;
+
+	return 0;
+}
+
+int __ingest_block(NYB_DataBlock *block, void *user_data) {
+	__target *target = user_data;
+
+	if (NYB_Journal_Append(&target->journal, block) != 0) {
+		target->failed = true;
+		return 1;
+	}
+	__apply_block(block, target);
+
+	pthread_mutex_lock(&target->ring->lock);
+	target->stats->bytes = target->ring->bytes;
+	pthread_mutex_unlock(&target->ring->lock);
+
+	double now = __now_ms();
+	if (now - target->last_flush_ms >= ING_FLUSH_MS) {
+		if (__flush(target) != 0) {
+			target->failed = true;
+			return 1;
+		}
+		target->last_flush_ms = now;
+	}
+	if (now - target->last_report_ms >= ING_REPORT_MS) {
+		__report(target, now, false);
+		target->last_report_ms = now;
+	}
+
+	return 0;
+}
+
+int ING_Ingest(const char *source, const char *disk_filename, const char *recon_filename, bool ignore_errors, FILE *f_report, FILE *f_log, ING_Stats *stats) {
+	if (source == NULL || disk_filename == NULL || stats == NULL) return 1;
+
+	memset(stats, 0, sizeof(ING_Stats));
+
+	int fd = STDIN_FILENO;
+	if (strcmp(source, "-") != 0) fd = open(source, O_RDONLY | O_NOCTTY);
+	if (fd < 0) return 2;
+
+	// Serial ports deliver bytes exactly as they were sent, and pause when asked to
+	struct termios tio_orig;
+	bool is_tty = isatty(fd);
+	if (is_tty) {
+		tcgetattr(fd, &tio_orig);
+		struct termios tio = tio_orig;
+		cfmakeraw(&tio);
+		tio.c_iflag |= IXOFF;
+		tio.c_lflag |= ISIG;		// Keeps Ctrl-C working when reading from a terminal
+		tio.c_cc[VMIN] = 1;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd, TCSANOW, &tio);
+	}
+
+	__ring ring = {
+		.data = malloc(ING_RING_SIZE),
+		.fd = fd,
+		.is_tty = is_tty,
+	};
+	pthread_mutex_init(&ring.lock, NULL);
+	pthread_cond_init(&ring.has_data, NULL);
+	pthread_cond_init(&ring.has_space, NULL);
+
+	__target target = {
+		.ring = &ring,
+		.recon_filename = recon_filename,
+		.ignore_errors = ignore_errors,
+		.f_report = f_report,
+		.f_log = f_log,
+		.stats = stats,
+	};
+	target.image.data = NULL;
+	target.journal.f_journal = NULL;
+
+	int err = 0;
+	if (ring.data == NULL || NYB_Image_Open(&target.image, disk_filename) != 0) {
+		err = 3;
+		goto cleanup;
+	}
+	target.image.f_log = f_log;
+
+	if (recon_filename != NULL) {
+		target.recon = malloc(sizeof(NYB_Recon));
+		if (target.recon == NULL) {
+			err = 3;
+			goto cleanup;
+		}
+		NYB_Recon_Init(target.recon);
+
+		FILE *f_meta = fopen(recon_filename, "rb");
+		if (f_meta != NULL) {
+			err = NYB_Recon_Load(target.recon, f_meta, target.image.data);
+			fclose(f_meta);
+			if (err == 3) {
+				err = 6;
+				goto cleanup;
+			}
+			if (err != 0) NYB_Recon_Init(target.recon);
+			err = 0;
+		}
+	}
+
+	// Blocks received before an earlier ingest was interrupted come first
+	if (NYB_Journal_Open(&target.journal, disk_filename, source, __apply_block, &target) != 0) {
+		err = 3;
+		goto cleanup;
+	}
+	if (f_log != NULL) {
+		if (target.journal.was_discarded) fprintf(f_log, "Warn: Discarding journal '%s' of a different import\n", target.journal.filename);
+		if (target.journal.num_replayed > 0) fprintf(f_log, "Resuming interrupted import; recovered %i blocks from '%s'\n", target.journal.num_replayed, target.journal.filename);
+	}
+
+	struct sigaction sa_orig;
+	struct sigaction sa = { .sa_handler = __handle_interrupt };
+	sigemptyset(&sa.sa_mask);
+	__stop_requested = 0;
+	sigaction(SIGINT, &sa, &sa_orig);
+
+	NYB_LogReader reader;
+	pthread_t receiver;
+	target.start_ms = target.last_flush_ms = target.last_report_ms = __now_ms();
+	if (pthread_create(&receiver, NULL, __receive, &ring) != 0) {
+		sigaction(SIGINT, &sa_orig, NULL);
+		err = 4;
+		goto cleanup;
+	}
+
+	int count = -1;
+	if (NYB_LogReader_OpenSource(&reader, __read_ring, &ring) == 0) {
+		if (f_log != NULL) NYB_LogReader_SetInfoCallback(&reader, __log_info, &target);
+		count = NYB_LogReader_ForEach(&reader, __ingest_block, &target);
+		NYB_LogReader_Close(&reader);
+	}
+
+	// Let the receiver go if parsing stopped early
+	if (count < 0 || target.failed) __stop_requested = 1;
+	pthread_mutex_lock(&ring.lock);
+	pthread_cond_signal(&ring.has_space);
+	pthread_mutex_unlock(&ring.lock);
+	pthread_join(receiver, NULL);
+	sigaction(SIGINT, &sa_orig, NULL);
+
+	stats->bytes = ring.bytes;
+	if (target.failed) err = 5;
+	else if (count < 0 || ring.failed) err = 4;
+
+	// Whatever arrived is kept, even if the stream broke off
+	if (!target.failed && (target.dirty || stats->flushes == 0)) {
+		if (__flush(&target) != 0) err = 5;
+	}
+	__report(&target, __now_ms(), true);
+
+	// Once everything's been written out, the journal isn't needed anymore
+	NYB_Journal_Close(&target.journal, err == 0 || err == 4);
+
+cleanup:
+	NYB_Journal_Close(&target.journal, false);
+	NYB_Image_Close(&target.image);
+	free(target.recon);
+	free(ring.data);
+	pthread_cond_destroy(&ring.has_space);
+	pthread_cond_destroy(&ring.has_data);
+	pthread_mutex_destroy(&ring.lock);
+	if (is_tty) {
+		if (ring.paused) tcflow(fd, TCION);
+		tcsetattr(fd, TCSANOW, &tio_orig);
+	}
+	if (fd != STDIN_FILENO) close(fd);
+
+	return err;
+}
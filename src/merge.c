@@ -0,0 +1,285 @@
+#include "../include/merge.h"
+
+//	16 byte-lanes at a time; GCC & Clang lower this to SSE2/NEON
+typedef uint8_t __v16u8 __attribute__((vector_size(16)));
+#define VOTE_LANES (BLOCK_SIZE / sizeof(__v16u8))
+
+
+bool __is_clean_copy(NYB_DataBlock *block) {
+	if (block->err_code != 0 || block->parse_error != 0) return false;
+	return block->checksum == DSK_Checksum(block->data);
+}
+
+//	Picks the most common value of every byte over all copies
+//
+//	Ties go to whichever copy comes first. Returns the lowest vote count
+//	any of the chosen bytes received.
+int __vote_bytes(NYB_DataBlock *copies, int num_copies, uint8_t out[BLOCK_SIZE]) {
+	__v16u8 best[VOTE_LANES];
+	__v16u8 best_votes[VOTE_LANES];
+	memset(best, 0, sizeof(best));
+	memset(best_votes, 0, sizeof(best_votes));
+
+	for (int c=0; c<num_copies; c++) {
+		__v16u8 cand[VOTE_LANES];
+		__v16u8 votes[VOTE_LANES];
+		memcpy(cand, copies[c].data, BLOCK_SIZE);
+		memset(votes, 0, sizeof(votes));
+
+		// Count how many copies agree with this one on each byte
+		for (int d=0; d<num_copies; d++) {
+			__v16u8 other[VOTE_LANES];
+			memcpy(other, copies[d].data, BLOCK_SIZE);
+			for (int l=0; l<VOTE_LANES; l++) {
+				votes[l] -= (__v16u8)(cand[l] == other[l]);
+			}
+		}
+
+		for (int l=0; l<VOTE_LANES; l++) {
+			__v16u8 more = (__v16u8)(votes[l] > best_votes[l]);
+			best[l] = (best[l] & ~more) | (cand[l] & more);
+			best_votes[l] = (best_votes[l] & ~more) | (votes[l] & more);
+		}
+	}
+
+	memcpy(out, best, BLOCK_SIZE);
+
+	uint8_t counts[BLOCK_SIZE];
+	memcpy(counts, best_votes, BLOCK_SIZE);
+	int min = num_copies;
+	for (int i=0; i<BLOCK_SIZE; i++) {
+		if (counts[i] < min) min = counts[i];
+	}
+	return min;
+}
+
+int MRG_MergeSector(NYB_DataBlock *copies, int num_copies, NYB_DataBlock *out, MRG_SectorResult *result) {
+	if (out == NULL || result == NULL) return 1;
+	if (num_copies > 0 && copies == NULL) return 1;
+	if (num_copies > MAX_MERGE_INPUTS) return 2;
+
+	result->source = MRGSRC_NONE;
+	result->input_index = -1;
+	result->copies = num_copies;
+	result->confidence = 0;
+
+	if (num_copies <= 0) {
+		memset(out, 0, sizeof(NYB_DataBlock));
+		return 0;
+	}
+
+	// Any copy that survived the transfer intact is good enough
+	for (int i=0; i<num_copies; i++) {
+		if (!__is_clean_copy(&copies[i])) continue;
+
+		*out = copies[i];
+		result->source = MRGSRC_VERIFIED;
+		result->input_index = i;
+		result->confidence = 100;
+		return 0;
+	}
+
+	if (num_copies == 1) {
+		*out = copies[0];
+		result->source = MRGSRC_SINGLE;
+		result->input_index = 0;
+		return 0;
+	}
+
+	// Otherwise reconstruct the block byte by byte
+	*out = copies[0];
+	int min_votes = __vote_bytes(copies, num_copies, out->data);
+	result->source = MRGSRC_VOTE;
+	result->confidence = (100 * min_votes) / num_copies;
+
+	// If the result matches any of the checksums calculated on the C64 it's as good as verified
+	uint16_t chk = DSK_Checksum(out->data);
+	for (int i=0; i<num_copies; i++) {
+		if (copies[i].checksum != chk) continue;
+
+		out->checksum = chk;
+		out->err_code = 0;
+		out->parse_error = 0;
+		result->source = MRGSRC_VOTE_VERIFIED;
+		result->confidence = 100;
+		break;
+	}
+
+	return 0;
+}
+
+FILE *MRG_OpenCompanionImage(const char *recon_filename) {
+	if (recon_filename == NULL) return NULL;
+
+	char image_filename[4096];
+	int n = snprintf(image_filename, sizeof(image_filename), "%s", recon_filename);
+	if (n < 0 || n >= (int) sizeof(image_filename) - 4) return NULL;
+
+	// Swap the extension for `.d64`
+	char *ext = strrchr(image_filename, '.');
+	char *sep = strrchr(image_filename, '/');
+	if (ext == NULL || (sep != NULL && ext < sep)) ext = image_filename + n;
+	strcpy(ext, ".d64");
+
+	return fopen(image_filename, "rb");
+}
+
+//	Opens a sparse recon file's image into `f_image` & checks it's the one the file was saved with
+//
+//	Returns MRG_CheckCompanionImage's return code
+int __check_companion(FILE *f_meta, const char *recon_filename, FILE **f_image) {
+	*f_image = NULL;
+	int err = NYB_Recon_CheckImage(f_meta, NULL);
+	if (err != 3) return (err == 0) ? 0 : 2;
+
+	*f_image = MRG_OpenCompanionImage(recon_filename);
+	err = NYB_Recon_CheckImageFile(f_meta, *f_image);
+	if (err == 5) err = 3;
+	return err;
+}
+
+int MRG_CheckCompanionImage(const char *recon_filename) {
+	if (recon_filename == NULL) return 1;
+
+	FILE *f_meta = fopen(recon_filename, "rb");
+	if (f_meta == NULL) return 2;
+
+	FILE *f_image;
+	int err = __check_companion(f_meta, recon_filename, &f_image);
+	if (f_image != NULL) fclose(f_image);
+	fclose(f_meta);
+
+	return err;
+}
+
+int MRG_MergeRecons(char **input_filenames, int num_inputs, const char *disk_filename, const char *recon_filename, FILE *f_report) {
+	if (input_filenames == NULL || disk_filename == NULL) return 1;
+	if (num_inputs < 1 || num_inputs > MAX_MERGE_INPUTS) return 1;
+
+	FILE *inputs[MAX_MERGE_INPUTS];
+	FILE *images[MAX_MERGE_INPUTS];
+	for (int i=0; i<num_inputs; i++) {
+		inputs[i] = fopen(input_filenames[i], "rb");
+		images[i] = NULL;
+		if (inputs[i] != NULL) continue;
+
+		for (int j=0; j<i; j++) {
+			fclose(inputs[j]);
+			if (images[j] != NULL) fclose(images[j]);
+		}
+		return 2;
+	}
+
+	// Sparse inputs are useless without their images, so those are all checked before anything is written
+	int err = 0;
+	for (int i=0; i<num_inputs && err == 0; i++) {
+		int check = __check_companion(inputs[i], input_filenames[i], &images[i]);
+		if (check == 3 || check == 4) err = 6;
+	}
+	FILE *f_disk = (err == 0) ? fopen(disk_filename, "wb") : NULL;
+	NYB_Recon *recon = NULL;
+	uint8_t *image = NULL;
+
+	// Only one copy of the current sector per input is kept in memory
+	NYB_DataBlock *copies = malloc(num_inputs * sizeof(NYB_DataBlock));
+	if (err != 0) goto cleanup;
+	if (f_disk == NULL || copies == NULL) {
+		err = 3;
+		goto cleanup;
+	}
+
+	// The merged transfer info is written whole once the image is known
+	if (recon_filename != NULL) {
+		recon = malloc(sizeof(NYB_Recon));
+		image = malloc(NYBLOG_IMAGE_SIZE);
+		if (recon == NULL || image == NULL) {
+			err = 3;
+			goto cleanup;
+		}
+		NYB_Recon_Init(recon);
+	}
+
+	if (f_report != NULL) {
+		fprintf(f_report, "# disekt merge report\n#\n# Inputs:\n");
+		for (int i=0; i<num_inputs; i++) fprintf(f_report, "# % 4i: %s\n", i, input_filenames[i]);
+		fprintf(f_report, "#\n# Track Sector Source         Input Copies Confidence\n");
+	}
+
+	int copy_inputs[MAX_MERGE_INPUTS];
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int sc = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<sc; s++) {
+			int num_copies = 0;
+			for (int i=0; i<num_inputs; i++) {
+				NYB_DataBlock *block = &copies[num_copies];
+				block->track_num = t;
+				block->sector_index = s;
+				if (NYB_Meta_ReadBlock(inputs[i], block) != 0) continue;
+				if (block->block_status == 0x00) continue;
+
+				if (block->block_status & NYBLOG_STATUS_IN_IMAGE) {
+					if (images[i] == NULL) continue;
+					if (DSK_File_GetData(images[i], (DSK_Position){ t, s }, block->data, BLOCK_SIZE) != 0) continue;
+					block->block_status &= ~NYBLOG_STATUS_IN_IMAGE;
+				}
+
+				copy_inputs[num_copies++] = i;
+			}
+
+			NYB_DataBlock out;
+			MRG_SectorResult result;
+			MRG_MergeSector(copies, num_copies, &out, &result);
+			result.pos = (DSK_Position){ t, s };
+			if (result.input_index >= 0) result.input_index = copy_inputs[result.input_index];
+
+			// Sectors are visited in image order, so the image is written sequentially
+			if (fwrite(out.data, sizeof(uint8_t), BLOCK_SIZE, f_disk) != BLOCK_SIZE) {
+				err = 4;
+				goto cleanup;
+			}
+
+			if (recon != NULL) {
+				int index = DSK_PositionToIndex(result.pos);
+				memcpy(image + (index * BLOCK_SIZE), out.data, BLOCK_SIZE);
+				if (result.source != MRGSRC_NONE) {
+					out.track_num = t;
+					out.sector_index = s;
+					NYB_Recon_AddBlock(recon, &out);
+					recon->attempts[index] = result.copies;
+				}
+			}
+
+			if (f_report != NULL) {
+				fprintf(f_report, "  % 5i % 6i %-14s % 5i % 6i % 9i%%\n",
+					t, s, MRG_GetSourceName(result.source), result.input_index,
+					result.copies, result.confidence
+				);
+			}
+		}
+	}
+
+	if (recon != NULL && NYB_Recon_Save(recon, recon_filename, image) != 0) err = 5;
+
+cleanup:
+	for (int i=0; i<num_inputs; i++) {
+		fclose(inputs[i]);
+		if (images[i] != NULL) fclose(images[i]);
+	}
+	if (f_disk != NULL) fclose(f_disk);
+	free(copies);
+	free(recon);
+	free(image);
+
+	return err;
+}
+
+const char *MRG_GetSourceName(MRG_Source source) {
+	switch (source) {
+		case MRGSRC_NONE: return "missing";
+		case MRGSRC_VERIFIED: return "verified";
+		case MRGSRC_VOTE_VERIFIED: return "vote-verified";
+		case MRGSRC_VOTE: return "vote";
+		case MRGSRC_SINGLE: return "single";
+	}
+	return "";
+}
@@ -0,0 +1,217 @@
+#include "../include/nybbin.h"
+
+//	Where a block record was written, kept until the attempt table is written
+typedef struct {
+	uint64_t offset;
+	int index;
+} __attempt;
+
+typedef struct {
+	NYB_LogReader *reader;
+	FILE *f_bin;
+	uint64_t offset;		// Where the next record goes
+	uint64_t record_count;
+
+	__attempt *attempts;
+	size_t num_attempts;
+	size_t max_attempts;
+
+	bool failed;
+} __convert_state;
+
+
+bool __write_record(__convert_state *state, NYB_BinRecord *record, const void *payload) {
+	size_t w = fwrite(record, sizeof(NYB_BinRecord), 1, state->f_bin);
+	if (record->length > 0) w += fwrite(payload, record->length, 1, state->f_bin);
+	if (w != (record->length > 0 ? 2 : 1)) {
+		state->failed = true;
+		return false;
+	}
+
+	state->offset += sizeof(NYB_BinRecord) + record->length;
+	state->record_count++;
+	return true;
+}
+
+void __convert_info(const char *message, void *user_data) {
+	__convert_state *state = user_data;
+	if (state->failed) return;
+
+	NYB_BinRecord record = {
+		.type = NYBLOG_INFO,
+		.length = strlen(message),
+	};
+	__write_record(state, &record, message);
+}
+
+int __convert_block(NYB_DataBlock *block, void *user_data) {
+	__convert_state *state = user_data;
+
+	// Remember where each sector's attempts are
+	int index = DSK_PositionToIndex((DSK_Position){ block->track_num, block->sector_index });
+	if (index >= 0) {
+		if (state->num_attempts >= state->max_attempts) {
+			size_t max = (state->max_attempts == 0) ? 1024 : state->max_attempts * 2;
+			__attempt *attempts = realloc(state->attempts, max * sizeof(__attempt));
+			if (attempts == NULL) {
+				state->failed = true;
+				return 1;
+			}
+			state->attempts = attempts;
+			state->max_attempts = max;
+		}
+
+		state->attempts[state->num_attempts++] = (__attempt){ state->offset, index };
+	}
+
+	NYB_BinRecord record = {
+		.type = state->reader->end_type,
+		.track_num = block->track_num,
+		.sector_index = block->sector_index,
+		.err_code = block->err_code,
+		.checksum = block->checksum,
+		.parse_error = block->parse_error,
+		.length = BLOCK_SIZE,
+	};
+	if (!__write_record(state, &record, block->data)) return 1;
+
+	return 0;
+}
+
+long NYB_Bin_Convert(const char *log_filename, const char *bin_filename) {
+	if (log_filename == NULL || bin_filename == NULL) return -1;
+
+	NYB_LogReader reader;
+	if (NYB_LogReader_Open(&reader, log_filename) != 0) return -1;
+
+	__convert_state state = {
+		.reader = &reader,
+		.f_bin = fopen(bin_filename, "wb"),
+		.offset = sizeof(NYB_BinHeader),
+	};
+	if (state.f_bin == NULL) {
+		NYB_LogReader_Close(&reader);
+		return -1;
+	}
+	NYB_LogReader_SetInfoCallback(&reader, __convert_info, &state);
+
+	// Leave room for the header; it's only known once all records are written
+	NYB_BinHeader header;
+	memset(&header, 0, sizeof(NYB_BinHeader));
+	fwrite(&header, sizeof(NYB_BinHeader), 1, state.f_bin);
+
+	int count = NYB_LogReader_ForEach(&reader, __convert_block, &state);
+	NYB_LogReader_Close(&reader);
+	if (count < 0) state.failed = true;
+
+	// Sort the attempts by sector, keeping the order they arrived in
+	uint64_t *table = NULL;
+	if (!state.failed && state.num_attempts > 0) {
+		table = malloc(state.num_attempts * sizeof(uint64_t));
+		if (table == NULL) state.failed = true;
+	}
+	if (!state.failed) {
+		for (size_t i=0; i<state.num_attempts; i++) header.index[state.attempts[i].index].count++;
+
+		uint32_t first = 0;
+		for (int i=0; i<NYBBIN_INDEX_SIZE; i++) {
+			header.index[i].first = first;
+			first += header.index[i].count;
+		}
+
+		uint32_t next[NYBBIN_INDEX_SIZE];
+		for (int i=0; i<NYBBIN_INDEX_SIZE; i++) next[i] = header.index[i].first;
+		for (size_t i=0; i<state.num_attempts; i++) {
+			table[next[state.attempts[i].index]++] = state.attempts[i].offset;
+		}
+
+		size_t w = fwrite(table, sizeof(uint64_t), state.num_attempts, state.f_bin);
+		if (w != state.num_attempts) state.failed = true;
+	}
+
+	header.magic = NYBBIN_MAGIC;
+	header.version = NYBBIN_VERSION;
+	header.record_count = state.record_count;
+	header.block_count = state.num_attempts;
+	header.records_offset = sizeof(NYB_BinHeader);
+	header.attempts_offset = state.offset;
+
+	if (!state.failed) {
+		fseek(state.f_bin, 0l, SEEK_SET);
+		if (fwrite(&header, sizeof(NYB_BinHeader), 1, state.f_bin) != 1) state.failed = true;
+	}
+
+	free(table);
+	free(state.attempts);
+	if (fclose(state.f_bin) != 0) state.failed = true;
+	if (state.failed) {
+		remove(bin_filename);
+		return -1;
+	}
+
+	return state.record_count;
+}
+
+int NYB_Bin_Open(NYB_BinLog *log, const char *filename) {
+	if (log == NULL || filename == NULL) return 1;
+
+	log->f_bin = fopen(filename, "rb");
+	if (log->f_bin == NULL) return 2;
+
+	size_t r = fread(&log->header, sizeof(NYB_BinHeader), 1, log->f_bin);
+	if (r != 1 || log->header.magic != NYBBIN_MAGIC || log->header.version != NYBBIN_VERSION) {
+		fclose(log->f_bin);
+		log->f_bin = NULL;
+		return 3;
+	}
+
+	return 0;
+}
+
+int NYB_Bin_GetAttemptCount(NYB_BinLog *log, DSK_Position pos) {
+	if (log == NULL) return 0;
+
+	int index = DSK_PositionToIndex(pos);
+	if (index < 0) return 0;
+
+	return log->header.index[index].count;
+}
+
+int NYB_Bin_ReadAttempt(NYB_BinLog *log, DSK_Position pos, int attempt, NYB_DataBlock *block) {
+	if (log == NULL || log->f_bin == NULL || block == NULL) return 1;
+
+	int index = DSK_PositionToIndex(pos);
+	if (index < 0) return 2;
+	NYB_BinIndexEntry entry = log->header.index[index];
+	if (attempt < 0 || attempt >= entry.count) return 2;
+
+	// Look up the record in the attempt table, then jump straight to it
+	uint64_t offset;
+	fseek(log->f_bin, log->header.attempts_offset + (entry.first + attempt) * sizeof(uint64_t), SEEK_SET);
+	if (fread(&offset, sizeof(uint64_t), 1, log->f_bin) != 1) return 3;
+
+	NYB_BinRecord record;
+	fseek(log->f_bin, offset, SEEK_SET);
+	if (fread(&record, sizeof(NYB_BinRecord), 1, log->f_bin) != 1) return 3;
+
+	memset(block, 0, sizeof(NYB_DataBlock));
+	block->block_status = 0x01;
+	block->track_num = record.track_num;
+	block->sector_index = record.sector_index;
+	block->err_code = record.err_code;
+	block->checksum = record.checksum;
+	block->parse_error = record.parse_error;
+
+	size_t len = record.length;
+	if (len > BLOCK_SIZE) len = BLOCK_SIZE;
+	if (fread(block->data, sizeof(uint8_t), len, log->f_bin) != len) return 3;
+
+	return 0;
+}
+
+void NYB_Bin_Close(NYB_BinLog *log) {
+	if (log == NULL || log->f_bin == NULL) return;
+
+	fclose(log->f_bin);
+	log->f_bin = NULL;
+}
@@ -1,4 +1,76 @@
 #include "../include/nyblog.h"
+#include "../include/nybbin.h"
+#include "../include/cache.h"
+#include "../include/trace.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+#include <stddef.h>
+
+//	Hex digit values plus one; zero marks characters that aren't hex digits
+static const uint8_t __hex_values[256] = {
+	['0'] = 0x01, ['1'] = 0x02, ['2'] = 0x03, ['3'] = 0x04, ['4'] = 0x05,
+	['5'] = 0x06, ['6'] = 0x07, ['7'] = 0x08, ['8'] = 0x09, ['9'] = 0x0A,
+	['A'] = 0x0B, ['B'] = 0x0C, ['C'] = 0x0D, ['D'] = 0x0E, ['E'] = 0x0F, ['F'] = 0x10,
+	['a'] = 0x0B, ['b'] = 0x0C, ['c'] = 0x0D, ['d'] = 0x0E, ['e'] = 0x0F, ['f'] = 0x10,
+};
+
+static inline bool __is_blank(char c) {
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static inline bool __is_type_separator(char c) {
+	return c == ' ' || c == ':' || c == ';';
+}
+
+//	Finds the next occurence of three repeated characters, like ">>>"
+const char *__find_marker(const char *str, char c) {
+	const char *p = strchr(str, c);
+	while (p != NULL) {
+		if (p[1] == c && p[2] == c) return p;
+		p = strchr(p + 1, c);
+	}
+	return NULL;
+}
+
+NYB_LogLineType __match_type(const char *word, size_t len) {
+	switch (len) {
+		case 4: if (memcmp(word, "INFO", 4) == 0) return NYBLOG_INFO; break;
+		case 5: if (memcmp(word, "ERROR", 5) == 0) return NYBLOG_ERROR; break;
+		case 7: if (memcmp(word, "WARNING", 7) == 0) return NYBLOG_WARNING; break;
+		case 9: if (memcmp(word, "BLOCK-END", 9) == 0) return NYBLOG_BLOCK_END; break;
+		case 11: if (memcmp(word, "BLOCK-START", 11) == 0) return NYBLOG_BLOCK_START; break;
+	}
+	return NYBLOG_INVALID;
+}
+
+//	Reads the next `K=value;` pair, from `*p` up to `end`; the key is the
+//	first character of the field and the value runs up to the next ';'
+//
+//	Returns false once there are no pairs left
+static inline bool __next_field(const char **p, const char *end, char *key, const char **val, const char **val_end) {
+	const char *q = *p;
+	while (q < end && (__is_blank(*q) || *q == ';' || *q == ':')) q++;
+	if (q >= end) return false;
+
+	*key = *q;
+	const char *v = q;
+	while (v < end && *v != '=') v++;
+	if (v >= end) return false;
+	v++;
+	while (v < end && __is_blank(*v)) v++;
+
+	const char *v_end = v;
+	while (v_end < end && *v_end != ';') v_end++;
+	*p = v_end;
+	while (v_end > v && __is_blank(v_end[-1])) v_end--;
+
+	*val = v;
+	*val_end = v_end;
+	return true;
+}
 
 int NYB_ParseLogLine(char *line, NYB_LogLineType *type, char data[26][32]) {
 	if (line == NULL) return 1;
@@ -9,44 +81,30 @@ int NYB_ParseLogLine(char *line, NYB_LogLineType *type, char data[26][32]) {
 	}
 
 	// Get text within >>> angle brackets <<<
-	char *start = strstr(line, ">>>");
+	const char *start = __find_marker(line, '>');
 	if (start == NULL) return 3;
 	start += 3;
 
-	char *end = strstr(start, "<<<");
+	const char *end = __find_marker(start, '<');
 	if (end == NULL) return 3;
-	end -= 1;
-
-	char str[128];
-	int len = (end-start);
-	strncpy(str, start,  128 * sizeof(char));
-	str[len] = '\0';
-
-	char *tok = strtok(str, " :;");
-	if (tok == NULL) return 4;
 
-	*type = NYBLOG_INVALID;
-	if (strncmp(tok, "INFO", 128 * sizeof(char)) == 0) *type = NYBLOG_INFO;
-	else if (strncmp(tok, "BLOCK-START", 128 * sizeof(char)) == 0) *type = NYBLOG_BLOCK_START;
-	else if (strncmp(tok, "BLOCK-END", 128 * sizeof(char)) == 0) *type = NYBLOG_BLOCK_END;
-	else if (strncmp(tok, "WARNING", 128 * sizeof(char)) == 0) *type = NYBLOG_WARNING;
-	else if (strncmp(tok, "ERROR", 128 * sizeof(char)) == 0) *type = NYBLOG_ERROR;
+	// Line type comes first
+	const char *p = start;
+	while (p < end && __is_type_separator(*p)) p++;
+	const char *word = p;
+	while (p < end && !__is_type_separator(*p)) p++;
+	if (p == word) return 4;
+	*type = __match_type(word, p - word);
 
-	tok = strtok(NULL, "=;");
-	while (tok != NULL) {
-		while(isspace(tok[0])) tok++;
-
-		char key = tok[0];
+	// Followed by `K=value;` pairs
+	char key;
+	const char *val, *val_end;
+	while (__next_field(&p, end, &key, &val, &val_end)) {
 		if (key < 'A' || key > 'Z') continue;
-
-		tok = strtok(NULL, "=;");
-		if (tok == NULL) continue;
-		while(isspace(tok[0])) tok++;
-		int len = strlen(tok);
-		strncpy(data[key - 'A'], tok, 32 * sizeof(char));
+		size_t len = val_end - val;
+		if (len > 31) len = 31;
+		memcpy(data[key - 'A'], val, len);
 		data[key - 'A'][len] = '\0';
-
-		tok = strtok(NULL, "=;");
 	}
 
 	return 0;
@@ -55,119 +113,778 @@ int NYB_ParseLogLine(char *line, NYB_LogLineType *type, char data[26][32]) {
 int NYB_ParseDataLine(char *line, uint8_t *offset, uint8_t data[16]) {
 	if (line == NULL) return 1;
 
-	char str[128];
-	int len = strlen(line);
-	strncpy(str, line,  128 * sizeof(char));
-	str[len] = '\0';
+	const uint8_t *p = (const uint8_t *) line;
+	while (*p == ' ' || *p == '\t') p++;
 
-	char *tok = strtok(str, " ");
-	if (tok == NULL) return 2;
-	if (strlen(tok) != 6 || tok[0] != '[' || tok[5] != ']') return 2;
-	*offset = strtol(tok+1, NULL, 16);
+	// Offset column looks like `[0xNN]`; every check stops at the null-terminator
+	if (p[0] != '[' || p[1] != '0' || (p[2] != 'x' && p[2] != 'X')) return 2;
+	uint8_t hi = __hex_values[p[3]];
+	if (hi == 0) return 2;
+	uint8_t lo = __hex_values[p[4]];
+	if (lo == 0 || p[5] != ']') return 2;
+	if (p[6] != '\0' && !__is_blank(p[6])) return 2;
+	*offset = ((hi - 1) << 4) | (lo - 1);
+	p += 6;
+
+	// Followed by up to 16 bytes in hex; anything missing is left blank
+	int i = 0;
+	for (; i<16; i++) {
+		while (*p == ' ' || *p == '\t') p++;
+
+		hi = __hex_values[p[0]];
+		if (hi == 0) break;
+		lo = __hex_values[p[1]];
+		if (lo == 0) {
+			data[i] = hi - 1;
+			p += 1;
+			continue;
+		}
 
-	int i=0;
-	tok = strtok(NULL, " ");
-	while (tok != NULL) {
-		data[i] = strtol(tok, NULL, 16);
-		tok = strtok(NULL, " ");
-		i++;
+		data[i] = ((hi - 1) << 4) | (lo - 1);
+		p += 2;
 	}
+	for (; i<16; i++) data[i] = 0x00;
 
 	return 0;
 }
 
-int NYB_ParseLogBlock(FILE *f_log, NYB_DataBlock *block) {
-	if (f_log == NULL || block == NULL) return 1;
-	block->block_status = 0x00;
-	block->track_num = 0x00;
+void __reset_block(NYB_DataBlock *block) {
+	memset(block, 0, sizeof(NYB_DataBlock));
 	block->sector_index = 0xFF;
-	block->err_code = 0x00;
-	block->parse_error = 0x00;
-
-	char line[128];
-	bool in_block = false;
-	char *lp = fgets(line, 128, f_log);
-	while (lp != NULL) {
-
-		// Try parsing as log-line
-		NYB_LogLineType type;
-
-		char data[26][32];
-		int err = NYB_ParseLogLine(line, &type, data);
-		if (err == 0 && type != NYBLOG_INVALID) {
-			switch (type) {
-				case NYBLOG_INFO: {
-					if (g_verbose_log) printf(" - Info Message in log file: %s\n", data['M' - 'A']);
-				}; break;
-
-				case NYBLOG_BLOCK_START: {
-					block->track_num = strtol(data['T' - 'A'], NULL, 10);
-					block->sector_index = strtol(data['S' - 'A'], NULL, 10);
-					in_block = true;
-				}; break;
-
-				case NYBLOG_BLOCK_END: {
-					block->err_code = strtol(data['E' - 'A'], NULL, 10);
-					block->checksum = strtol(data['C' - 'A'], NULL, 16);
-					return 0;
-				}; break;
-
-				case NYBLOG_WARNING: {
-					block->parse_error = strtol(data['E' - 'A'], NULL, 10);
-					return 0;
-				}; break;
-
-				case NYBLOG_ERROR: {
-					block->parse_error = strtol(data['E' - 'A'], NULL, 10);
-					return 0;
-				}; break;
-
-				case NYBLOG_INVALID: { printf("IMPOSSIBLE STATE ACHIEVED! CONGLATURATIONS YOU WIN!!\n"); };
+}
+
+//	Moves the unread part of the buffer to the front and reads more data after it
+//
+//	Returns the number of bytes read, 0 at the end of the file or -1 on failure
+ssize_t __refill(NYB_LogReader *reader) {
+	if (reader->buf_pos > 0) {
+		size_t avail = reader->buf_len - reader->buf_pos;
+		memmove(reader->buf, reader->buf + reader->buf_pos, avail);
+		reader->offset += reader->buf_pos;
+		reader->buf_len = avail;
+		reader->buf_pos = 0;
+	}
+	if (reader->at_eof || reader->buf_len >= NYBLOG_READ_BUFFER_SIZE) return 0;
+
+	ssize_t n;
+	do {
+		void *dst = reader->buf + reader->buf_len;
+		size_t len = NYBLOG_READ_BUFFER_SIZE - reader->buf_len;
+		if (reader->read_fn != NULL) n = reader->read_fn(reader->source, dst, len);
+		else n = read(reader->fd, dst, len);
+	} while (n < 0 && errno == EINTR);
+	if (n < 0) return -1;
+
+	if (n == 0) reader->at_eof = true;
+	reader->buf_len += n;
+	return n;
+}
+
+//	Copies the next bytes from the file; a NULL destination skips them instead
+//
+//	Returns the number of bytes copied (less at the end of the file) or -1 on failure
+ssize_t __read_exact(NYB_LogReader *reader, void *dst, size_t len) {
+	size_t done = 0;
+	while (done < len) {
+		size_t avail = reader->buf_len - reader->buf_pos;
+		if (avail == 0) {
+			ssize_t n = __refill(reader);
+			if (n < 0) return -1;
+			if (n == 0) break;
+			continue;
+		}
+
+		size_t chunk = len - done;
+		if (chunk > avail) chunk = avail;
+		if (dst != NULL) memcpy((uint8_t *) dst + done, reader->buf + reader->buf_pos, chunk);
+		reader->buf_pos += chunk;
+		done += chunk;
+	}
+
+	return done;
+}
+
+//	Gets the next line from the read buffer, refilling it from the file as needed
+//
+//	The newline is replaced with a null-terminator in place.
+//	Returns NULL once there are no lines left or reading failed
+char *__next_line(NYB_LogReader *reader, long *line_offset, int *err) {
+	while (true) {
+		char *start = reader->buf + reader->buf_pos;
+		size_t avail = reader->buf_len - reader->buf_pos;
+		*line_offset = reader->offset + reader->buf_pos;
+
+		char *nl = memchr(start, '\n', avail);
+		if (nl != NULL) {
+			*nl = '\0';
+			reader->buf_pos += (nl - start) + 1;
+			return start;
+		}
+
+		if (reader->at_eof) {
+			if (avail == 0) return NULL;
+
+			// Last line has no newline
+			reader->buf[reader->buf_len] = '\0';
+			reader->buf_pos = reader->buf_len;
+			return start;
+		}
+
+		ssize_t n = __refill(reader);
+		if (n < 0) {
+			*err = 3;
+			return NULL;
+		}
+
+		// Lines that don't fit into the buffer are split
+		if (n == 0 && !reader->at_eof) {
+			reader->buf[reader->buf_len] = '\0';
+			reader->buf_pos = reader->buf_len;
+			return reader->buf;
+		}
+	}
+}
+
+//	Reads records from a binary log until it finds a block
+//
+//	Returns the same codes as NYB_LogReader_Next
+int __next_record(NYB_LogReader *reader, NYB_DataBlock *block) {
+	// The attempt table comes straight after the records
+	if (reader->offset + (long) reader->buf_pos >= reader->records_end) return 2;
+
+	NYB_BinRecord record;
+	ssize_t n = __read_exact(reader, &record, sizeof(NYB_BinRecord));
+	while (n == sizeof(NYB_BinRecord)) {
+		uint32_t payload = record.length;
+
+		if (record.type == NYBLOG_INFO) {
+			char message[NYBBIN_MAX_MESSAGE];
+			uint32_t len = payload;
+			if (len > NYBBIN_MAX_MESSAGE - 1) len = NYBBIN_MAX_MESSAGE - 1;
+			if (__read_exact(reader, message, len) != len) return 2;
+			message[len] = '\0';
+			payload -= len;
+
+			if (reader->info_callback != NULL) reader->info_callback(message, reader->info_user_data);
+		} else {
+			__reset_block(block);
+			block->block_status = 0x01;
+			block->track_num = record.track_num;
+			block->sector_index = record.sector_index;
+			block->err_code = record.err_code;
+			block->checksum = record.checksum;
+			block->parse_error = record.parse_error;
+			reader->end_type = record.type;
+
+			uint32_t len = payload;
+			if (len > BLOCK_SIZE) len = BLOCK_SIZE;
+			if (__read_exact(reader, block->data, len) != len) return 2;
+			payload -= len;
+
+			if (__read_exact(reader, NULL, payload) != payload) return 2;
+			return 0;
+		}
+
+		if (__read_exact(reader, NULL, payload) != payload) return 2;
+		if (reader->offset + (long) reader->buf_pos >= reader->records_end) return 2;
+		n = __read_exact(reader, &record, sizeof(NYB_BinRecord));
+	}
+	if (n < 0) return 3;
+
+	// A record cut off by the end of the file is ignored
+	return 2;
+}
+
+//	Gets the full text of an info line's message, which can be longer than a normal value
+void __get_message(const char *line, char *buf, size_t bufsz) {
+	buf[0] = '\0';
+
+	const char *start = __find_marker(line, '>');
+	if (start == NULL) return;
+	start += 3;
+	const char *end = __find_marker(start, '<');
+	if (end == NULL) end = start + strlen(start);
+
+	// The message is the `M` field, found the same way NYB_ParseLogLine finds
+	// keys; it runs up to the end marker, since it can contain ';' itself
+	const char *p = start;
+	while (p < end && __is_type_separator(*p)) p++;
+	while (p < end && !__is_type_separator(*p)) p++;
+
+	char key;
+	const char *val, *val_end;
+	do {
+		if (!__next_field(&p, end, &key, &val, &val_end)) return;
+	} while (key != 'M');
+	start = val;
+	while (end > start && __is_blank(end[-1])) end--;
+
+	size_t len = end - start;
+	if (len > bufsz - 1) len = bufsz - 1;
+	memcpy(buf, start, len);
+	buf[len] = '\0';
+}
+
+//	Feeds a single line into the block currently being read
+//
+//	Returns true once a block is finished and has been copied to `block`
+bool __parse_line(NYB_LogReader *reader, char *line, long line_offset, NYB_DataBlock *block) {
+	NYB_DataBlock *curr = &reader->block;
+
+	// Data lines are by far the most common, so check for those first
+	const char *first = line;
+	while (*first == ' ' || *first == '\t') first++;
+	if (*first == '[') {
+		if (!reader->in_block) return false;
+
+		uint8_t offset = 0x00;
+		uint8_t bytes[16];
+		int err = NYB_ParseDataLine(line, &offset, bytes);
+		if (err == 0 && offset <= BLOCK_SIZE - 16) {
+			memcpy(curr->data + offset, bytes, 16);
+		}
+		return false;
+	}
+
+	// Try parsing as log-line
+	NYB_LogLineType type;
+	char data[26][32];
+	int err = NYB_ParseLogLine(line, &type, data);
+	if (err == 0 && type != NYBLOG_INVALID) {
+		switch (type) {
+			case NYBLOG_INFO: {
+				char message[NYBBIN_MAX_MESSAGE];
+				__get_message(line, message, NYBBIN_MAX_MESSAGE);
+				if (reader->info_callback != NULL) reader->info_callback(message, reader->info_user_data);
+			}; break;
+
+			case NYBLOG_BLOCK_START: {
+				// The previous block never ended; pass on what there is of it
+				bool interrupted = reader->in_block;
+				if (interrupted) {
+					*block = *curr;
+					block->parse_error = NYBLOG_ERR_TRUNCATED;
+					reader->end_type = NYBLOG_BLOCK_START;
+				}
+
+				__reset_block(curr);
+				curr->block_status = 0x01;
+				curr->track_num = strtol(data['T' - 'A'], NULL, 10);
+				curr->sector_index = strtol(data['S' - 'A'], NULL, 10);
+				reader->in_block = true;
+				reader->block_offset = line_offset;
+				if (interrupted) return true;
+			}; break;
+
+			case NYBLOG_BLOCK_END: {
+				curr->err_code = strtol(data['E' - 'A'], NULL, 10);
+				curr->checksum = strtol(data['C' - 'A'], NULL, 16);
+				*block = *curr;
+				reader->end_type = type;
+				__reset_block(curr);
+				reader->in_block = false;
+				return true;
+			}; break;
+
+			case NYBLOG_WARNING:
+			case NYBLOG_ERROR: {
+				curr->parse_error = strtol(data['E' - 'A'], NULL, 10);
+				*block = *curr;
+				reader->end_type = type;
+				__reset_block(curr);
+				reader->in_block = false;
+				return true;
+			}; break;
+
+			case NYBLOG_INVALID: break;
+		}
+	}
+
+	return false;
+}
+
+void __init_reader(NYB_LogReader *reader, int fd, char *buf) {
+	reader->fd = fd;
+	reader->read_fn = NULL;
+	reader->source = NULL;
+	reader->buf = buf;
+	reader->owns_buf = true;
+	reader->buf_len = 0;
+	reader->buf_pos = 0;
+	reader->offset = 0;
+	reader->at_eof = false;
+	reader->is_binary = false;
+	reader->records_end = 0;
+	reader->in_block = false;
+	reader->block_offset = 0;
+	__reset_block(&reader->block);
+	reader->end_type = NYBLOG_INVALID;
+	reader->info_callback = NULL;
+	reader->info_user_data = NULL;
+}
+
+//	Sets up a reader for a piece of a text-log that's already in memory
+//
+//	The reader doesn't own the memory; one byte past the end has to be writable
+//	in case the last line isn't terminated
+void __open_memory(NYB_LogReader *reader, char *buf, size_t len, long offset) {
+	__init_reader(reader, -1, buf);
+	reader->owns_buf = false;
+	reader->buf_len = len;
+	reader->offset = offset;
+	reader->block_offset = offset;
+	reader->at_eof = true;
+}
+
+//	Checks whether a newly opened log is a binary log
+//
+//	Returns the same codes as NYB_LogReader_Open
+int __detect_format(NYB_LogReader *reader) {
+	// Binary logs start with a header; skip straight to the records
+	NYB_BinHeader header;
+	ssize_t n = __read_exact(reader, &header, sizeof(uint32_t));
+	if (n == sizeof(uint32_t) && header.magic == NYBBIN_MAGIC) {
+		n += __read_exact(reader, (uint8_t *) &header + n, sizeof(NYB_BinHeader) - n);
+		if (n != sizeof(NYB_BinHeader) || header.version != NYBBIN_VERSION) {
+			NYB_LogReader_Close(reader);
+			return 2;
+		}
+
+		reader->is_binary = true;
+		reader->records_end = header.attempts_offset;
+		__read_exact(reader, NULL, header.records_offset - sizeof(NYB_BinHeader));
+	} else {
+		reader->buf_pos = 0;
+	}
+
+	return 0;
+}
+
+int NYB_LogReader_Open(NYB_LogReader *reader, const char *filename) {
+	if (reader == NULL || filename == NULL) return 1;
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0) return 2;
+
+	// One extra byte so the last line can always be terminated
+	char *buf = malloc(NYBLOG_READ_BUFFER_SIZE + 1);
+	if (buf == NULL) {
+		close(fd);
+		return 3;
+	}
+	__init_reader(reader, fd, buf);
+
+	return __detect_format(reader);
+}
+
+int NYB_LogReader_OpenSource(NYB_LogReader *reader, NYB_ReadFunction read_fn, void *source) {
+	if (reader == NULL || read_fn == NULL) return 1;
+
+	char *buf = malloc(NYBLOG_READ_BUFFER_SIZE + 1);
+	if (buf == NULL) return 3;
+	__init_reader(reader, -1, buf);
+	reader->read_fn = read_fn;
+	reader->source = source;
+
+	return __detect_format(reader);
+}
+
+int NYB_LogReader_Next(NYB_LogReader *reader, NYB_DataBlock *block) {
+	if (reader == NULL || block == NULL) return 1;
+	if (reader->is_binary) return __next_record(reader, block);
+
+	int err = 0;
+	long line_offset;
+	char *line = __next_line(reader, &line_offset, &err);
+	while (line != NULL) {
+		if (__parse_line(reader, line, line_offset, block)) return 0;
+		line = __next_line(reader, &line_offset, &err);
+	}
+	if (err != 0) return err;
+
+	// The log ended part of the way through a block
+	if (reader->in_block) {
+		*block = reader->block;
+		block->parse_error = NYBLOG_ERR_TRUNCATED;
+		reader->end_type = NYBLOG_INVALID;
+		__reset_block(&reader->block);
+		reader->in_block = false;
+		return 0;
+	}
+
+	return 2;
+}
+
+int NYB_LogReader_ForEach(NYB_LogReader *reader, NYB_BlockCallback callback, void *user_data) {
+	if (reader == NULL || callback == NULL) return -1;
+
+	int count = 0;
+	NYB_DataBlock block;
+	int err = NYB_LogReader_Next(reader, &block);
+	while (err == 0) {
+		count++;
+		if (callback(&block, user_data) != 0) return count;
+		err = NYB_LogReader_Next(reader, &block);
+	}
+	if (err != 2) return -1;
+
+	return count;
+}
+
+void NYB_LogReader_SetInfoCallback(NYB_LogReader *reader, NYB_InfoCallback callback, void *user_data) {
+	if (reader == NULL) return;
+
+	reader->info_callback = callback;
+	reader->info_user_data = user_data;
+}
+
+long NYB_LogReader_Tell(NYB_LogReader *reader) {
+	if (reader == NULL) return -1;
+
+	// Unfinished blocks are read again from their start
+	if (reader->in_block) return reader->block_offset;
+	return reader->offset + reader->buf_pos;
+}
+
+int NYB_LogReader_Seek(NYB_LogReader *reader, long offset) {
+	if (reader == NULL || reader->fd < 0) return 1;
+
+	off_t pos = lseek(reader->fd, offset, SEEK_SET);
+	if (pos < 0) return 2;
+
+	reader->buf_len = 0;
+	reader->buf_pos = 0;
+	reader->offset = pos;
+	reader->at_eof = false;
+	reader->in_block = false;
+	reader->block_offset = pos;
+	__reset_block(&reader->block);
+
+	return 0;
+}
+
+void NYB_LogReader_Close(NYB_LogReader *reader) {
+	if (reader == NULL) return;
+
+	// Readers of memory don't own their buffer
+	if (reader->fd >= 0) close(reader->fd);
+	if (reader->owns_buf) free(reader->buf);
+	reader->fd = -1;
+	reader->buf = NULL;
+}
+
+//	An info message, and how many of the chunk's blocks came before it
+typedef struct {
+	size_t before;
+	char text[NYBBIN_MAX_MESSAGE];
+} __chunk_message;
+
+//	A piece of a text-log parsed by one thread, and everything found in it
+typedef struct {
+	char *start;
+	size_t len;
+	long offset;		// File offset of the start of the chunk
+
+	NYB_DataBlock *blocks;
+	size_t num_blocks;
+	size_t max_blocks;
+
+	__chunk_message *messages;
+	size_t num_messages;
+	size_t max_messages;
+
+	bool failed;
+} __chunk;
+
+//	Checks whether a line of a log (without its newline) starts a block
+bool __is_block_start(const char *line, size_t len) {
+	const char *p = line;
+	while (p < line + len && (*p == ' ' || *p == '\t')) p++;
+	if (p < line + len && *p == '[') return false;
+
+	// Everything that matters is near the start of the line
+	char buf[128];
+	if (len > sizeof(buf) - 1) len = sizeof(buf) - 1;
+	memcpy(buf, line, len);
+	buf[len] = '\0';
+
+	NYB_LogLineType type;
+	char data[26][32];
+	return NYB_ParseLogLine(buf, &type, data) == 0 && type == NYBLOG_BLOCK_START;
+}
+
+//	Finds the first line starting a block at or after `from`
+//
+//	Returns `len` if there isn't one
+size_t __next_block_start(const char *buf, size_t len, size_t from) {
+	size_t line = from;
+	if (line > 0 && buf[line - 1] != '\n') {
+		const char *nl = memchr(buf + line, '\n', len - line);
+		if (nl == NULL) return len;
+		line = nl - buf + 1;
+	}
+
+	while (line < len) {
+		const char *nl = memchr(buf + line, '\n', len - line);
+		if (nl == NULL) return len;
+
+		size_t line_end = nl - buf;
+		if (__is_block_start(buf + line, line_end - line)) return line;
+		line = line_end + 1;
+	}
+
+	return len;
+}
+
+//	Finds the last complete line starting a block
+//
+//	Returns 0 if there isn't one after the very start
+size_t __last_block_start(const char *buf, size_t len) {
+	size_t line_end = len;
+	while (line_end > 0 && buf[line_end - 1] != '\n') line_end--;
+
+	// `line_end` is just past a newline; look at the line before it
+	while (line_end > 0) {
+		size_t nl = line_end - 1;
+		size_t line = nl;
+		while (line > 0 && buf[line - 1] != '\n') line--;
+
+		if (line > 0 && __is_block_start(buf + line, nl - line)) return line;
+		line_end = line;
+	}
+
+	return 0;
+}
+
+int __collect_block(NYB_DataBlock *block, void *user_data) {
+	__chunk *chunk = user_data;
+
+	if (chunk->num_blocks >= chunk->max_blocks) {
+		size_t max = (chunk->max_blocks == 0) ? 1024 : chunk->max_blocks * 2;
+		NYB_DataBlock *blocks = realloc(chunk->blocks, max * sizeof(NYB_DataBlock));
+		if (blocks == NULL) {
+			chunk->failed = true;
+			return 1;
+		}
+		chunk->blocks = blocks;
+		chunk->max_blocks = max;
+	}
+
+	chunk->blocks[chunk->num_blocks++] = *block;
+	return 0;
+}
+
+void __collect_message(const char *message, void *user_data) {
+	__chunk *chunk = user_data;
+	if (chunk->failed) return;
+
+	if (chunk->num_messages >= chunk->max_messages) {
+		size_t max = (chunk->max_messages == 0) ? 16 : chunk->max_messages * 2;
+		__chunk_message *messages = realloc(chunk->messages, max * sizeof(__chunk_message));
+		if (messages == NULL) {
+			chunk->failed = true;
+			return;
+		}
+		chunk->messages = messages;
+		chunk->max_messages = max;
+	}
+
+	__chunk_message *m = &chunk->messages[chunk->num_messages++];
+	m->before = chunk->num_blocks;
+	strncpy(m->text, message, NYBBIN_MAX_MESSAGE - 1);
+	m->text[NYBBIN_MAX_MESSAGE - 1] = '\0';
+}
+
+void *__parse_chunk(void *arg) {
+	TRC_SCOPE("NYB_ParseChunk");
+	__chunk *chunk = arg;
+	chunk->num_blocks = 0;
+	chunk->num_messages = 0;
+	chunk->failed = false;
+
+	NYB_LogReader reader;
+	__open_memory(&reader, chunk->start, chunk->len, chunk->offset);
+	NYB_LogReader_SetInfoCallback(&reader, __collect_message, chunk);
+
+	if (NYB_LogReader_ForEach(&reader, __collect_block, chunk) < 0) chunk->failed = true;
+	NYB_LogReader_Close(&reader);
+	return NULL;
+}
+
+//	Passes on everything found in a chunk, in the order it was read
+//
+//	Returns false once the callback asks to stop
+bool __deliver_chunk(__chunk *chunk, NYB_BlockCallback callback, NYB_InfoCallback info_callback, void *user_data, int *count) {
+	size_t m = 0;
+	for (size_t b=0; b<=chunk->num_blocks; b++) {
+		for (; m<chunk->num_messages && chunk->messages[m].before == b; m++) {
+			if (info_callback != NULL) info_callback(chunk->messages[m].text, user_data);
+		}
+		if (b == chunk->num_blocks) break;
+
+		(*count)++;
+		if (callback(&chunk->blocks[b], user_data) != 0) return false;
+	}
+
+	return true;
+}
+
+int NYB_ParseLogParallel(const char *filename, int num_threads, NYB_BlockCallback callback, NYB_InfoCallback info_callback, void *user_data) {
+	TRC_SCOPE_DETAIL("NYB_ParseLogParallel", filename);
+	if (filename == NULL || callback == NULL) return -1;
+
+	NYB_LogReader reader;
+	if (NYB_LogReader_Open(&reader, filename) != 0) return -1;
+	NYB_LogReader_SetInfoCallback(&reader, info_callback, user_data);
+
+	// Only regular text files can be read in pieces
+	struct stat st;
+	if (reader.is_binary || fstat(reader.fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+		int count = NYB_LogReader_ForEach(&reader, callback, user_data);
+		NYB_LogReader_Close(&reader);
+		return count;
+	}
+
+	if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads > NYBLOG_MAX_THREADS) num_threads = NYBLOG_MAX_THREADS;
+	if (num_threads > st.st_size / NYBLOG_CHUNK_SIZE + 1) num_threads = st.st_size / NYBLOG_CHUNK_SIZE + 1;
+	if (num_threads < 1) num_threads = 1;
+
+	// A window of the file is read at once and split up between the threads
+	size_t window_size = num_threads * NYBLOG_CHUNK_SIZE;
+	char *window = malloc(window_size + 1);
+	__chunk *chunks = calloc(num_threads, sizeof(__chunk));
+	pthread_t *threads = malloc(num_threads * sizeof(pthread_t));
+	if (window == NULL || chunks == NULL || threads == NULL) {
+		free(window);
+		free(chunks);
+		free(threads);
+		NYB_LogReader_Close(&reader);
+		return -1;
+	}
+
+	int count = 0;
+	bool failed = false;
+	bool stopped = false;
+	size_t len = 0;
+	long offset = 0;
+	bool at_eof = false;
+	while (!failed && !stopped) {
+		while (len < window_size && !at_eof) {
+			ssize_t n = pread(reader.fd, window + len, window_size - len, offset + len);
+			if (n < 0 && errno == EINTR) continue;
+			if (n < 0) {
+				failed = true;
+				break;
+			}
+			if (n == 0) at_eof = true;
+			len += n;
+		}
+		if (failed || len == 0) break;
+
+		// Leave the last block for the next window, unless it's the end of the log
+		size_t end = at_eof ? len : __last_block_start(window, len);
+		if (end == 0) {
+			// Not a single block fits into the window; give up on splitting the log
+			if (NYB_LogReader_Seek(&reader, offset) != 0) {
+				failed = true;
+				break;
 			}
+			int n = NYB_LogReader_ForEach(&reader, callback, user_data);
+			if (n < 0) failed = true;
+			else count += n;
+			break;
+		}
+
+		// Chunks start at a block, so every thread starts out in the same state
+		// the sequential reader would be in at that line
+		size_t start = 0;
+		int num_chunks = 0;
+		for (int i=0; i<num_threads && start < end; i++) {
+			size_t next = end;
+			if (i < num_threads - 1) {
+				size_t target = end / num_threads * (i + 1);
+				next = __next_block_start(window, end, (target > start) ? target : start + 1);
+			}
+
+			chunks[i].start = window + start;
+			chunks[i].len = next - start;
+			chunks[i].offset = offset + start;
+			num_chunks++;
+			start = next;
+		}
+
+		// The calling thread takes the first chunk itself
+		int num_started = 1;
+		for (; num_started<num_chunks; num_started++) {
+			if (pthread_create(&threads[num_started], NULL, __parse_chunk, &chunks[num_started]) != 0) break;
 		}
+		__parse_chunk(&chunks[0]);
+		for (int i=1; i<num_started; i++) pthread_join(threads[i], NULL);
+		for (int i=num_started; i<num_chunks; i++) __parse_chunk(&chunks[i]);
 
-		// Try parsing data-line
-		if (in_block) {
-			uint8_t offset = 0x00;
-			uint8_t data[16];
-			err = NYB_ParseDataLine(line, &offset, data);
-			if (err == 0) {
-				memcpy(block->data + offset, data, 16);
+		for (int i=0; i<num_chunks && !stopped; i++) {
+			if (chunks[i].failed) {
+				failed = true;
+				break;
 			}
+			stopped = !__deliver_chunk(&chunks[i], callback, info_callback, user_data, &count);
 		}
+		if (at_eof) break;
 
-		lp = fgets(line, 128, f_log);
+		memmove(window, window + end, len - end);
+		offset += end;
+		len -= end;
 	}
 
-	return 0;
+	for (int i=0; i<num_threads; i++) {
+		free(chunks[i].blocks);
+		free(chunks[i].messages);
+	}
+	free(chunks);
+	free(threads);
+	free(window);
+	NYB_LogReader_Close(&reader);
+
+	if (failed) return -1;
+	return count;
 }
 
 int NYB_ParseLog(const char *filename, NYB_DataBlock *block_buf, int buf_len, long *data_offset) {
+	TRC_SCOPE_DETAIL("NYB_ParseLog", filename);
 	if (filename == NULL || block_buf == NULL) return -1;
 	if (buf_len < 1) return -1;
 
-	FILE *f_log = fopen(filename, "r+b");
-	if (f_log == NULL) return -1;
+	NYB_LogReader reader;
+	if (NYB_LogReader_Open(&reader, filename) != 0) return -1;
 
-	if (data_offset != NULL) fseek(f_log, *data_offset, SEEK_SET);
-	fread(NULL, 0, 0, f_log);
-	if (feof(f_log)) return 0;
+	// Binary logs have already skipped their header
+	if (data_offset != NULL && *data_offset > NYB_LogReader_Tell(&reader)) {
+		if (NYB_LogReader_Seek(&reader, *data_offset) != 0) {
+			NYB_LogReader_Close(&reader);
+			return -1;
+		}
+	}
 
 	int count = 0;
-	for (int i=0; i<buf_len; i++) {
-		int err = NYB_ParseLogBlock(f_log, &block_buf[i]);
-		if (err != 0) return count;
-		if (feof(f_log)) return count;
+	while (count < buf_len) {
+		int err = NYB_LogReader_Next(&reader, &block_buf[count]);
+		if (err == 3) {
+			NYB_LogReader_Close(&reader);
+			return -1;
+		}
+		if (err != 0) break;
 		count++;
 	}
 
-	if (data_offset != NULL) *data_offset = ftell(f_log);
+	if (data_offset != NULL) *data_offset = NYB_LogReader_Tell(&reader);
 
-	fclose(f_log);
+	NYB_LogReader_Close(&reader);
 	return count;
 }
 
 int NYB_Meta_ReadBlock(FILE *f_meta, NYB_DataBlock *block) {
+	TRC_SCOPE("NYB_Meta_ReadBlock");
 	if (f_meta == NULL || block == NULL) return 1;
 
 	//	Parse File Header
@@ -176,121 +893,560 @@ int NYB_Meta_ReadBlock(FILE *f_meta, NYB_DataBlock *block) {
 	size_t r = fread(header, sizeof(uint32_t), 4, f_meta);
 	if (r < 4) return 2;
 	if (header[0] != NYBLOG_BIN_MAGIC) return 2;
+	if (header[2] > NYBLOG_META_VERSION) return 2;
 
 	long offs_data = header[1];
 
 	//	Find and read selected block
 	DSK_Position blockpos = { block->track_num, block->sector_index };
 	int block_index = DSK_PositionToIndex(blockpos);
-	if (block_index < 0) {
-		if (g_verbose_log) printf("Error: Failed to read sector metadata from file; Invalid position [% i/% i]\n", blockpos.track, blockpos.sector);
+	if (block_index < 0) return 2;
+
+	if (header[2] == 0) {
+		fseek(f_meta, offs_data + (block_index * sizeof(NYB_DataBlock)), SEEK_SET);
+		int read = fread(block, sizeof(NYB_DataBlock), 1, f_meta);
+		if (read != 1) {
+			return 3;
+		}
+
+		return 0;
+	}
+
+	NYB_MetaRecord record;
+	fseek(f_meta, offs_data + (block_index * sizeof(NYB_MetaRecord)), SEEK_SET);
+	if (fread(&record, sizeof(NYB_MetaRecord), 1, f_meta) != 1) return 3;
+
+	__reset_block(block);
+	block->track_num = blockpos.track;
+	block->sector_index = blockpos.sector;
+	block->block_status = record.block_status;
+	block->err_code = record.err_code;
+	block->checksum = record.checksum;
+	block->parse_error = record.parse_error;
+	if (record.block_status == 0x00) return 0;
+
+	if (record.data_index == 0) {
+		block->block_status |= NYBLOG_STATUS_IN_IMAGE;
+		return 0;
+	}
+
+	long offs_table = offs_data + NYBLOG_SECTOR_COUNT * sizeof(NYB_MetaRecord);
+	fseek(f_meta, offs_table + (record.data_index - 1) * BLOCK_SIZE, SEEK_SET);
+	if (fread(block->data, sizeof(uint8_t), BLOCK_SIZE, f_meta) != BLOCK_SIZE) return 3;
+
+	return 0;
+}
+
+//	Header of an import journal, followed by its records
+typedef struct {
+	uint32_t magic;
+	uint32_t version;
+	char source[NYBLOG_JOURNAL_SOURCE_SIZE];	// Which log is being imported
+} __journal_header;
+
+uint32_t __journal_checksum(NYB_JournalRecord *record) {
+	const uint8_t *p = (const uint8_t *) record;
+	uint32_t hash = 0x811C9DC5;
+	for (size_t i=0; i<offsetof(NYB_JournalRecord, checksum); i++) {
+		hash ^= p[i];
+		hash *= 0x01000193;
+	}
+	return hash;
+}
+
+//	Starts a journal over with just its header
+int __journal_create(NYB_Journal *journal, const char *source) {
+	journal->f_journal = fopen(journal->filename, "w+b");
+	if (journal->f_journal == NULL) return 2;
+
+	__journal_header header;
+	memset(&header, 0, sizeof(__journal_header));
+	header.magic = NYBLOG_JOURNAL_MAGIC;
+	header.version = NYBLOG_JOURNAL_VERSION;
+	strncpy(header.source, source, NYBLOG_JOURNAL_SOURCE_SIZE - 1);
+
+	size_t w = fwrite(&header, sizeof(__journal_header), 1, journal->f_journal);
+	if (w != 1 || fflush(journal->f_journal) != 0 || fdatasync(fileno(journal->f_journal)) != 0) {
+		NYB_Journal_Close(journal, true);
 		return 2;
 	}
 
-	fseek(f_meta, offs_data + (block_index * sizeof(NYB_DataBlock)), SEEK_SET);
-	int read = fread(block, sizeof(NYB_DataBlock), 1, f_meta);
-	if (read != 1) {
-		//if (g_verbose_log) printf("Error: Failed to read sector metadata from file; Past end of file; %i\n", read);
-		return 3;
+	return 0;
+}
+
+int NYB_Journal_Open(NYB_Journal *journal, const char *disk_filename, const char *source, NYB_BlockCallback replay, void *user_data) {
+	if (journal == NULL || disk_filename == NULL || source == NULL) return 1;
+
+	journal->f_journal = NULL;
+	journal->sequence = 0;
+	journal->num_replayed = 0;
+	journal->was_discarded = false;
+	journal->pending = 0;
+
+	int n = snprintf(journal->filename, sizeof(journal->filename), "%s" NYBLOG_JOURNAL_EXTENSION, disk_filename);
+	if (n < 0 || n >= (int) sizeof(journal->filename)) return 2;
+
+	FILE *f_journal = fopen(journal->filename, "r+b");
+	if (f_journal == NULL) return __journal_create(journal, source);
+
+	// Only pick up an import of the same log
+	__journal_header header;
+	size_t r = fread(&header, sizeof(__journal_header), 1, f_journal);
+	header.source[NYBLOG_JOURNAL_SOURCE_SIZE - 1] = '\0';
+	bool same_source = r == 1
+		&& header.magic == NYBLOG_JOURNAL_MAGIC
+		&& header.version == NYBLOG_JOURNAL_VERSION
+		&& strncmp(header.source, source, NYBLOG_JOURNAL_SOURCE_SIZE - 1) == 0;
+	if (!same_source) {
+		journal->was_discarded = true;
+		fclose(f_journal);
+		return __journal_create(journal, source);
 	}
 
+	// Replay everything up to the first record that didn't make it to disk whole
+	NYB_JournalRecord record;
+	long valid_end = sizeof(__journal_header);
+	while (fread(&record, sizeof(NYB_JournalRecord), 1, f_journal) == 1) {
+		if (record.sequence != journal->sequence) break;
+		if (record.checksum != __journal_checksum(&record)) break;
+
+		journal->sequence++;
+		journal->num_replayed++;
+		valid_end += sizeof(NYB_JournalRecord);
+		if (replay != NULL) replay(&record.block, user_data);
+	}
+
+	// Drop any torn tail, so new records follow straight after the valid ones
+	if (ftruncate(fileno(f_journal), valid_end) != 0 || fseek(f_journal, valid_end, SEEK_SET) != 0) {
+		fclose(f_journal);
+		return 2;
+	}
+
+	journal->f_journal = f_journal;
 	return 0;
 }
 
-int NYB_Meta_WriteBlock(FILE *f_meta, NYB_DataBlock *block) {
-	if (f_meta == NULL || block == NULL) return 1;
+int NYB_Journal_Checkpoint(NYB_Journal *journal) {
+	if (journal == NULL || journal->f_journal == NULL) return 1;
+
+	if (fflush(journal->f_journal) != 0) return 2;
+	if (ftruncate(fileno(journal->f_journal), sizeof(__journal_header)) != 0) return 2;
+	if (fseek(journal->f_journal, sizeof(__journal_header), SEEK_SET) != 0) return 2;
+	if (fdatasync(fileno(journal->f_journal)) != 0) return 2;
+
+	journal->sequence = 0;
+	journal->pending = 0;
+	return 0;
+}
+
+int NYB_Journal_Append(NYB_Journal *journal, NYB_DataBlock *block) {
+	if (journal == NULL || journal->f_journal == NULL || block == NULL) return 1;
+
+	NYB_JournalRecord record;
+	memset(&record, 0, sizeof(NYB_JournalRecord));
+	record.sequence = journal->sequence;
+	record.block = *block;
+	record.checksum = __journal_checksum(&record);
+
+	if (fwrite(&record, sizeof(NYB_JournalRecord), 1, journal->f_journal) != 1) return 2;
+	journal->sequence++;
+
+	if (++journal->pending >= NYBLOG_JOURNAL_BATCH) {
+		journal->pending = 0;
+		if (fflush(journal->f_journal) != 0) return 2;
+		if (fdatasync(fileno(journal->f_journal)) != 0) return 2;
+	}
+
+	return 0;
+}
+
+void NYB_Journal_Close(NYB_Journal *journal, bool discard) {
+	if (journal == NULL || journal->f_journal == NULL) return;
+
+	fclose(journal->f_journal);
+	journal->f_journal = NULL;
+	if (discard) remove(journal->filename);
+}
+
+//	Checks whether a block should be written to an image, logging why not to `f_log`
+//
+//	Returns 0 if it should, or 2 if it should be skipped
+int __check_block(NYB_DataBlock *block, bool ignore_errors, FILE *f_log) {
+	uint16_t chk = DSK_Checksum(block->data);
+	DSK_Position pos = { block->track_num, block->sector_index };
+	if (f_log != NULL) {
+		fprintf(f_log, "  [% 3i/% 3i] ", block->track_num, block->sector_index);
+		if (!ignore_errors && block->err_code != 0) {
+			fprintf(f_log, "Skipping due to disk-read error (code %i)\n", block->err_code);
+		} else if (!ignore_errors && block->checksum != chk) {
+			fprintf(f_log, "Skipping due to checksum mismatch (0x%04X =/= 0x%04X)\n", block->checksum, chk);
+		} else if (!DSK_IsPositionValid(pos)) {
+			fprintf(f_log, "Skipping due to invalid block position\n");
+		} else if (ignore_errors) {
+			fprintf(f_log, "Ignoring error...\n");
+		}
+	}
+
+	if (!ignore_errors) {
+		if (block->err_code != 0) return 2;
+		if (block->checksum != chk) return 2;
+	}
+	if (!DSK_IsPositionValid(pos)) return 2;
+
+	return 0;
+}
+
+void NYB_Recon_Init(NYB_Recon *recon) {
+	if (recon == NULL) return;
+
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int sc = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<sc; s++) {
+			int index = DSK_PositionToIndex((DSK_Position){ t, s });
+			__reset_block(&recon->blocks[index]);
+			recon->blocks[index].track_num = t;
+			recon->blocks[index].sector_index = s;
+		}
+	}
+	memset(recon->attempts, 0, sizeof(recon->attempts));
+	memset(recon->added, 0, sizeof(recon->added));
+}
+
+int NYB_Recon_CheckImage(FILE *f_meta, const uint8_t *image) {
+	if (f_meta == NULL) return 1;
+
+	uint32_t header[6];
+	fseek(f_meta, 0l, SEEK_SET);
+	size_t r = fread(header, sizeof(uint32_t), 6, f_meta);
+	if (r < 4 || header[0] != NYBLOG_BIN_MAGIC || header[2] > NYBLOG_META_VERSION) return 2;
+
+	if (header[2] < 2 || !(header[3] & NYBLOG_META_FLAG_SPARSE)) return 0;
+	if (image == NULL) return 3;
+	if (r < 6 || !(header[3] & NYBLOG_META_FLAG_IMAGE_HASH)) return 0;
+
+	uint64_t hash;
+	memcpy(&hash, &header[4], sizeof(uint64_t));
+	return (ANA_Cache_HashBytes(image, NYBLOG_IMAGE_SIZE) == hash) ? 0 : 4;
+}
+
+int NYB_Recon_CheckImageFile(FILE *f_meta, FILE *f_disk) {
+	if (f_meta == NULL) return 1;
+	if (f_disk == NULL) return NYB_Recon_CheckImage(f_meta, NULL);
+
+	uint8_t *image = calloc(NYBLOG_IMAGE_SIZE, sizeof(uint8_t));
+	if (image == NULL) return 5;
+
+	// Shorter images are checked as if they were padded with zeros, like they're imported
+	rewind(f_disk);
+	fread(image, sizeof(uint8_t), NYBLOG_IMAGE_SIZE, f_disk);
+	int err = ferror(f_disk) ? 5 : NYB_Recon_CheckImage(f_meta, image);
+	rewind(f_disk);
+
+	free(image);
+	return err;
+}
+
+int NYB_Recon_Load(NYB_Recon *recon, FILE *f_meta, const uint8_t *image) {
+	TRC_SCOPE("NYB_Recon_Load");
+	if (recon == NULL || f_meta == NULL) return 1;
+
+	NYB_Recon_Init(recon);
+	if (image != NULL && NYB_Recon_CheckImage(f_meta, image) == 4) return 3;
 
-	//	Parse File Header
 	uint32_t header[4];
 	fseek(f_meta, 0l, SEEK_SET);
 	size_t r = fread(header, sizeof(uint32_t), 4, f_meta);
-	if (r < 4 || header[0] != NYBLOG_BIN_MAGIC) {
-		if (g_verbose_log) printf("Warn: No header in metadata file; creating one...\n");
+	if (r < 4 || header[0] != NYBLOG_BIN_MAGIC || header[2] > NYBLOG_META_VERSION) return 2;
 
-		// Create Header
-		header[0] = NYBLOG_BIN_MAGIC;
-		header[1] = 16 * 4;	// Leave a few lines blank just in case
-		header[2] = 0x00000000; // Unused for now
-		header[3] = 0x00000000;
-		fseek(f_meta, 0l, SEEK_SET);
-		fwrite(header, sizeof(uint32_t), 4, f_meta);
+	// Older files are just the blocks, with nothing to count attempts with
+	if (header[2] == 0) {
+		for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) {
+			NYB_DataBlock *block = &recon->blocks[i];
+			if (NYB_Meta_ReadBlock(f_meta, block) != 0) break;
+			if (block->block_status != 0x00) recon->attempts[i] = 1;
+		}
+		return 0;
 	}
 
-	long offs_data = header[1];
+	NYB_MetaRecord records[NYBLOG_SECTOR_COUNT];
+	fseek(f_meta, header[1], SEEK_SET);
+	r = fread(records, sizeof(NYB_MetaRecord), NYBLOG_SECTOR_COUNT, f_meta);
+	if (r != NYBLOG_SECTOR_COUNT) return 2;
 
-	//	Find and read selected block
-	DSK_Position blockpos = { block->track_num, block->sector_index };
-	int block_index = DSK_PositionToIndex(blockpos);
-	if (block_index < 0) {
-		printf("Error: Failed to write block metadata to file; Invalid position [% i/% i]\n", blockpos.track, blockpos.sector);
-		return 2;
+	// The data table is read in order, so this doesn't need to seek around
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) {
+		NYB_MetaRecord record = records[i];
+		NYB_DataBlock *block = &recon->blocks[i];
+		if (record.block_status == 0x00) continue;
+
+		block->block_status = record.block_status;
+		block->err_code = record.err_code;
+		block->checksum = record.checksum;
+		block->parse_error = record.parse_error;
+		recon->attempts[i] = record.attempts;
+
+		if (record.data_index == 0) {
+			if (image != NULL) memcpy(block->data, image + (i * BLOCK_SIZE), BLOCK_SIZE);
+			else block->block_status |= NYBLOG_STATUS_IN_IMAGE;
+			continue;
+		}
+
+		long offs_table = header[1] + NYBLOG_SECTOR_COUNT * sizeof(NYB_MetaRecord);
+		fseek(f_meta, offs_table + (record.data_index - 1) * BLOCK_SIZE, SEEK_SET);
+		if (fread(block->data, sizeof(uint8_t), BLOCK_SIZE, f_meta) != BLOCK_SIZE) return 2;
 	}
 
+	return 0;
+}
+
+int NYB_Recon_AddBlock(NYB_Recon *recon, NYB_DataBlock *block) {
+	if (recon == NULL || block == NULL) return 1;
+
+	int index = DSK_PositionToIndex((DSK_Position){ block->track_num, block->sector_index });
+	if (index < 0) return 2;
+
+	recon->blocks[index] = *block;
+
 	// Make sure type byte is nonzero
-	if (block->block_status == 0x00) block->block_status = 0x01;
-	
-	fseek(f_meta, offs_data + (block_index * sizeof(NYB_DataBlock)), SEEK_SET);
-	fwrite(block, sizeof(NYB_DataBlock), 1, f_meta);
+	if (recon->blocks[index].block_status == 0x00) recon->blocks[index].block_status = 0x01;
+
+	// What was loaded is replaced by this import's count
+	uint32_t bit = 1u << (index % 32);
+	if (!(recon->added[index / 32] & bit)) {
+		recon->added[index / 32] |= bit;
+		recon->attempts[index] = 0;
+	}
+	if (recon->attempts[index] < 0xFF) recon->attempts[index]++;
 
 	return 0;
 }
 
-int NYB_WriteToDiskImage(char *filename, NYB_DataBlock *block_buf, int buf_len, bool ignore_errors) {
-	if (block_buf == NULL) return 1;
+//	Gives a temporary file the permissions of the file it's going to replace, if there is one
+//
+//	Returns 0 on success
+int __keep_mode(int fd, const char *filename) {
+	struct stat st;
+	if (stat(filename, &st) != 0) return 0;
+	return fchmod(fd, st.st_mode & 07777);
+}
 
-	FILE * f_disk;
-	if (FileExists(filename)) f_disk = fopen(filename, "r+b");
-	else f_disk = fopen(filename, "w+b");
-	 
-	if (f_disk == NULL) return 2;
+//	Syncs the directory a file was renamed into, so the rename itself survives a crash
+//
+//	Returns 0 on success
+int __sync_directory(const char *filename) {
+	char dir[4096] = ".";
+	const char *sep = strrchr(filename, '/');
+	if (sep != NULL) {
+		size_t len = (sep == filename) ? 1 : (size_t) (sep - filename);
+		if (len >= sizeof(dir)) return 1;
+		memcpy(dir, filename, len);
+		dir[len] = '\0';
+	}
 
-	for (int i=0; i<buf_len; i++) {
-		NYB_DataBlock block = block_buf[i];
-		uint16_t chk = DSK_Checksum(block.data);
-
-		DSK_Position pos = { block.track_num, block.sector_index };
-		if (g_verbose_log) {
-			printf("  [% 3i/% 3i] ", block.track_num, block.sector_index);
-			if (!ignore_errors) {
-				if (block.err_code != 0) {
-					printf("Skipping due to disk-read error (code %i)\n", block.err_code);
-					continue;
-				}
-				if (block.checksum != chk) {
-					printf("Skipping due to checksum mismatch (0x%04X =/= 0x%04X)\n", block.checksum, chk);
-					continue;
-				}
-				if (!DSK_IsPositionValid(pos)) {
-					printf("Skipping due to invalid block position\n");
-					continue;
-				}
-			} else {
-				printf("Ignoring error...\n");
-			}
-		}
+	int fd = open(dir, O_RDONLY | O_DIRECTORY);
+	if (fd < 0) return 1;
+	int err = fsync(fd);
+	close(fd);
+	return (err != 0);
+}
+
+int NYB_Recon_Save(NYB_Recon *recon, const char *filename, const uint8_t *image) {
+	TRC_SCOPE_DETAIL("NYB_Recon_Save", filename);
+	if (recon == NULL || filename == NULL) return 1;
+
+	char tmp_filename[4096];
+	int n = snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", filename);
+	if (n < 0 || n >= (int) sizeof(tmp_filename)) return 2;
+
+	uint32_t header[16] = {
+		NYBLOG_BIN_MAGIC,
+		sizeof(header),
+		NYBLOG_META_VERSION,
+		0x00000000,
+	};
+	NYB_MetaRecord records[NYBLOG_SECTOR_COUNT];
+	uint16_t num_data = 0;
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) {
+		NYB_DataBlock *block = &recon->blocks[i];
+		records[i] = (NYB_MetaRecord){
+			.block_status = block->block_status & ~NYBLOG_STATUS_IN_IMAGE,
+			.err_code = block->err_code,
+			.checksum = block->checksum,
+			.parse_error = block->parse_error,
+			.attempts = recon->attempts[i],
+			.data_index = 0,
+		};
+		if (block->block_status == 0x00) continue;
+		if (records[i].block_status == 0x00) records[i].block_status = 0x01;
+
+		// Blocks whose data is only known to be in the image stay there
+		bool in_image = block->block_status & NYBLOG_STATUS_IN_IMAGE;
+		if (!in_image && image != NULL) in_image = memcmp(block->data, image + (i * BLOCK_SIZE), BLOCK_SIZE) == 0;
+		if (in_image) header[3] |= NYBLOG_META_FLAG_SPARSE;
+		else records[i].data_index = ++num_data;
+	}
+
+	if (image != NULL) {
+		uint64_t hash = ANA_Cache_HashBytes(image, NYBLOG_IMAGE_SIZE);
+		memcpy(&header[4], &hash, sizeof(uint64_t));
+		header[3] |= NYBLOG_META_FLAG_IMAGE_HASH;
+	}
+
+	FILE *f_meta = fopen(tmp_filename, "wb");
+	if (f_meta == NULL) return 2;
+
+	size_t w = fwrite(header, sizeof(header), 1, f_meta);
+	w += fwrite(records, sizeof(records), 1, f_meta);
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) {
+		if (records[i].data_index == 0) continue;
+		w += fwrite(recon->blocks[i].data, BLOCK_SIZE, 1, f_meta);
+	}
+
+	bool failed = (w != 2 + num_data);
+	if (__keep_mode(fileno(f_meta), filename) != 0) failed = true;
+	if (fflush(f_meta) != 0 || fsync(fileno(f_meta)) != 0) failed = true;
+	if (fclose(f_meta) != 0) failed = true;
+	if (failed || rename(tmp_filename, filename) != 0) {
+		remove(tmp_filename);
+		return 2;
+	}
+
+	return (__sync_directory(filename) != 0) ? 2 : 0;
+}
+
+int NYB_Image_Open(NYB_DiskImage *image, const char *filename) {
+	return NYB_Image_OpenInto(image, filename, NULL, 0);
+}
+
+int NYB_Image_OpenInto(NYB_DiskImage *image, const char *filename, uint8_t *buf, size_t bufsz) {
+	if (image == NULL || filename == NULL) return 1;
+
+	image->filename = filename;
+	image->data = NULL;
+	image->size = NYBLOG_IMAGE_SIZE;
+	image->owns_data = (buf == NULL);
+	image->f_log = NULL;
+
+	int fd = open(filename, O_RDONLY);
+	if (fd < 0 && errno != ENOENT) return 2;
 
-		if (!ignore_errors) {
-			if (block.err_code != 0) continue;
-			if (block.checksum != chk) continue;
-			if (!DSK_IsPositionValid(pos)) continue;
+	// Blocks missing from the log keep whatever the image already had
+	size_t len = 0;
+	if (fd >= 0) {
+		struct stat st;
+		if (fstat(fd, &st) != 0) {
+			close(fd);
+			return 2;
 		}
-		DSK_File_SeekPosition(f_disk, pos);
-		fwrite(block.data, sizeof(uint8_t), BLOCK_SIZE, f_disk);
+		len = st.st_size;
+		if (len > image->size) image->size = len;
+	}
+
+	if (buf != NULL && image->size > bufsz) {
+		if (fd >= 0) close(fd);
+		return 4;
+	}
+	if (buf != NULL) {
+		image->data = buf;
+		memset(buf, 0, image->size);
+	} else {
+		image->data = calloc(image->size, sizeof(uint8_t));
+	}
+	if (image->data == NULL) {
+		if (fd >= 0) close(fd);
+		return 3;
+	}
+	if (fd < 0) return 0;
+
+	size_t done = 0;
+	while (done < len) {
+		ssize_t n = read(fd, image->data + done, len - done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) break;
+		done += n;
+	}
+	close(fd);
+
+	if (done < len) {
+		NYB_Image_Close(image);
+		return 2;
+	}
+
+	return 0;
+}
+
+int NYB_Image_WriteBlock(NYB_DiskImage *image, NYB_DataBlock *block, bool ignore_errors) {
+	if (image == NULL || image->data == NULL || block == NULL) return 1;
+
+	if (__check_block(block, ignore_errors, image->f_log) != 0) return 2;
+
+	int index = DSK_PositionToIndex((DSK_Position){ block->track_num, block->sector_index });
+	memcpy(image->data + (index * BLOCK_SIZE), block->data, BLOCK_SIZE);
 
-		if (g_verbose_log) printf("Written to disk!\n");
+	if (image->f_log != NULL) fprintf(image->f_log, "Written to disk!\n");
+	return 0;
+}
+
+int NYB_Image_Flush(NYB_DiskImage *image) {
+	TRC_SCOPE("NYB_Image_Flush");
+	if (image == NULL || image->data == NULL) return 1;
+
+	char tmp_filename[4096];
+	int len = snprintf(tmp_filename, sizeof(tmp_filename), "%s.tmp", image->filename);
+	if (len < 0 || len >= (int) sizeof(tmp_filename)) return 2;
+
+	int fd = open(tmp_filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) return 2;
+	bool failed = (__keep_mode(fd, image->filename) != 0);
+
+	// Reserve the whole image up front, so it can't run out of space half-way
+	int err = posix_fallocate(fd, 0, image->size);
+	if (err != 0 && err != EOPNOTSUPP && err != EINVAL) failed = true;
+
+	size_t done = 0;
+	while (!failed && done < image->size) {
+		ssize_t n = write(fd, image->data + done, image->size - done);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) failed = true;
+		else done += n;
+	}
+
+	if (!failed && fsync(fd) != 0) failed = true;
+	if (close(fd) != 0) failed = true;
+	if (failed) {
+		unlink(tmp_filename);
+		return 2;
 	}
 
-	// Seek to end of disk to create blank sectors
-	DSK_File_SeekPosition(f_disk, (DSK_Position){ MAX_TRACKS, 16 });
-	fseek(f_disk, 256, SEEK_CUR);
+	if (rename(tmp_filename, image->filename) != 0) {
+		unlink(tmp_filename);
+		return 3;
+	}
 
-	uint8_t lastbyte;
-	int n = fread(&lastbyte, sizeof(uint8_t), 1, f_disk);
-	if (n != 1) lastbyte = 0x00;
-	fseek(f_disk, -1, SEEK_CUR);
-	fwrite(&lastbyte, sizeof(uint8_t), 1, f_disk);
+	return (__sync_directory(image->filename) != 0) ? 3 : 0;
+}
+
+void NYB_Image_Close(NYB_DiskImage *image) {
+	if (image == NULL) return;
+
+	if (image->owns_data) free(image->data);
+	image->data = NULL;
+}
+
+int NYB_WriteToDiskImage(char *filename, NYB_DataBlock *block_buf, int buf_len, bool ignore_errors) {
+	TRC_SCOPE_DETAIL("NYB_WriteToDiskImage", filename);
+	if (block_buf == NULL) return 1;
+
+	NYB_DiskImage image;
+	if (NYB_Image_Open(&image, filename) != 0) return 2;
+
+	for (int i=0; i<buf_len; i++) {
+		NYB_Image_WriteBlock(&image, &block_buf[i], ignore_errors);
+	}
 
-	fclose(f_disk);
+	int err = NYB_Image_Flush(&image);
+	NYB_Image_Close(&image);
+	if (err != 0) return 2;
 
 	return 0;
 }
@@ -0,0 +1,158 @@
+#include "../include/plan.h"
+
+//	Simulated position of the drive
+typedef struct {
+	double time;	// ms since the start of the transfer
+	int track;
+} __drive_state;
+
+
+void __seek_track(__drive_state *drive, PLN_DriveModel model, int track) {
+	if (drive->track == track) return;
+
+	drive->time += abs(track - drive->track) * model.step_ms + model.settle_ms;
+	drive->track = track;
+}
+
+//	How long until the start of a sector passes under the head
+double __wait_for_sector(__drive_state *drive, PLN_DriveModel model, DSK_Position pos) {
+	double slot = model.rotation_ms / DSK_Track_GetSectorCount(pos.track);
+	double angle = fmod(drive->time, model.rotation_ms);
+
+	double wait = pos.sector * slot - angle;
+	if (wait < 0.0) wait += model.rotation_ms;
+	return wait;
+}
+
+//	Reads a sector and sends it over the link, returns the time the read started
+double __read_sector(__drive_state *drive, PLN_DriveModel model, DSK_Position pos) {
+	__seek_track(drive, model, pos.track);
+	drive->time += __wait_for_sector(drive, model, pos);
+
+	double start = drive->time;
+	drive->time += model.rotation_ms / DSK_Track_GetSectorCount(pos.track);
+	drive->time += model.link_ms;
+	return start;
+}
+
+//	Adds all the planned sectors of a track, always picking whichever comes up next
+void __plan_track(__drive_state *drive, PLN_DriveModel model, ANA_DiskInfo *analysis, int track, PLN_Plan *plan) {
+	int sc = DSK_Track_GetSectorCount(track);
+	bool pending[21];
+	int num_pending = 0;
+	for (int s=0; s<sc; s++) {
+		int index = DSK_PositionToIndex((DSK_Position){ track, s });
+		pending[s] = PLN_NeedsRetransfer(analysis->sectors[index]);
+		if (pending[s]) num_pending++;
+	}
+	if (num_pending == 0) return;
+
+	__seek_track(drive, model, track);
+	while (num_pending > 0) {
+		int next = -1;
+		double next_wait = 0.0;
+		for (int s=0; s<sc; s++) {
+			if (!pending[s]) continue;
+
+			double wait = __wait_for_sector(drive, model, (DSK_Position){ track, s });
+			if (next >= 0 && wait >= next_wait) continue;
+			next = s;
+			next_wait = wait;
+		}
+
+		DSK_Position pos = { track, next };
+		ANA_Status status = analysis->sectors[DSK_PositionToIndex(pos)].status;
+		plan->entries[plan->num_entries++] = (PLN_Entry){
+			.pos = pos,
+			.status = status,
+			.start_ms = __read_sector(drive, model, pos),
+		};
+
+		if (status == SECSTAT_MISSING) plan->count_missing++;
+		if (status == SECSTAT_CORRUPTED) plan->count_corrupted++;
+		if (status == SECSTAT_BAD) plan->count_bad++;
+
+		pending[next] = false;
+		num_pending--;
+	}
+}
+
+bool PLN_NeedsRetransfer(ANA_SectorInfo info) {
+	return info.status == SECSTAT_MISSING
+		|| info.status == SECSTAT_CORRUPTED
+		|| info.status == SECSTAT_BAD;
+}
+
+int PLN_CreatePlan(ANA_DiskInfo *analysis, PLN_DriveModel model, PLN_Plan *plan) {
+	if (analysis == NULL || plan == NULL) return 1;
+
+	plan->num_entries = 0;
+	plan->count_missing = 0;
+	plan->count_corrupted = 0;
+	plan->count_bad = 0;
+	plan->total_ms = 0.0;
+	plan->full_dump_ms = PLN_EstimateFullDump(model);
+
+	// Find the range of tracks that have to be visited
+	int lo = MAX_TRACKS + 1;
+	int hi = MIN_TRACKS - 1;
+	for (int i=0; i<MAX_ANALYSIS_ENTRIES; i++) {
+		if (!PLN_NeedsRetransfer(analysis->sectors[i])) continue;
+
+		int t = analysis->sectors[i].pos.track;
+		if (t < lo) lo = t;
+		if (t > hi) hi = t;
+	}
+	if (hi < lo) return 0;
+
+	// Sweep to the nearer end first, then across to the other one
+	__drive_state drive = { 0.0, model.start_track };
+	int start = model.start_track;
+	if (start - lo <= hi - start) {
+		for (int t=(start < hi ? start : hi); t>=lo; t--) __plan_track(&drive, model, analysis, t, plan);
+		for (int t=start+1; t<=hi; t++) __plan_track(&drive, model, analysis, t, plan);
+	} else {
+		for (int t=(start > lo ? start : lo); t<=hi; t++) __plan_track(&drive, model, analysis, t, plan);
+		for (int t=start-1; t>=lo; t--) __plan_track(&drive, model, analysis, t, plan);
+	}
+
+	plan->total_ms = drive.time;
+	return 0;
+}
+
+double PLN_EstimateFullDump(PLN_DriveModel model) {
+	__drive_state drive = { 0.0, model.start_track };
+
+	for (int t=MIN_TRACKS; t<=MAX_TRACKS; t++) {
+		int sc = DSK_Track_GetSectorCount(t);
+		for (int s=0; s<sc; s++) __read_sector(&drive, model, (DSK_Position){ t, s });
+	}
+
+	return drive.time;
+}
+
+int PLN_WritePlan(FILE *f_plan, PLN_Plan *plan, const char *disk_filename) {
+	if (f_plan == NULL || plan == NULL) return 1;
+
+	double pc = 0.0;
+	if (plan->full_dump_ms > 0.0) pc = 100.0 * plan->total_ms / plan->full_dump_ms;
+
+	fprintf(f_plan, "# Re-transfer plan for \"%s\"\n#\n", (disk_filename == NULL) ? "" : disk_filename);
+	fprintf(f_plan, "# Sectors to re-read: %i (%i missing, %i corrupted, %i bad)\n",
+		plan->num_entries, plan->count_missing, plan->count_corrupted, plan->count_bad
+	);
+	fprintf(f_plan, "# Estimated time: %.1f s\n", plan->total_ms / 1000.0);
+	fprintf(f_plan, "# Full re-transfer: %.1f s (this plan takes %.1f%% of that)\n#\n",
+		plan->full_dump_ms / 1000.0, pc
+	);
+	fprintf(f_plan, "# Track Sector     Start  Reason\n");
+
+	for (int i=0; i<plan->num_entries; i++) {
+		PLN_Entry e = plan->entries[i];
+		fprintf(f_plan, "  % 5i % 6i % 8.1fs  %s\n",
+			e.pos.track, e.pos.sector, e.start_ms / 1000.0, ANA_GetStatusName(e.status)
+		);
+	}
+
+	return 0;
+}
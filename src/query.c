@@ -0,0 +1,218 @@
+#include "../include/query.h"
+
+//	Where the parser is in an expression
+typedef struct {
+	const char *str;
+	int pos;
+	QRY_Query *query;
+	int err;
+	int err_pos;
+} __query_parser;
+
+int __query_parse_or(__query_parser *parser);
+
+
+void __query_skip_spaces(__query_parser *parser) {
+	while (isspace((unsigned char) parser->str[parser->pos])) parser->pos++;
+}
+
+void __query_fail(__query_parser *parser, int err, int pos) {
+	if (parser->err != 0) return;
+	parser->err = err;
+	parser->err_pos = pos;
+}
+
+void __query_emit(__query_parser *parser, QRY_OpType type, int arg) {
+	if (parser->query->num_ops >= QRY_MAX_OPS) {
+		__query_fail(parser, 4, parser->pos);
+		return;
+	}
+	parser->query->ops[parser->query->num_ops++] = (QRY_Op){ .type = type, .arg = arg };
+}
+
+//	Accepts an operator; "&" & "|" can be doubled as well ("&&")
+bool __query_accept(__query_parser *parser, char c) {
+	__query_skip_spaces(parser);
+	if (parser->str[parser->pos] != c) return false;
+
+	parser->pos++;
+	if ((c == '&' || c == '|') && parser->str[parser->pos] == c) parser->pos++;
+	return true;
+}
+
+//	Reads a name & the number after it, if it has one
+int __query_parse_name(__query_parser *parser) {
+	__query_skip_spaces(parser);
+	int start = parser->pos;
+	char name[32];
+	int len = 0;
+	while (true) {
+		char c = parser->str[parser->pos];
+		if (!isalnum((unsigned char) c) && c != '_' && c != ':') break;
+		if (len < (int) sizeof(name) - 1) name[len++] = tolower((unsigned char) c);
+		parser->pos++;
+	}
+	name[len] = '\0';
+	if (len == 0) {
+		__query_fail(parser, 2, start);
+		return parser->err;
+	}
+
+	for (ANA_Attribute a=0; a<NUM_ANAATTRS; a++) {
+		if (strcmp(name, ANA_GetAttributeName(a)) != 0) continue;
+		__query_emit(parser, QRYOP_ATTRIBUTE, a);
+		return parser->err;
+	}
+
+	// Numbered names; files by their directory entry & tracks from 1 - 35
+	char *end;
+	if (strncmp(name, "file:", 5) == 0) {
+		long entry = strtol(name + 5, &end, 10);
+		if (end != name + 5 && *end == '\0' && entry >= 0 && entry < MAX_DIR_ENTRIES) {
+			__query_emit(parser, QRYOP_FILE, entry);
+			return parser->err;
+		}
+	}
+	if (strncmp(name, "track:", 6) == 0) {
+		long track = strtol(name + 6, &end, 10);
+		if (end != name + 6 && *end == '\0' && track >= MIN_TRACKS && track <= MAX_TRACKS) {
+			__query_emit(parser, QRYOP_TRACK, track);
+			return parser->err;
+		}
+	}
+
+	__query_fail(parser, 3, start);
+	return parser->err;
+}
+
+int __query_parse_not(__query_parser *parser) {
+	if (__query_accept(parser, '!')) {
+		__query_parse_not(parser);
+		__query_emit(parser, QRYOP_NOT, 0);
+		return parser->err;
+	}
+
+	if (__query_accept(parser, '(')) {
+		__query_parse_or(parser);
+		__query_skip_spaces(parser);
+		if (parser->str[parser->pos] != ')') __query_fail(parser, 2, parser->pos);
+		else parser->pos++;
+		return parser->err;
+	}
+
+	return __query_parse_name(parser);
+}
+
+int __query_parse_and(__query_parser *parser) {
+	__query_parse_not(parser);
+	while (parser->err == 0 && __query_accept(parser, '&')) {
+		__query_parse_not(parser);
+		__query_emit(parser, QRYOP_AND, 0);
+	}
+	return parser->err;
+}
+
+int __query_parse_or(__query_parser *parser) {
+	__query_parse_and(parser);
+	while (parser->err == 0 && __query_accept(parser, '|')) {
+		__query_parse_and(parser);
+		__query_emit(parser, QRYOP_OR, 0);
+	}
+	return parser->err;
+}
+
+int QRY_Parse(const char *str, QRY_Query *query, int *err_pos) {
+	if (str == NULL || query == NULL) return 1;
+
+	memset(query, 0, sizeof(QRY_Query));
+	if (strlen(str) >= QRY_MAX_TEXT) return 4;
+	strcpy(query->text, str);
+
+	__query_parser parser = {
+		.str = str,
+		.query = query,
+	};
+	__query_parse_or(&parser);
+
+	// Anything left over is an operand without an operator
+	__query_skip_spaces(&parser);
+	if (parser.err == 0 && str[parser.pos] != '\0') __query_fail(&parser, 2, parser.pos);
+
+	if (err_pos != NULL) *err_pos = parser.err_pos;
+	if (parser.err != 0) query->num_ops = 0;
+	return parser.err;
+}
+
+int QRY_Evaluate(const QRY_Query *query, const ANA_DiskInfo *analysis, ANA_Bitset *result) {
+	if (query == NULL || analysis == NULL || result == NULL) return 1;
+
+	// Bits past the last sector stay clear, even through a NOT
+	const uint32_t last_mask = (MAX_ANALYSIS_ENTRIES % 32 == 0) ? ~0u : (1u << (MAX_ANALYSIS_ENTRIES % 32)) - 1;
+
+	ANA_Bitset stack[QRY_MAX_OPS];
+	int depth = 0;
+	for (int i=0; i<query->num_ops; i++) {
+		QRY_Op op = query->ops[i];
+		switch (op.type) {
+			case QRYOP_ATTRIBUTE: {
+				if (op.arg >= NUM_ANAATTRS) return 2;
+				stack[depth++] = analysis->attributes[op.arg];
+			} break;
+
+			case QRYOP_FILE: {
+				if (op.arg >= MAX_DIR_ENTRIES) return 2;
+				stack[depth++] = analysis->files[op.arg];
+			} break;
+
+			// A track's sectors are a run of indices, which may straddle a word
+			case QRYOP_TRACK: {
+				int first = DSK_PositionToIndex((DSK_Position){ op.arg, 0 });
+				if (first < 0) return 2;
+				int last = first + DSK_Track_GetSectorCount(op.arg) - 1;
+
+				ANA_Bitset *set = &stack[depth++];
+				memset(set, 0, sizeof(ANA_Bitset));
+				for (int w=first/32; w<=last/32; w++) {
+					uint32_t mask = ~0u;
+					if (w == first / 32) mask &= ~0u << (first % 32);
+					if (w == last / 32) mask &= ~0u >> (31 - last % 32);
+					set->words[w] = mask;
+				}
+			} break;
+
+			case QRYOP_NOT: {
+				if (depth < 1) return 2;
+				ANA_Bitset *set = &stack[depth - 1];
+				for (int w=0; w<ANA_BITSET_WORDS; w++) set->words[w] = ~set->words[w];
+				set->words[ANA_BITSET_WORDS - 1] &= last_mask;
+			} break;
+
+			case QRYOP_AND:
+			case QRYOP_OR: {
+				if (depth < 2) return 2;
+				ANA_Bitset *a = &stack[depth - 2];
+				const ANA_Bitset *b = &stack[depth - 1];
+				if (op.type == QRYOP_AND) for (int w=0; w<ANA_BITSET_WORDS; w++) a->words[w] &= b->words[w];
+				else for (int w=0; w<ANA_BITSET_WORDS; w++) a->words[w] |= b->words[w];
+				depth--;
+			} break;
+
+			default: return 2;
+		}
+	}
+	if (depth != 1) return 2;
+
+	*result = stack[0];
+	return 0;
+}
+
+const char *QRY_GetErrorName(int err_code) {
+	switch (err_code) {
+		case 0: return "OK";
+		case 1: return "Invalid arguments";
+		case 2: return "Syntax error";
+		case 3: return "Unknown name";
+		case 4: return "Expression is too long";
+	}
+	return "Unknown error";
+}
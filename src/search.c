@@ -0,0 +1,358 @@
+#include "../include/search.h"
+#include "../include/diff.h"
+#include "../include/arena.h"
+#include "../include/trace.h"
+#include <ctype.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#define __BYTES_01 0x0101010101010101ULL
+#define __BYTES_80 0x8080808080808080ULL
+
+//	Everything a worker needs for one image, taken afresh from its arena for every image
+#define __SEARCH_ARENA_SIZE (ARN_SIZE(NYBLOG_IMAGE_SIZE) + ARN_SIZE(sizeof(DSK_Directory)) + ARN_SIZE(sizeof(SCH_Result)))
+
+//	One disk image of SCH_SearchImages, with what was found in it
+typedef struct {
+	const char *filename;
+	int err;
+	int num_hits;
+	char *report;		// Written through a memory stream, so threads don't mix their reports
+	size_t report_size;
+} __search_job;
+
+typedef struct {
+	__search_job *jobs;
+	int num_jobs;
+	int next_job;
+	const SCH_Pattern *pattern;
+	pthread_mutex_t lock;
+} __search_queue;
+
+
+int __hex_digit(char c) {
+	if (c >= '0' && c <= '9') return c - '0';
+	if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+	if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+	return -1;
+}
+
+//	Finds the first byte that's `value` once ANDed with `mask`, 8 bytes at a
+//	time; memchr can't mask, and letters of either case need to be
+const uint8_t *__find_masked(const uint8_t *data, size_t len, uint8_t value, uint8_t mask) {
+	const uint64_t values = __BYTES_01 * value;
+	const uint64_t masks = __BYTES_01 * mask;
+
+	size_t i = 0;
+	for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+		uint64_t x;
+		memcpy(&x, data + i, sizeof(uint64_t));
+
+		// Bytes that match are 0x00 now; the lowest one flagged is always a real match
+		x = (x & masks) ^ values;
+		uint64_t zeroes = (x - __BYTES_01) & ~x & __BYTES_80;
+		if (zeroes != 0) return data + i + __builtin_ctzll(zeroes) / 8;
+	}
+	for (; i < len; i++) {
+		if ((data[i] & mask) == value) return data + i;
+	}
+
+	return NULL;
+}
+
+bool __matches_at(const uint8_t *data, const SCH_Pattern *pattern) {
+	for (int i=0; i<pattern->len; i++) {
+		if ((data[i] & pattern->mask[i]) != pattern->value[i]) return false;
+	}
+	return true;
+}
+
+void __add_hit(SCH_Result *result, DSK_Position pos, int offset, DSK_Position end_pos, int dir_index) {
+	int index = DSK_PositionToIndex(pos);
+	int end_index = DSK_PositionToIndex(end_pos);
+	result->hit_sectors[index / 32] |= 1u << (index % 32);
+	result->hit_sectors[end_index / 32] |= 1u << (end_index % 32);
+
+	if (result->num_hits < SCH_MAX_HITS) {
+		result->hits[result->num_hits] = (SCH_Hit){
+			.pos = pos,
+			.offset = offset,
+			.end_pos = end_pos,
+			.dir_index = dir_index,
+		};
+	}
+	result->num_hits++;
+}
+
+int __compare_hits(const void *a, const void *b) {
+	const SCH_Hit *hit_a = a;
+	const SCH_Hit *hit_b = b;
+	int index_a = DSK_PositionToIndex(hit_a->pos);
+	int index_b = DSK_PositionToIndex(hit_b->pos);
+	if (index_a != index_b) return index_a - index_b;
+	return hit_a->offset - hit_b->offset;
+}
+
+//	Follows every file's chain, noting which file each block belongs to and
+//	looking for matches that carry on from one block's data into the next
+void __search_chains(const uint8_t *image, const DSK_Directory *dir, const SCH_Pattern *pattern, int16_t owners[NYBLOG_SECTOR_COUNT], SCH_Result *result) {
+	const int data_size = BLOCK_SIZE - 2;
+	const int overlap = pattern->len - 1;
+
+	for (int e=0; e<dir->num_entries; e++) {
+		DSK_DirEntry entry = dir->entries[e];
+		if (entry.type != SECTYPE_SEQ && entry.type != SECTYPE_PRG && entry.type != SECTYPE_USR && entry.type != SECTYPE_REL) continue;
+
+		uint32_t visited[SCH_BITSET_WORDS];
+		memset(visited, 0, sizeof(visited));
+
+		DSK_Position pos = entry.head_pos;
+		while (DSK_IsPositionValid(pos)) {
+			int index = DSK_PositionToIndex(pos);
+			if (visited[index / 32] & (1u << (index % 32))) break;
+			visited[index / 32] |= 1u << (index % 32);
+			if (owners[index] < 0) owners[index] = e;
+
+			const uint8_t *block = image + (size_t) index * BLOCK_SIZE;
+			DSK_Position next = { block[0], block[1] };
+			if (overlap == 0 || !DSK_IsPositionValid(next)) {
+				pos = next;
+				continue;
+			}
+
+			// The end of this block's data followed by the start of the next one's;
+			// the last block of a file only has its used bytes
+			const uint8_t *next_block = image + (size_t) DSK_PositionToIndex(next) * BLOCK_SIZE;
+			int next_size = data_size;
+			if (next_block[0] == 0x00) next_size = (next_block[1] >= 2) ? next_block[1] - 1 : 0;
+			if (next_size > overlap) next_size = overlap;
+
+			uint8_t seam[SCH_MAX_PATTERN * 2];
+			memcpy(seam, block + BLOCK_SIZE - overlap, overlap);
+			memcpy(seam + overlap, next_block + 2, next_size);
+
+			// Only matches that start in this block & end in the next one
+			for (int s=0; s<overlap && s + pattern->len <= overlap + next_size; s++) {
+				if (__matches_at(seam + s, pattern)) __add_hit(result, pos, BLOCK_SIZE - overlap + s, next, e);
+			}
+
+			pos = next;
+		}
+	}
+}
+
+int SCH_ParsePattern(const char *str, bool is_hex, SCH_Pattern *pattern) {
+	if (str == NULL || pattern == NULL) return 1;
+
+	memset(pattern, 0, sizeof(SCH_Pattern));
+	bool has_fixed = false;
+
+	if (is_hex) {
+		for (int i=0; str[i] != '\0'; i++) {
+			if (isspace((unsigned char) str[i])) continue;
+			if (str[i+1] == '\0') return 4;
+			if (pattern->len >= SCH_MAX_PATTERN) return 3;
+
+			if (str[i] == '?' && str[i+1] == '?') {
+				pattern->mask[pattern->len] = 0x00;
+				pattern->value[pattern->len] = 0x00;
+			} else {
+				int hi = __hex_digit(str[i]);
+				int lo = __hex_digit(str[i+1]);
+				if (hi < 0 || lo < 0) return 4;
+				pattern->mask[pattern->len] = 0xFF;
+				pattern->value[pattern->len] = (hi << 4) | lo;
+				has_fixed = true;
+			}
+			pattern->len++;
+			i++;
+		}
+	} else {
+		for (int i=0; str[i] != '\0'; i++) {
+			if (pattern->len >= SCH_MAX_PATTERN) return 3;
+
+			// PETSCII letters are 0x41 - 0x5A in either character set and the
+			// other case is 0xC1 - 0xDA (or 0x61 - 0x7A in ASCII text), so bits
+			// 5 & 7 are left out
+			unsigned char c = str[i];
+			if (isalpha(c)) {
+				pattern->mask[pattern->len] = 0x5F;
+				pattern->value[pattern->len] = toupper(c) & 0x5F;
+			} else {
+				pattern->mask[pattern->len] = 0xFF;
+				pattern->value[pattern->len] = c;
+			}
+			pattern->len++;
+			has_fixed = true;
+		}
+	}
+
+	if (pattern->len == 0 || !has_fixed) return 2;
+	return 0;
+}
+
+int SCH_SearchImage(const uint8_t *image, const DSK_Directory *dir, const SCH_Pattern *pattern, SCH_Result *result) {
+	TRC_SCOPE("SCH_SearchImage");
+	if (image == NULL || pattern == NULL || result == NULL) return 1;
+
+	memset(result, 0, sizeof(SCH_Result));
+	if (pattern->len <= 0 || pattern->len > SCH_MAX_PATTERN) return 0;
+
+	int16_t owners[NYBLOG_SECTOR_COUNT];
+	for (int i=0; i<NYBLOG_SECTOR_COUNT; i++) owners[i] = -1;
+	if (dir != NULL) __search_chains(image, dir, pattern, owners, result);
+
+	// The whole image is scanned in one go, skipping ahead to where one byte
+	// of the pattern matches; memchr does that a vector at a time for a byte
+	// that has to match exactly, so one of those is preferred
+	int anchor = -1;
+	for (int i=0; i<pattern->len && anchor < 0; i++) {
+		if (pattern->mask[i] == 0xFF) anchor = i;
+	}
+	for (int i=0; i<pattern->len && anchor < 0; i++) {
+		if (pattern->mask[i] != 0x00) anchor = i;
+	}
+
+	const size_t last_start = NYBLOG_IMAGE_SIZE - pattern->len;
+	size_t start = 0;
+	while (start <= last_start) {
+		if (anchor >= 0) {
+			const uint8_t *found = (pattern->mask[anchor] == 0xFF)
+				? memchr(image + start + anchor, pattern->value[anchor], last_start - start + 1)
+				: __find_masked(image + start + anchor, last_start - start + 1, pattern->value[anchor], pattern->mask[anchor]);
+			if (found == NULL) break;
+			start = (found - image) - anchor;
+		}
+
+		// Matches running from one block into whatever happens to follow it aren't real
+		size_t end = start + pattern->len - 1;
+		if (start / BLOCK_SIZE == end / BLOCK_SIZE && __matches_at(image + start, pattern)) {
+			int index = start / BLOCK_SIZE;
+			DSK_Position pos = DSK_IndexToPosition(index);
+			__add_hit(result, pos, start % BLOCK_SIZE, pos, owners[index]);
+		}
+		start++;
+	}
+
+	int num_stored = (result->num_hits < SCH_MAX_HITS) ? result->num_hits : SCH_MAX_HITS;
+	qsort(result->hits, num_stored, sizeof(SCH_Hit), __compare_hits);
+
+	return 0;
+}
+
+bool SCH_IsHit(const SCH_Result *result, int index) {
+	if (result == NULL || index < 0 || index >= NYBLOG_SECTOR_COUNT) return false;
+	return (result->hit_sectors[index / 32] >> (index % 32)) & 1;
+}
+
+void SCH_WriteHits(FILE *f_report, const char *filename, const DSK_Directory *dir, const SCH_Result *result) {
+	if (f_report == NULL || result == NULL) return;
+
+	int num_stored = (result->num_hits < SCH_MAX_HITS) ? result->num_hits : SCH_MAX_HITS;
+	for (int i=0; i<num_stored; i++) {
+		SCH_Hit hit = result->hits[i];
+		if (filename != NULL) fprintf(f_report, "%s: ", filename);
+		fprintf(f_report, "[% 3i/% 3i] 0x%02X", hit.pos.track, hit.pos.sector, hit.offset);
+		if (!DSK_PositionsEqual(hit.pos, hit.end_pos)) fprintf(f_report, " -> [% 3i/% 3i]", hit.end_pos.track, hit.end_pos.sector);
+		if (dir != NULL && hit.dir_index >= 0 && hit.dir_index < dir->num_entries) fprintf(f_report, " \"%s\"", dir->entries[hit.dir_index].filename);
+		fprintf(f_report, "\n");
+	}
+	if (result->num_hits > num_stored) {
+		if (filename != NULL) fprintf(f_report, "%s: ", filename);
+		fprintf(f_report, "... and %i more hits\n", result->num_hits - num_stored);
+	}
+}
+
+void __search_image(__search_job *job, const SCH_Pattern *pattern, ARN_Arena *arena) {
+	ARN_Reset(arena);
+	uint8_t *image = ARN_Alloc(arena, NYBLOG_IMAGE_SIZE);
+	DSK_Directory *dir = ARN_Alloc(arena, sizeof(DSK_Directory));
+	SCH_Result *result = ARN_Alloc(arena, sizeof(SCH_Result));
+
+	// An image without a readable directory is still searched, only not across blocks
+	int err = (image != NULL && dir != NULL && result != NULL) ? DIF_LoadImage(job->filename, image, dir) : 2;
+	if (err != 0 && err != 3) {
+		job->err = 2;
+		return;
+	}
+
+	SCH_SearchImage(image, (err == 0) ? dir : NULL, pattern, result);
+	job->num_hits = result->num_hits;
+	if (result->num_hits == 0) return;
+
+	FILE *f_report = open_memstream(&job->report, &job->report_size);
+	if (f_report == NULL) return;
+	SCH_WriteHits(f_report, job->filename, (err == 0) ? dir : NULL, result);
+	fclose(f_report);
+}
+
+void *__search_images(void *arg) {
+	__search_queue *queue = arg;
+
+	// Allocated once per worker, however many images it gets through
+	ARN_Arena arena;
+	ARN_Init(&arena, __SEARCH_ARENA_SIZE);
+
+	while (true) {
+		pthread_mutex_lock(&queue->lock);
+		int i = queue->next_job++;
+		pthread_mutex_unlock(&queue->lock);
+		if (i >= queue->num_jobs) break;
+
+		__search_image(&queue->jobs[i], queue->pattern, &arena);
+	}
+
+	ARN_Free(&arena);
+	return NULL;
+}
+
+int SCH_SearchImages(char **filenames, int num_images, const SCH_Pattern *pattern, int num_threads, FILE *f_report, SCH_Stats *stats) {
+	if (filenames == NULL || pattern == NULL || stats == NULL) return 1;
+
+	memset(stats, 0, sizeof(SCH_Stats));
+
+	__search_job *jobs = calloc(num_images, sizeof(__search_job));
+	if (jobs == NULL) return 1;
+	for (int i=0; i<num_images; i++) jobs[i].filename = filenames[i];
+
+	if (num_threads <= 0) num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+	if (num_threads > SCH_MAX_THREADS) num_threads = SCH_MAX_THREADS;
+	if (num_threads > num_images) num_threads = num_images;
+	if (num_threads < 1) num_threads = 1;
+
+	__search_queue queue = {
+		.jobs = jobs,
+		.num_jobs = num_images,
+		.pattern = pattern,
+	};
+	pthread_mutex_init(&queue.lock, NULL);
+
+	// Whatever threads can't be started, the calling one makes up for
+	pthread_t threads[SCH_MAX_THREADS];
+	int num_started = 0;
+	while (num_started < num_threads - 1) {
+		if (pthread_create(&threads[num_started], NULL, __search_images, &queue) != 0) break;
+		num_started++;
+	}
+	__search_images(&queue);
+	for (int i=0; i<num_started; i++) pthread_join(threads[i], NULL);
+	pthread_mutex_destroy(&queue.lock);
+
+	int err = 0;
+	for (int i=0; i<num_images; i++) {
+		__search_job *job = &jobs[i];
+		if (f_report != NULL && job->err != 0) fprintf(f_report, "%s: Failed to read the image\n", job->filename);
+		if (f_report != NULL && job->report_size > 0) fwrite(job->report, sizeof(char), job->report_size, f_report);
+		free(job->report);
+
+		if (job->err != 0) {
+			stats->images_failed++;
+			err = 2;
+		}
+		if (job->num_hits > 0) stats->images_matched++;
+		stats->hits += job->num_hits;
+	}
+	free(jobs);
+
+	return err;
+}
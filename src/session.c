@@ -0,0 +1,432 @@
+#include "../include/session.h"
+#include "../include/cache.h"
+#include "../include/hexdump.h"
+#include "../include/bam.h"
+#include "../include/trace.h"
+#include <unistd.h>
+
+//	Where the blocks of a log are written to while importing it
+typedef struct {
+	SES_Session *session;
+	NYB_DiskImage image;
+	NYB_Recon *recon;
+	NYB_Journal journal;
+	int skip;			// Blocks already recovered from the journal of an interrupted import
+	bool journal_failed;
+} __import_target;
+
+int __apply_import_block(NYB_DataBlock *block, void *user_data);
+
+
+bool __is_cancelled(SES_Session *session) {
+	pthread_mutex_lock(&session->lock);
+	bool cancelled = session->cancel_requested;
+	pthread_mutex_unlock(&session->lock);
+	return cancelled;
+}
+
+//	Moves the session on; the import takes up the first half of the progress bar if there is one
+void __set_stage(SES_Session *session, SES_Stage stage, ANA_Pass pass, int blocks_imported) {
+	float base = (session->options.import_filename != NULL) ? 0.5f : 0.0f;
+	float progress = 0.0f;
+	switch (stage) {
+		case SESSTAGE_IDLE: break;
+		case SESSTAGE_IMPORT: {
+			progress = (float) blocks_imported / NYBLOG_SECTOR_COUNT;
+			if (progress > 1.0f) progress = 1.0f;
+			progress *= base;
+		} break;
+		case SESSTAGE_DIRECTORY: progress = base; break;
+		case SESSTAGE_ANALYSIS: progress = base + (1.0f - base) * pass / NUM_ANAPASSES; break;
+		case SESSTAGE_DONE: progress = 1.0f; break;
+		case SESSTAGE_FAILED:
+		case SESSTAGE_CANCELLED: {
+			pthread_mutex_lock(&session->lock);
+			session->progress.stage = stage;
+			pthread_mutex_unlock(&session->lock);
+		} return;
+	}
+
+	pthread_mutex_lock(&session->lock);
+	session->progress.stage = stage;
+	session->progress.pass = pass;
+	if (stage == SESSTAGE_IMPORT) session->progress.blocks_imported = blocks_imported;
+	session->progress.progress = progress;
+	pthread_mutex_unlock(&session->lock);
+}
+
+int __fail(SES_Session *session, int err, int detail) {
+	pthread_mutex_lock(&session->lock);
+	session->progress.err = err;
+	session->progress.err_detail = detail;
+	pthread_mutex_unlock(&session->lock);
+	__set_stage(session, SESSTAGE_FAILED, 0, 0);
+	return err;
+}
+
+//	Copies what the worker has so far to where SES_Poll can get it
+void __publish(SES_Session *session) {
+	if (!session->is_threaded) return;
+
+	pthread_mutex_lock(&session->lock);
+	*session->snapshot_dir = *session->dir;
+	*session->snapshot = *session->analysis;
+	session->generation++;
+	pthread_mutex_unlock(&session->lock);
+}
+
+int __import_block(NYB_DataBlock *block, void *user_data) {
+	__import_target *target = user_data;
+
+	if (target->skip > 0) {
+		target->skip--;
+		return 0;
+	}
+	if (__is_cancelled(target->session)) return 1;
+
+	if (NYB_Journal_Append(&target->journal, block) != 0) {
+		target->journal_failed = true;
+		return 1;
+	}
+
+	return __apply_import_block(block, user_data);
+}
+
+void __log_import_info(const char *message, void *user_data) {
+	__import_target *target = user_data;
+	fprintf(target->session->options.f_log, " - Info Message in log file: %s\n", message);
+}
+
+void __log_hexdump_info(const char *message, void *user_data) {
+	__import_target *target = user_data;
+	fprintf(target->session->options.f_log, " - %s\n", message);
+}
+
+int __apply_import_block(NYB_DataBlock *block, void *user_data) {
+	__import_target *target = user_data;
+
+	NYB_Image_WriteBlock(&target->image, block, target->session->options.ignore_image_write);
+	if (target->recon != NULL) NYB_Recon_AddBlock(target->recon, block);
+
+	pthread_mutex_lock(&target->session->lock);
+	int blocks_imported = target->session->progress.blocks_imported + 1;
+	pthread_mutex_unlock(&target->session->lock);
+	__set_stage(target->session, SESSTAGE_IMPORT, 0, blocks_imported);
+	return 0;
+}
+
+int __import(SES_Session *session) {
+	SES_Options options = session->options;
+	if (access(options.import_filename, R_OK) != 0) return __fail(session, 2, 0);
+
+	// The image is built in memory and written out once the whole log is read;
+	// only an image with extra bytes past the error info is too big for the arena
+	__import_target target = { .session = session, .recon = NULL };
+	int err = NYB_Image_OpenInto(&target.image, options.disk_filename, session->image, SES_IMAGE_SIZE);
+	if (err == 4) err = NYB_Image_Open(&target.image, options.disk_filename);
+	if (err != 0) return __fail(session, 3, 0);
+	target.image.f_log = options.f_log;
+
+	// Transfer info is collected the same way, starting from what's already there
+	if (options.recon_filename != NULL) {
+		target.recon = session->recon;
+		NYB_Recon_Init(target.recon);
+
+		FILE *f_meta = fopen(options.recon_filename, "rb");
+		if (f_meta != NULL) {
+			err = NYB_Recon_Load(target.recon, f_meta, target.image.data);
+			fclose(f_meta);
+			if (err == 3) {
+				NYB_Image_Close(&target.image);
+				return __fail(session, 14, 0);
+			}
+			if (err != 0) NYB_Recon_Init(target.recon);
+		}
+	}
+
+	// Everything is journaled until the image & recon file are written,
+	// so an interrupted import can carry on where it stopped
+	if (NYB_Journal_Open(&target.journal, options.disk_filename, options.import_filename, __apply_import_block, &target) != 0) {
+		NYB_Image_Close(&target.image);
+		return __fail(session, 4, 0);
+	}
+	target.skip = target.journal.num_replayed;
+	if (options.f_log != NULL) {
+		if (target.journal.was_discarded) fprintf(options.f_log, "Warn: Discarding journal '%s' of a different import\n", target.journal.filename);
+		if (target.journal.num_replayed > 0) fprintf(options.f_log, "Resuming interrupted import; recovered %i blocks from '%s'\n", target.journal.num_replayed, target.journal.filename);
+	}
+
+	// Hex dumps are decoded straight into blocks, without going through a text-log
+	int blocks_read = options.import_is_hexdump
+		? HEX_ParseHexDump(options.import_filename, __import_block, options.f_log != NULL ? __log_hexdump_info : NULL, &target)
+		: NYB_ParseLogParallel(options.import_filename, 0, __import_block, options.f_log != NULL ? __log_import_info : NULL, &target);
+
+	// A cancelled import leaves its journal behind to carry on from
+	err = 0;
+	if (blocks_read < 0) err = 2;
+	else if (target.journal_failed) err = 5;
+	else if (__is_cancelled(session)) err = 13;
+
+	if (err == 0 && NYB_Image_Flush(&target.image) != 0) err = 6;
+
+	// Only sectors that didn't make it into the image need their data in the recon file
+	if (err == 0 && target.recon != NULL) {
+		if (NYB_Recon_Save(target.recon, options.recon_filename, target.image.data) != 0) err = 7;
+	}
+	NYB_Image_Close(&target.image);
+	NYB_Journal_Close(&target.journal, err == 0);
+
+	if (err == 13) {
+		__set_stage(session, SESSTAGE_CANCELLED, 0, 0);
+		return err;
+	}
+	if (err != 0) return __fail(session, err, 0);
+
+	if (options.f_log != NULL) fprintf(options.f_log, "Imported %i blocks from '%s'\n", blocks_read, options.import_filename);
+	return 0;
+}
+
+int __analyse(SES_Session *session, FILE *f_disk, FILE *f_meta) {
+	SES_Options options = session->options;
+	ANA_DiskInfo *analysis = session->analysis;
+
+	int err = DSK_File_ParseDirectory(f_disk, session->dir, options.ignore_invalid_bam);
+	if (err != 0) return __fail(session, 10, err);
+
+	// An invalid BAM is rebuilt from the file chains; the image buffer is free once importing is done
+	if (options.ignore_invalid_bam) {
+		uint8_t *image = session->image;
+		rewind(f_disk);
+		size_t num_read = fread(image, BLOCK_SIZE, NYBLOG_SECTOR_COUNT, f_disk);
+		memset(image + num_read * BLOCK_SIZE, 0, (NYBLOG_SECTOR_COUNT - num_read) * BLOCK_SIZE);
+
+		BAM_Report report;
+		BAM_Verify(image, &report);
+		if (!report.is_header_valid) {
+			BAM_Pack(report.used, session->dir->bam);
+			if (options.f_log != NULL) fprintf(options.f_log, "Rebuilt the invalid BAM from the file chains\n");
+		}
+	}
+
+	if (options.f_log != NULL) {
+		DSK_PrintBAM(options.f_log, session->dir->bam);
+		DSK_PrintDirectory(options.f_log, *session->dir);
+		fflush(options.f_log);
+	}
+
+	// Perform Disk Analysis, unless an unchanged result is already cached
+	ANA_CacheKey cache_key;
+	char cache_path[CACHE_PATH_SIZE];
+	bool cache_hit = false;
+	bool use_cache = options.use_cache;
+	if (use_cache) {
+		uint32_t cache_flags = options.ignore_invalid_bam ? CACHE_FLAG_IGNORE_BAM : 0;
+		ANA_Cache_GetKey(f_disk, f_meta, cache_flags, &cache_key);
+		err = ANA_Cache_GetPath(options.disk_filename, cache_key, cache_path, CACHE_PATH_SIZE);
+		use_cache = (err == 0);
+		if (use_cache) {
+			err = ANA_Cache_Load(cache_path, cache_key, analysis);
+			cache_hit = (err == 0);
+			if (options.f_log != NULL) fprintf(options.f_log, "\nAnalysis cache %s: %s\n", cache_hit ? "hit" : "miss", cache_path);
+		}
+	}
+	if (cache_hit) return 0;
+
+	// Every pass is published as it finishes, starting with what the BAM says;
+	// the stats are gathered each time so partial results can be shown as well
+	for (ANA_Pass pass=0; pass<NUM_ANAPASSES; pass++) {
+		if (__is_cancelled(session)) {
+			__set_stage(session, SESSTAGE_CANCELLED, 0, 0);
+			return 13;
+		}
+		__set_stage(session, SESSTAGE_ANALYSIS, pass, 0);
+
+		err = ANA_AnalysePass(f_disk, f_meta, *session->dir, analysis, pass);
+		if (err != 0) return __fail(session, 11, err);
+		if (pass < NUM_ANAPASSES - 1 && session->is_threaded) {
+			ANA_GatherStats(analysis);
+			__publish(session);
+		}
+	}
+	err = ANA_GatherStats(analysis);
+	if (err != 0) return __fail(session, 12, err);
+
+	if (use_cache) {
+		err = ANA_Cache_Save(cache_path, cache_key, analysis);
+		if (err != 0 && options.f_log != NULL) fprintf(options.f_log, "Warn: Failed to write analysis cache '%s'\n", cache_path);
+	}
+
+	return 0;
+}
+
+//	Takes everything a disk needs from the session's arena
+void __carve(SES_Session *session) {
+	ARN_Arena *arena = &session->arena;
+	ARN_Reset(arena);
+
+	// SES_ARENA_SIZE covers all of these, so none of them can fail
+	session->dir = ARN_Calloc(arena, sizeof(DSK_Directory));
+	session->analysis = ARN_Calloc(arena, sizeof(ANA_DiskInfo));
+	session->snapshot_dir = ARN_Calloc(arena, sizeof(DSK_Directory));
+	session->snapshot = ARN_Calloc(arena, sizeof(ANA_DiskInfo));
+	session->view_dir = ARN_Calloc(arena, sizeof(DSK_Directory));
+	session->view = ARN_Calloc(arena, sizeof(ANA_DiskInfo));
+	session->recon = ARN_Alloc(arena, sizeof(NYB_Recon));
+	session->image = ARN_Alloc(arena, SES_IMAGE_SIZE);
+}
+
+int SES_Init(SES_Session *session, SES_Options options) {
+	if (session == NULL) return 1;
+
+	memset(session, 0, sizeof(SES_Session));
+	session->options = options;
+	if (ARN_Init(&session->arena, SES_ARENA_SIZE) != 0) return 2;
+	__carve(session);
+	pthread_mutex_init(&session->lock, NULL);
+
+	return 0;
+}
+
+int SES_Reset(SES_Session *session, SES_Options options) {
+	if (session == NULL) return 1;
+
+	SES_Cancel(session);
+	SES_Finish(session);
+
+	session->options = options;
+	__carve(session);
+	session->cancel_requested = false;
+	session->progress = (SES_Progress){ .stage = SESSTAGE_IDLE };
+	session->generation = 0;
+
+	return 0;
+}
+
+int SES_Load(SES_Session *session) {
+	TRC_SCOPE_DETAIL("SES_Load", session != NULL ? session->options.disk_filename : NULL);
+	if (session == NULL || session->options.disk_filename == NULL) return 1;
+	SES_Options options = session->options;
+
+	// Read log file or hex dump if specified
+	if (options.import_filename != NULL) {
+		__set_stage(session, SESSTAGE_IMPORT, 0, 0);
+		int err = __import(session);
+		if (err != 0) return err;
+	}
+	__set_stage(session, SESSTAGE_DIRECTORY, 0, 0);
+
+	// Read the disk file
+	FILE *f_disk = fopen(options.disk_filename, "rb");
+	if (f_disk == NULL) return __fail(session, 8, 0);
+
+	// Read the meta file
+	FILE *f_meta = NULL;
+	if (options.recon_filename != NULL) {
+		f_meta = fopen(options.recon_filename, "rb");
+		if (f_meta == NULL) {
+			fclose(f_disk);
+			return __fail(session, 9, 0);
+		}
+
+		// A sparse recon file's good sectors would be read from the wrong image
+		if (NYB_Recon_CheckImageFile(f_meta, f_disk) == 4) {
+			fclose(f_meta);
+			fclose(f_disk);
+			return __fail(session, 14, 0);
+		}
+	}
+
+	int err = __analyse(session, f_disk, f_meta);
+	if (f_meta != NULL) fclose(f_meta);
+	fclose(f_disk);
+	if (err != 0) return err;
+
+	ANA_DiskInfo *analysis = session->analysis;
+	if (options.f_log != NULL) fprintf(options.f_log, "\nDisk Statistics:\n - Blocks in use: %i\n -     Completed: %i\n -       Missing: %i\n -   With Issues: %i\n",
+		analysis->count_in_use, analysis->count_healthy, analysis->count_missing, analysis->count_bad
+	);
+
+	__publish(session);
+	__set_stage(session, SESSTAGE_DONE, 0, 0);
+	return 0;
+}
+
+void *__load(void *arg) {
+	TRC_SetThreadName("session");
+	SES_Load(arg);
+	return NULL;
+}
+
+int SES_Start(SES_Session *session) {
+	if (session == NULL) return 1;
+
+	session->is_threaded = true;
+	if (pthread_create(&session->thread, NULL, __load, session) != 0) {
+		session->is_threaded = false;
+		return 2;
+	}
+
+	return 0;
+}
+
+bool SES_Poll(SES_Session *session, int *generation, SES_Progress *progress) {
+	if (session == NULL || generation == NULL) return false;
+
+	pthread_mutex_lock(&session->lock);
+	bool is_newer = session->generation > *generation;
+	if (is_newer) {
+		*session->view_dir = *session->snapshot_dir;
+		*session->view = *session->snapshot;
+		*generation = session->generation;
+	}
+	if (progress != NULL) *progress = session->progress;
+	pthread_mutex_unlock(&session->lock);
+
+	return is_newer;
+}
+
+void SES_Cancel(SES_Session *session) {
+	if (session == NULL) return;
+
+	pthread_mutex_lock(&session->lock);
+	session->cancel_requested = true;
+	pthread_mutex_unlock(&session->lock);
+}
+
+int SES_Finish(SES_Session *session) {
+	if (session == NULL) return 1;
+
+	if (session->is_threaded) {
+		pthread_join(session->thread, NULL);
+		session->is_threaded = false;
+	}
+
+	pthread_mutex_lock(&session->lock);
+	int err = session->progress.err;
+	if (session->progress.stage == SESSTAGE_CANCELLED) err = 13;
+	pthread_mutex_unlock(&session->lock);
+
+	return err;
+}
+
+void SES_Close(SES_Session *session) {
+	if (session == NULL) return;
+
+	SES_Cancel(session);
+	SES_Finish(session);
+	pthread_mutex_destroy(&session->lock);
+	ARN_Free(&session->arena);
+}
+
+const char *SES_GetStageName(SES_Stage stage) {
+	switch (stage) {
+		case SESSTAGE_IDLE: return "Waiting";
+		case SESSTAGE_IMPORT: return "Importing the log";
+		case SESSTAGE_DIRECTORY: return "Reading the directory";
+		case SESSTAGE_ANALYSIS: return "Analysing the disk";
+		case SESSTAGE_DONE: return "Done";
+		case SESSTAGE_FAILED: return "Failed";
+		case SESSTAGE_CANCELLED: return "Cancelled";
+	}
+	return "";
+}
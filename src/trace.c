@@ -0,0 +1,180 @@
+#include "../include/trace.h"
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+
+//	A span that's ended, or a thread's name if `dur_us` is negative
+typedef struct {
+	const char *name;
+	char detail[TRC_DETAIL_SIZE];
+	double start_us;
+	double dur_us;
+	int tid;
+} __trace_event;
+
+static volatile bool __is_recording = false;
+static FILE *__f_trace = NULL;
+static __trace_event *__events = NULL;
+static int __num_events = 0;
+static int __max_events = 0;
+static int __num_dropped = 0;
+static int __next_tid = 1;
+static pthread_mutex_t __lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Small ids in the order threads first record something; easier to read than the kernel's
+static __thread int __tid = 0;
+
+
+double __trace_now_us() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+//	Adds an event; the lock has to be held
+void __trace_add(const char *name, const char *detail, double start_us, double dur_us) {
+	if (__tid == 0) __tid = __next_tid++;
+
+	// Room is made as it's needed, up to TRC_MAX_EVENTS
+	if (__num_events >= __max_events) {
+		int max_events = (__max_events > 0) ? __max_events * 2 : 0x1000;
+		if (max_events > TRC_MAX_EVENTS) max_events = TRC_MAX_EVENTS;
+		__trace_event *events = (max_events > __max_events) ? realloc(__events, sizeof(__trace_event) * max_events) : NULL;
+		if (events == NULL) {
+			__num_dropped++;
+			return;
+		}
+		__events = events;
+		__max_events = max_events;
+	}
+
+	__trace_event *event = &__events[__num_events++];
+	event->name = name;
+	event->detail[0] = '\0';
+	if (detail != NULL) snprintf(event->detail, TRC_DETAIL_SIZE, "%s", detail);
+	event->start_us = start_us;
+	event->dur_us = dur_us;
+	event->tid = __tid;
+}
+
+void __trace_write_string(FILE *f_trace, const char *str, int len) {
+	fputc('"', f_trace);
+	for (int i=0; i<len && str[i] != '\0'; i++) {
+		unsigned char c = str[i];
+		if (c == '"' || c == '\\') fputc('\\', f_trace);
+		if (c < 0x20) continue;
+		fputc(c, f_trace);
+	}
+	fputc('"', f_trace);
+}
+
+void __trace_exit() {
+	TRC_Close();
+}
+
+int TRC_Open(const char *filename) {
+	if (filename == NULL) return 1;
+
+#ifndef DISEKT_TRACE
+	return 3;
+#else
+	pthread_mutex_lock(&__lock);
+	bool is_open = (__f_trace != NULL);
+	pthread_mutex_unlock(&__lock);
+	if (is_open) TRC_Close();
+
+	FILE *f_trace = fopen(filename, "w");
+	if (f_trace == NULL) return 2;
+
+	static bool is_registered = false;
+	if (!is_registered) is_registered = (atexit(__trace_exit) == 0);
+
+	pthread_mutex_lock(&__lock);
+	__f_trace = f_trace;
+	__events = NULL;
+	__num_events = 0;
+	__max_events = 0;
+	__num_dropped = 0;
+	__is_recording = true;
+	pthread_mutex_unlock(&__lock);
+
+	TRC_SetThreadName("main");
+	return 0;
+#endif
+}
+
+int TRC_Close() {
+	pthread_mutex_lock(&__lock);
+	FILE *f_trace = __f_trace;
+	__trace_event *events = __events;
+	int num_events = __num_events;
+	int num_dropped = __num_dropped;
+	__is_recording = false;
+	__f_trace = NULL;
+	__events = NULL;
+	__max_events = 0;
+	pthread_mutex_unlock(&__lock);
+	if (f_trace == NULL) return 0;
+
+	// Chrome's trace-event format; a complete ("X") event per span
+	int pid = getpid();
+	fprintf(f_trace, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (int i=0; i<num_events; i++) {
+		__trace_event *event = &events[i];
+		if (i > 0) fprintf(f_trace, ",\n");
+
+		if (event->dur_us < 0.0) {
+			fprintf(f_trace, "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": %i, \"tid\": %i, \"args\": {\"name\": ", pid, event->tid);
+			__trace_write_string(f_trace, event->detail, TRC_DETAIL_SIZE);
+			fprintf(f_trace, "}}");
+			continue;
+		}
+
+		const char *category = strchr(event->name, '_');
+		int category_len = (category != NULL) ? category - event->name : (int) strlen(event->name);
+		fprintf(f_trace, "{\"name\": ");
+		__trace_write_string(f_trace, event->name, TRC_NAME_SIZE);
+		fprintf(f_trace, ", \"cat\": ");
+		__trace_write_string(f_trace, event->name, category_len);
+		fprintf(f_trace, ", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": %i, \"tid\": %i",
+			event->start_us, event->dur_us, pid, event->tid
+		);
+		if (event->detail[0] != '\0') {
+			fprintf(f_trace, ", \"args\": {\"detail\": ");
+			__trace_write_string(f_trace, event->detail, TRC_DETAIL_SIZE);
+			fprintf(f_trace, "}");
+		}
+		fprintf(f_trace, "}");
+	}
+	fprintf(f_trace, "\n], \"otherData\": {\"dropped_events\": %i}}\n", num_dropped);
+
+	free(events);
+	if (fclose(f_trace) != 0) return 2;
+	return 0;
+}
+
+void TRC_SetThreadName(const char *name) {
+	if (!__is_recording || name == NULL) return;
+
+	pthread_mutex_lock(&__lock);
+	if (__is_recording) __trace_add("thread_name", name, 0.0, -1.0);
+	pthread_mutex_unlock(&__lock);
+}
+
+TRC_Span TRC_BeginSpan(const char *name, const char *detail) {
+	if (!__is_recording) return (TRC_Span){ .name = NULL };
+	return (TRC_Span){
+		.name = name,
+		.detail = detail,
+		.start_us = __trace_now_us(),
+	};
+}
+
+void TRC_EndSpan(TRC_Span *span) {
+	if (span->name == NULL || !__is_recording) return;
+
+	double end_us = __trace_now_us();
+	pthread_mutex_lock(&__lock);
+	if (__is_recording) __trace_add(span->name, span->detail, span->start_us, end_us - span->start_us);
+	pthread_mutex_unlock(&__lock);
+}